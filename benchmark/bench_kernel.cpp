@@ -0,0 +1,149 @@
+// Copyright 2024 quocdang1998
+#include <algorithm>  // std::fill
+#include <cstdint>    // std::int64_t, std::uint64_t
+#include <cstdio>     // std::printf
+#include <cstdlib>    // std::atoi
+#include <iostream>   // std::cout, std::clog
+#include <random>     // std::mt19937_64, std::uniform_real_distribution
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "readmpo/nd_array.hpp"   // readmpo::NdArray
+#include "readmpo/xs_kernel.hpp"  // readmpo::OverwritePolicy, readmpo::XsKernel, readmpo::select_xs_kernel
+
+#include "bench_utils.hpp"  // readmpo::best_time
+
+const char * help_message = R"(Benchmark the kernels writing cross sections of a zone to the output.
+Options:
+    -h, --help: Print help message.
+    -g, --groups: Number of energy groups. Default: 281.
+    -z, --zones: Number of zones (stride between 2 groups in the output). Default: 20.
+    -c, --calls: Number of kernel calls per repetition. Default: 100000.
+    -n, --repeat: Number of repetitions (best time is reported). Default: 5.
+Result:
+    Wall time per group for each type of cross section, with the former loop (branch on the type and overwrite check
+    for each group, output indexed by a vector) and the kernels specialized for the type, with and without overwrite
+    check.
+)";
+
+using readmpo::NdArray;
+using readmpo::best_time;
+using readmpo::OverwritePolicy;
+using readmpo::XsKernel;
+using readmpo::XsType;
+
+// Former loop: branch on the type and check for overwrite for each group, output indexed by a vector
+void get_xs_legacy(std::uint64_t ngroups, std::vector<std::uint64_t> & output_index, std::int64_t address_xs,
+                   NdArray & output_data, XsType type, const std::vector<float> & cross_sections,
+                   const std::vector<float> & zoneflux, double iso_conc) {
+    for (std::uint64_t i_group = 0; i_group < ngroups; i_group++) {
+        output_index[0] = i_group;
+        if (output_data[output_index] != 0.0) {
+            std::clog << "Overwrite at index " << output_index[0] << "\n";
+        }
+        switch (type) {
+            case XsType::Micro : {
+                output_data[output_index] = cross_sections[address_xs + i_group];
+                break;
+            }
+            case XsType::Macro : {
+                output_data[output_index] = iso_conc * cross_sections[address_xs + i_group];
+                break;
+            }
+            case XsType::Flux : {
+                output_data[output_index] = zoneflux[i_group];
+                break;
+            }
+            case XsType::ReactRate : {
+                output_data[output_index] = zoneflux[i_group] * iso_conc * cross_sections[address_xs + i_group];
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char * argv[]) {
+    // parse argument
+    std::uint64_t n_groups = 281, n_zones = 20, n_calls = 100000;
+    int n_repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-g") || !argument.compare("--groups")) {
+            n_groups = std::atoi(argv[++i]);
+        } else if (!argument.compare("-z") || !argument.compare("--zones")) {
+            n_zones = std::atoi(argv[++i]);
+        } else if (!argument.compare("-c") || !argument.compare("--calls")) {
+            n_calls = std::atoi(argv[++i]);
+        } else if (!argument.compare("-n") || !argument.compare("--repeat")) {
+            n_repeat = std::atoi(argv[++i]);
+        } else {
+            throw std::runtime_error("Unknown option " + argument + ". Execute \"bench_kernel --help\".\n");
+        }
+    }
+    if (n_groups == 0 || n_zones == 0) {
+        throw std::runtime_error("Number of groups and number of zones must be positive.\n");
+    }
+    // generate cross sections and flux of a zone
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<float> distribution(0.1f, 10.0f);
+    std::vector<float> cross_sections(4 * n_groups), zoneflux(n_groups);
+    for (float & x : cross_sections) {
+        x = distribution(generator);
+    }
+    for (float & x : zoneflux) {
+        x = distribution(generator);
+    }
+    std::int64_t address_xs = n_groups;
+    double iso_conc = 0.02;
+    // output of shape [group, zone], each call writes the next zone, and the output is reset once all zones are
+    // written, as each element is written once in the library
+    std::vector<double> legacy_data(n_groups * n_zones), kernel_data(n_groups * n_zones);
+    NdArray legacy_output(legacy_data.data(), {n_groups, n_zones}, {n_zones * sizeof(double), sizeof(double)});
+    std::vector<std::uint64_t> output_index = {0, 0};
+    // time each type of cross section
+    const char * type_names[] = {"micro", "macro", "flux", "reactrate"};
+    std::printf("%10s %14s %14s %14s %10s\n", "type", "former (ns)", "ignore (ns)", "warn (ns)", "speedup");
+    for (unsigned int i_type = 0; i_type < 4; i_type++) {
+        XsType type = static_cast<XsType>(i_type);
+        XsKernel ignore_kernel = readmpo::select_xs_kernel(type, OverwritePolicy::Ignore);
+        XsKernel warn_kernel = readmpo::select_xs_kernel(type, OverwritePolicy::Warn);
+        double t_legacy = best_time(n_repeat, [&]() {
+            std::fill(legacy_data.begin(), legacy_data.end(), 0.0);
+            for (std::uint64_t i_call = 0; i_call < n_calls; i_call++) {
+                output_index[1] = i_call % n_zones;
+                if (i_call != 0 && output_index[1] == 0) {
+                    std::fill(legacy_data.begin(), legacy_data.end(), 0.0);
+                }
+                get_xs_legacy(n_groups, output_index, address_xs, legacy_output, type, cross_sections, zoneflux,
+                              iso_conc);
+            }
+        });
+        auto run_kernel = [&](XsKernel kernel) {
+            std::uint64_t n_overwritten = 0;
+            std::fill(kernel_data.begin(), kernel_data.end(), 0.0);
+            for (std::uint64_t i_call = 0; i_call < n_calls; i_call++) {
+                std::uint64_t i_zone = i_call % n_zones;
+                if (i_call != 0 && i_zone == 0) {
+                    std::fill(kernel_data.begin(), kernel_data.end(), 0.0);
+                }
+                n_overwritten += kernel(n_groups, cross_sections.data(), address_xs, zoneflux.data(), iso_conc,
+                                        kernel_data.data() + i_zone, n_zones);
+            }
+            return n_overwritten;
+        };
+        std::uint64_t n_overwritten = 0;
+        double t_ignore = best_time(n_repeat, [&]() { run_kernel(ignore_kernel); });
+        double t_warn = best_time(n_repeat, [&]() { n_overwritten += run_kernel(warn_kernel); });
+        if ((legacy_data != kernel_data) || (n_overwritten != 0)) {
+            throw std::runtime_error("Former loop and kernel give different results.\n");
+        }
+        double scale = 1e9 / (n_calls * n_groups);
+        std::printf("%10s %14.3f %14.3f %14.3f %10.2f\n", type_names[i_type], t_legacy * scale, t_ignore * scale,
+                    t_warn * scale, t_legacy / t_warn);
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Copyright 2024 quocdang1998
+#include <algorithm>  // std::find_if, std::sort, std::unique
+#include <cinttypes>  // PRIu64
+#include <cstdint>    // std::uint64_t
+#include <cstdio>     // std::printf
+#include <cstdlib>    // std::atoi
+#include <iostream>   // std::cout
+#include <random>     // std::mt19937_64, std::uniform_int_distribution
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "readmpo/h5_utils.hpp"  // readmpo::find_near, readmpo::is_near, readmpo::sort_unique_near
+
+#include "bench_utils.hpp"  // readmpo::best_time
+
+using readmpo::best_time;
+
+const char * help_message = R"(Benchmark the merge of parameter spaces of MPO files at the construction of a master MPO.
+Options:
+    -h, --help: Print help message.
+    -f, --files: Max number of files. Default: 5000.
+    -p, --params: Number of parameters in each file. Default: 3.
+    -v, --values: Number of values of each parameter in each file. Default: 50.
+    -a, --axis: Number of distinct values of each parameter across all files. Default: 5000.
+    -n, --repeat: Number of repetitions for each file count (best time is reported). Default: 1.
+Result:
+    Wall time of merging parameter values into the master parameter space and of mapping the values of each file to
+    their global index for 500, 1000, 2000, ... files, with the former algorithm (re-sort after each file, linear
+    search) and the current one (sort once, binary search).
+)";
+
+// Parameter values of each file, values are saved as float in MPO files
+using FilePspace = std::vector<std::vector<double>>;
+
+// Generate sorted values of each parameter of each file from a common axis
+std::vector<FilePspace> generate_pspaces(std::uint64_t n_files, std::uint64_t n_params, std::uint64_t n_values,
+                                         std::uint64_t axis_size) {
+    std::mt19937_64 generator(0);
+    std::uniform_int_distribution<std::uint64_t> start_dist(0, axis_size - n_values);
+    std::vector<FilePspace> pspaces(n_files, FilePspace(n_params));
+    for (FilePspace & pspace : pspaces) {
+        for (std::vector<double> & values : pspace) {
+            std::uint64_t start = start_dist(generator);
+            for (std::uint64_t i = start; i < start + n_values; i++) {
+                values.push_back(static_cast<float>(0.1 * i));
+            }
+        }
+    }
+    return pspaces;
+}
+
+// Former merge: append values of each file, then sort and remove close values
+FilePspace merge_legacy(const std::vector<FilePspace> & pspaces, std::uint64_t n_params) {
+    FilePspace master(n_params);
+    for (const FilePspace & pspace : pspaces) {
+        for (std::uint64_t i_param = 0; i_param < n_params; i_param++) {
+            master[i_param].insert(master[i_param].end(), pspace[i_param].begin(), pspace[i_param].end());
+            std::sort(master[i_param].begin(), master[i_param].end());
+            auto last = std::unique(master[i_param].begin(), master[i_param].end(), readmpo::is_near);
+            master[i_param].erase(last, master[i_param].end());
+        }
+    }
+    return master;
+}
+
+// Current merge: gather values of all files, then sort once
+FilePspace merge_sort_once(const std::vector<FilePspace> & pspaces, std::uint64_t n_params) {
+    FilePspace master(n_params);
+    for (const FilePspace & pspace : pspaces) {
+        for (std::uint64_t i_param = 0; i_param < n_params; i_param++) {
+            master[i_param].insert(master[i_param].end(), pspace[i_param].begin(), pspace[i_param].end());
+        }
+    }
+    for (std::vector<double> & values : master) {
+        readmpo::sort_unique_near(values);
+    }
+    return master;
+}
+
+// Map values of each file to their global index by linear search
+std::uint64_t map_linear(const std::vector<FilePspace> & pspaces, const FilePspace & master) {
+    std::uint64_t checksum = 0;
+    for (const FilePspace & pspace : pspaces) {
+        for (std::uint64_t i_param = 0; i_param < master.size(); i_param++) {
+            for (const double & value : pspace[i_param]) {
+                auto it = std::find_if(master[i_param].begin(), master[i_param].end(),
+                                       [&value](const double & x) { return readmpo::is_near(x, value); });
+                checksum += it - master[i_param].begin();
+            }
+        }
+    }
+    return checksum;
+}
+
+// Map values of each file to their global index by binary search
+std::uint64_t map_binary(const std::vector<FilePspace> & pspaces, const FilePspace & master) {
+    std::uint64_t checksum = 0;
+    for (const FilePspace & pspace : pspaces) {
+        for (std::uint64_t i_param = 0; i_param < master.size(); i_param++) {
+            for (const double & value : pspace[i_param]) {
+                checksum += readmpo::find_near(master[i_param], value);
+            }
+        }
+    }
+    return checksum;
+}
+
+// Check the merge and the mapping on a chain of close values: a ~ b and b ~ c, but a !~ c
+void check_chained_tolerance(void) {
+    const double a = 1.0, b = 1.00001, c = 1.00002;
+    if (!readmpo::is_near(a, b) || !readmpo::is_near(b, c) || readmpo::is_near(a, c)) {
+        throw std::runtime_error("Values of the chain must be close to their neighbors only.\n");
+    }
+    // the current merge keeps a and c regardless of the order of files, and maps b to a
+    FilePspace master = merge_sort_once({{{b, c}}, {{a}}}, 1);
+    if ((master[0] != std::vector<double>{a, c}) || (readmpo::find_near(master[0], b) != 0) ||
+        (readmpo::find_near(master[0], c) != 1)) {
+        throw std::runtime_error("Unexpected merge of a chain of close values.\n");
+    }
+    // the former merge depends on the order of files: b absorbs c in the first file, then a absorbs b, and c is lost
+    if ((merge_legacy({{{b, c}}, {{a}}}, 1)[0] != std::vector<double>{a}) ||
+        (merge_legacy({{{a}}, {{b, c}}}, 1)[0] != std::vector<double>{a, c})) {
+        throw std::runtime_error("Unexpected former merge of a chain of close values.\n");
+    }
+}
+
+int main(int argc, char * argv[]) {
+    // parse argument
+    std::uint64_t max_files = 5000, n_params = 3, n_values = 50, axis_size = 5000;
+    int n_repeat = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-f") || !argument.compare("--files")) {
+            max_files = std::atoi(argv[++i]);
+        } else if (!argument.compare("-p") || !argument.compare("--params")) {
+            n_params = std::atoi(argv[++i]);
+        } else if (!argument.compare("-v") || !argument.compare("--values")) {
+            n_values = std::atoi(argv[++i]);
+        } else if (!argument.compare("-a") || !argument.compare("--axis")) {
+            axis_size = std::atoi(argv[++i]);
+        } else if (!argument.compare("-n") || !argument.compare("--repeat")) {
+            n_repeat = std::atoi(argv[++i]);
+        } else {
+            throw std::runtime_error("Unknown option " + argument + ". Execute \"bench_pspace --help\".\n");
+        }
+    }
+    if (n_values > axis_size) {
+        throw std::runtime_error("Number of values per file must not exceed the size of the axis.\n");
+    }
+    check_chained_tolerance();
+    // time merge and mapping for each number of files
+    std::printf("%8s %14s %14s %14s %14s %12s\n", "files", "merge old (s)", "merge new (s)", "map old (s)",
+                "map new (s)", "new/file (us)");
+    for (std::uint64_t n_files = 500; n_files <= max_files; n_files = (n_files == 500) ? 1000 : n_files + 1000) {
+        std::vector<FilePspace> pspaces = generate_pspaces(n_files, n_params, n_values, axis_size);
+        FilePspace master_legacy, master;
+        double t_merge_legacy = best_time(n_repeat, [&]() { master_legacy = merge_legacy(pspaces, n_params); });
+        double t_merge = best_time(n_repeat, [&]() { master = merge_sort_once(pspaces, n_params); });
+        std::uint64_t checksum_linear = 0, checksum_binary = 0;
+        double t_map_linear = best_time(n_repeat, [&]() { checksum_linear = map_linear(pspaces, master_legacy); });
+        double t_map_binary = best_time(n_repeat, [&]() { checksum_binary = map_binary(pspaces, master); });
+        if ((master != master_legacy) || (checksum_linear != checksum_binary)) {
+            throw std::runtime_error("Former and current algorithms give different results.\n");
+        }
+        std::printf("%8" PRIu64 " %14.4f %14.4f %14.4f %14.4f %12.3f\n", n_files, t_merge_legacy, t_merge,
+                    t_map_linear, t_map_binary, 1e6 * (t_merge + t_map_binary) / n_files);
+    }
+    return 0;
+}
@@ -0,0 +1,268 @@
+// Copyright 2024 quocdang1998
+#include <cstdint>        // std::uint32_t, std::uint64_t
+#include <cstdio>         // std::printf, std::remove
+#include <cstdlib>        // std::atoi
+#include <fstream>        // std::ifstream, std::ofstream
+#include <ios>            // std::ios_base
+#include <iostream>       // std::cout
+#include <map>            // std::map
+#include <random>         // std::mt19937_64, std::uniform_real_distribution
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string, std::to_string
+#include <tuple>          // std::apply, std::get, std::tuple
+#include <type_traits>    // std::is_trivially_copyable
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move, std::pair
+#include <vector>         // std::vector
+
+#include "readmpo/file_stream.hpp"  // readmpo::BufferedOfstream, readmpo::MappedBuffer, readmpo::MappedIstream
+#include "readmpo/serializer.hpp"   // readmpo::serialize_obj, readmpo::deserialize_obj
+#include "readmpo/single_mpo.hpp"   // readmpo::ValidSet
+
+#include "bench_utils.hpp"  // readmpo::best_time
+
+using readmpo::best_time;
+
+const char * help_message = R"(Benchmark the serialization of a large master MPO state.
+Options:
+    -h, --help: Print help message.
+    -i, --isotopes: Number of isotopes with a valid set. Default: 2000.
+    -g, --groups: Number of energy groups (valid sets hold about half of the transfer group pairs). Default: 40.
+    -f, --files: Number of MPO files. Default: 1000.
+    -v, --values: Number of values of each of the 4 parameters in each file. Default: 500.
+    -o, --output: Name of the temporary file. Default: bench_serializer.bin.
+    -n, --repeat: Number of repetitions (best time is reported). Default: 3.
+Result:
+    Wall time of writing and reading the state with the former serializer (one stream call per element, default file
+    buffer) and the current one (bulk write of trivially copyable vectors, large output buffer, memory-mapped input).
+)";
+
+using readmpo::ValidSet;
+
+// State of a master MPO: parameter space, valid set of each isotope, and map to global index of each file
+using State = std::tuple<std::map<std::string, std::vector<double>>, std::map<std::string, ValidSet>,
+                         std::vector<std::vector<std::vector<std::uint64_t>>>>;
+
+// Former serializer, calling the stream for each element
+namespace former {
+
+template <class T>
+requires std::is_trivially_copyable<T>::value
+void serialize_obj(std::ostream & os, const T & obj) {
+    os.write(reinterpret_cast<const char *>(&obj), sizeof(T));
+}
+template <class F, class S>
+void serialize_obj(std::ostream & os, const std::pair<F, S> & obj);
+template <typename... Args>
+void serialize_obj(std::ostream & os, const std::tuple<Args...> & obj);
+void serialize_obj(std::ostream & os, const std::string & obj);
+template <class T>
+void serialize_obj(std::ostream & os, const std::vector<T> & obj);
+template <class T>
+void serialize_obj(std::ostream & os, const std::unordered_set<T> & obj);
+template <class K, class T>
+void serialize_obj(std::ostream & os, const std::map<K, T> & obj);
+
+template <class F, class S>
+void serialize_obj(std::ostream & os, const std::pair<F, S> & obj) {
+    serialize_obj(os, obj.first);
+    serialize_obj(os, obj.second);
+}
+template <typename... Args>
+void serialize_obj(std::ostream & os, const std::tuple<Args...> & obj) {
+    std::apply([&os](const auto &... ts) { (..., serialize_obj(os, ts)); }, obj);
+}
+void serialize_obj(std::ostream & os, const std::string & obj) {
+    std::uint32_t size = obj.size();
+    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    os.write(obj.c_str(), size);
+}
+template <class T>
+void serialize_obj(std::ostream & os, const std::vector<T> & obj) {
+    std::uint32_t size = obj.size();
+    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    for (const T & element : obj) {
+        serialize_obj(os, element);
+    }
+}
+template <class T>
+void serialize_obj(std::ostream & os, const std::unordered_set<T> & obj) {
+    std::uint32_t size = obj.size();
+    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    for (const T & element : obj) {
+        serialize_obj(os, element);
+    }
+}
+template <class K, class T>
+void serialize_obj(std::ostream & os, const std::map<K, T> & obj) {
+    std::uint32_t size = obj.size();
+    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    for (const auto & [key, value] : obj) {
+        serialize_obj(os, key);
+        serialize_obj(os, value);
+    }
+}
+
+template <class T>
+requires std::is_trivially_copyable<T>::value
+void deserialize_obj(std::istream & is, T & obj) {
+    is.read(reinterpret_cast<char *>(&obj), sizeof(T));
+}
+template <class F, class S>
+void deserialize_obj(std::istream & is, std::pair<F, S> & obj);
+template <typename... Args>
+void deserialize_obj(std::istream & is, std::tuple<Args...> & obj);
+void deserialize_obj(std::istream & is, std::string & obj);
+template <class T>
+void deserialize_obj(std::istream & is, std::vector<T> & obj);
+template <class T>
+void deserialize_obj(std::istream & is, std::unordered_set<T> & obj);
+template <class K, class T>
+void deserialize_obj(std::istream & is, std::map<K, T> & obj);
+
+template <class F, class S>
+void deserialize_obj(std::istream & is, std::pair<F, S> & obj) {
+    deserialize_obj(is, obj.first);
+    deserialize_obj(is, obj.second);
+}
+template <typename... Args>
+void deserialize_obj(std::istream & is, std::tuple<Args...> & obj) {
+    std::apply([&is](auto &... ts) { (..., deserialize_obj(is, ts)); }, obj);
+}
+void deserialize_obj(std::istream & is, std::string & obj) {
+    std::uint32_t size;
+    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    obj.resize(size);
+    is.read(&(obj[0]), size);
+}
+template <class T>
+void deserialize_obj(std::istream & is, std::vector<T> & obj) {
+    std::uint32_t size;
+    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    obj.resize(size);
+    for (T & element : obj) {
+        deserialize_obj(is, element);
+    }
+}
+template <class T>
+void deserialize_obj(std::istream & is, std::unordered_set<T> & obj) {
+    std::uint32_t size;
+    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    for (std::uint32_t i_elem = 0; i_elem < size; i_elem++) {
+        T element;
+        deserialize_obj(is, element);
+        obj.insert(std::move(element));
+    }
+}
+template <class K, class T>
+void deserialize_obj(std::istream & is, std::map<K, T> & obj) {
+    std::uint32_t size;
+    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    for (std::uint32_t i_elem = 0; i_elem < size; i_elem++) {
+        std::pair<K, T> element;
+        deserialize_obj(is, element.first);
+        deserialize_obj(is, element.second);
+        obj.insert(std::move(element));
+    }
+}
+
+}  // namespace former
+
+// Generate the state of a master MPO
+State generate_state(std::uint64_t n_isotopes, std::uint64_t n_groups, std::uint64_t n_files,
+                     std::uint64_t n_values) {
+    std::mt19937_64 generator(0);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    State state;
+    auto & [pspace, valid_set, global_idx] = state;
+    const char * param_names[] = {"burnup", "tfuel", "tcool", "boron"};
+    for (const char * pname : param_names) {
+        std::vector<double> & values = pspace[pname];
+        for (std::uint64_t i = 0; i < n_files * n_values / 4; i++) {
+            values.push_back(distribution(generator));
+        }
+    }
+    for (std::uint64_t i_iso = 0; i_iso < n_isotopes; i_iso++) {
+        ValidSet & iso_validset = valid_set["ISO" + std::to_string(i_iso)];
+        std::get<0>(iso_validset) = 1 + i_iso % 4;
+        std::get<1>(iso_validset) = 1 + i_iso % 6;
+        for (std::uint64_t departure = 0; departure < n_groups; departure++) {
+            for (std::uint64_t arrival = 0; arrival < n_groups; arrival++) {
+                if (distribution(generator) < 0.5) {
+                    std::get<2>(iso_validset).insert({departure, arrival});
+                }
+            }
+        }
+    }
+    global_idx.resize(n_files, std::vector<std::vector<std::uint64_t>>(4));
+    for (std::vector<std::vector<std::uint64_t>> & file_idx : global_idx) {
+        for (std::vector<std::uint64_t> & dim_idx : file_idx) {
+            for (std::uint64_t i = 0; i < n_values; i++) {
+                dim_idx.push_back(i * 3);
+            }
+        }
+    }
+    return state;
+}
+
+int main(int argc, char * argv[]) {
+    // parse argument
+    std::uint64_t n_isotopes = 2000, n_groups = 40, n_files = 1000, n_values = 500;
+    std::string fname = "bench_serializer.bin";
+    int n_repeat = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-i") || !argument.compare("--isotopes")) {
+            n_isotopes = std::atoi(argv[++i]);
+        } else if (!argument.compare("-g") || !argument.compare("--groups")) {
+            n_groups = std::atoi(argv[++i]);
+        } else if (!argument.compare("-f") || !argument.compare("--files")) {
+            n_files = std::atoi(argv[++i]);
+        } else if (!argument.compare("-v") || !argument.compare("--values")) {
+            n_values = std::atoi(argv[++i]);
+        } else if (!argument.compare("-o") || !argument.compare("--output")) {
+            fname = argv[++i];
+        } else if (!argument.compare("-n") || !argument.compare("--repeat")) {
+            n_repeat = std::atoi(argv[++i]);
+        } else {
+            throw std::runtime_error("Unknown option " + argument + ". Execute \"bench_serializer --help\".\n");
+        }
+    }
+    State state = generate_state(n_isotopes, n_groups, n_files, n_values);
+    // former serializer
+    double t_former_write = best_time(n_repeat, [&]() {
+        std::ofstream out(fname.c_str(), std::ios_base::binary | std::ios_base::trunc);
+        former::serialize_obj(out, state);
+    });
+    State former_state;
+    double t_former_read = best_time(n_repeat, [&]() {
+        former_state = State();
+        std::ifstream in(fname.c_str(), std::ios_base::binary);
+        former::deserialize_obj(in, former_state);
+    });
+    // current serializer
+    double t_write = best_time(n_repeat, [&]() {
+        readmpo::BufferedOfstream out(fname);
+        readmpo::serialize_obj(out, state);
+    });
+    std::uint64_t file_size = readmpo::MappedBuffer(fname).size();
+    State current_state;
+    double t_read = best_time(n_repeat, [&]() {
+        current_state = State();
+        readmpo::MappedIstream in(fname);
+        readmpo::deserialize_obj(in, current_state);
+    });
+    std::remove(fname.c_str());
+    if ((former_state != state) || (current_state != state)) {
+        throw std::runtime_error("Deserialized state differs from the original one.\n");
+    }
+    std::printf("size: %.1f MiB\n", file_size / 1048576.0);
+    std::printf("%10s %14s %14s %10s\n", "operation", "former (ms)", "current (ms)", "speedup");
+    std::printf("%10s %14.2f %14.2f %10.2f\n", "write", t_former_write * 1e3, t_write * 1e3,
+                t_former_write / t_write);
+    std::printf("%10s %14.2f %14.2f %10.2f\n", "read", t_former_read * 1e3, t_read * 1e3, t_former_read / t_read);
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Copyright 2024 quocdang1998
+#include <cinttypes>  // PRIu64
+#include <cstdio>     // std::printf
+#include <cstdlib>    // std::atoi
+#include <iostream>   // std::cout
+#include <stdexcept>  // std::runtime_error
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include <omp.h>  // ::omp_get_max_threads
+
+#include "readmpo/master_mpo.hpp"  // readmpo::MasterMpo
+
+#include "bench_utils.hpp"  // readmpo::best_time
+
+using readmpo::best_time;
+
+const char * help_message = R"(Benchmark statepoint-level parallel extraction on a single MPO file.
+Options:
+    -h, --help: Print help message.
+    -g, --geom: Name of geometry.
+    -e, --emesh: Name of energy mesh.
+    -i, --iso: Name of isotope (multiple calls allowed).
+    -r, --reac: Name of reaction (multiple calls allowed).
+    -xs, --type: Type of cross section (0: micro, 1: macro, 2: zoneflux, 3: reaction rate). Default: 0.
+    -bu, --burnup: Name of burnup parameter. Default: "burnup".
+    -t, --threads: Max number of threads. Default: all available threads.
+    -n, --repeat: Number of repetitions for each thread count (best time is reported). Default: 3.
+Result:
+    Wall time of build_microlib_xs and get_concentration for 1, 2, 4, ... threads, and their speedup.
+)";
+
+int main(int argc, char * argv[]) {
+    using namespace readmpo;
+    // parse argument
+    std::string geometry, energymesh, burnup_name = "burnup";
+    std::vector<std::string> filenames, isotopes, reactions;
+    unsigned int xstype = 0;
+    std::uint64_t max_threads = ::omp_get_max_threads();
+    int n_repeat = 3;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-g") || !argument.compare("--geom")) {
+            geometry = std::string(argv[++i]);
+        } else if (!argument.compare("-e") || !argument.compare("--emesh")) {
+            energymesh = std::string(argv[++i]);
+        } else if (!argument.compare("-i") || !argument.compare("--iso")) {
+            isotopes.push_back(std::string(argv[++i]));
+        } else if (!argument.compare("-r") || !argument.compare("--reac")) {
+            reactions.push_back(std::string(argv[++i]));
+        } else if (!argument.compare("-xs") || !argument.compare("--type")) {
+            xstype = std::atoi(argv[++i]);
+        } else if (!argument.compare("-bu") || !argument.compare("--burnup")) {
+            burnup_name = std::string(argv[++i]);
+        } else if (!argument.compare("-t") || !argument.compare("--threads")) {
+            max_threads = std::atoi(argv[++i]);
+        } else if (!argument.compare("-n") || !argument.compare("--repeat")) {
+            n_repeat = std::atoi(argv[++i]);
+        } else {
+            filenames.push_back(argument);
+        }
+    }
+    if (filenames.size() != 1) {
+        throw std::runtime_error("Expected one MPO file. Execute \"bench_statept --help\" for more information.\n");
+    }
+    // construct master MPO
+    MasterMpo master_mpo(filenames, geometry, energymesh);
+    // time extraction for each number of threads
+    std::vector<std::uint64_t> thread_counts;
+    std::vector<double> t_microlib, t_conc;
+    for (std::uint64_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+        thread_counts.push_back(n_threads);
+        t_microlib.push_back(best_time(n_repeat, [&]() {
+            master_mpo.build_microlib_xs(isotopes, reactions, {}, static_cast<XsType>(xstype), 1, "log.txt",
+                                         n_threads);
+        }));
+        t_conc.push_back(best_time(n_repeat, [&]() {
+            master_mpo.get_concentration(isotopes, burnup_name, n_threads);
+        }));
+    }
+    // print result
+    std::printf("\n%8s %16s %8s %18s %8s\n", "threads", "microlib (s)", "speedup", "concentration (s)", "speedup");
+    for (std::uint64_t i = 0; i < thread_counts.size(); i++) {
+        std::printf("%8" PRIu64 " %16.4f %8.2f %18.4f %8.2f\n", thread_counts[i], t_microlib[i],
+                    t_microlib[0] / t_microlib[i], t_conc[i], t_conc[0] / t_conc[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Copyright 2024 quocdang1998
+#include <cinttypes>     // PRIu64
+#include <cstdio>        // std::printf
+#include <cstdlib>       // std::atoi
+#include <filesystem>    // std::filesystem::exists, std::filesystem::remove, std::filesystem::remove_all
+#include <fstream>       // std::ofstream
+#include <ios>           // std::streamsize
+#include <iostream>      // std::cout
+#include <map>           // std::map
+#include <stdexcept>     // std::invalid_argument
+#include <streambuf>     // std::streambuf
+#include <string>        // std::string
+#include <system_error>  // std::error_code
+#include <vector>        // std::vector
+
+#include <omp.h>         // ::omp_get_max_threads
+
+#include "readmpo/h5_pool.hpp"     // readmpo::H5Pool
+#include "readmpo/h5_utils.hpp"    // readmpo::stringify
+#include "readmpo/master_mpo.hpp"  // readmpo::MasterMpo
+#include "readmpo/single_mpo.hpp"  // readmpo::SingleMpo, readmpo::ValidSet
+
+#include "bench_utils.hpp"    // readmpo::best_time
+#include "synthetic_mpo.hpp"  // readmpo::SyntheticMpoConfig, readmpo::write_synthetic_mpo_set
+
+using readmpo::best_time;
+
+const char * help_message = R"(Benchmark MPO reading on synthetic MPO files at several scales.
+Options:
+    -h, --help: Print help message.
+    -s, --scale: Name of a scale to run (multiple calls allowed). Possible value: small, medium, large, many-files.
+        Default: small and medium.
+    -d, --workdir: Folder of generated MPO files, which are removed at the end unless -k is given (the folder itself
+        is only removed if it is created by the benchmark). Default: "bench_data".
+    -k, --keep: Keep generated MPO files.
+    -o, --output: Name of the JSON result file. Default: "bench_suite.json".
+    -t, --threads: Number of threads of extraction. Default: all available threads.
+    -n, --repeat: Number of repetitions of extraction (best time is reported). Default: 3.
+Result:
+    For each scale, wall time of the construction of the master MPO (without valid set), of the valid set discovery,
+    of build_microlib_xs and of get_concentration, written to a JSON file and printed as a table.
+)";
+
+// Scales of the benchmark
+static const std::map<std::string, readmpo::SyntheticMpoConfig> bench_scales = {
+    // files, zones, groups, isotopes, burnup, params, values, anisotropy
+    {"small",      {1,    10,  2,  10, 10, 1, 3, 2}},
+    {"medium",     {4,    50,  8,  20, 20, 2, 3, 3}},
+    {"large",      {8,   100, 26,  30, 30, 2, 3, 3}},
+    {"many-files", {1000,  2,  2,   4,  4, 1, 2, 1}},
+};
+
+// Discard messages printed to std::cout until the end of the scope (failed outputs do not reset the field width, so
+// it is restored too)
+class CoutSilencer {
+  public:
+    CoutSilencer(void) : buffer_(std::cout.rdbuf(nullptr)), width_(std::cout.width()) {}
+    CoutSilencer(const CoutSilencer & src) = delete;
+    CoutSilencer & operator=(const CoutSilencer & src) = delete;
+    ~CoutSilencer(void) {
+        std::cout.rdbuf(this->buffer_);
+        std::cout.width(this->width_);
+    }
+
+  protected:
+    std::streambuf * buffer_;
+    std::streamsize width_;
+};
+
+// Result of a scale
+struct BenchResult {
+    std::string scale;
+    readmpo::SyntheticMpoConfig config;
+    double t_construction = 0.0, t_valid_set = 0.0, t_microlib = 0.0, t_concentration = 0.0;
+};
+
+int main(int argc, char * argv[]) {
+    using namespace readmpo;
+    // parse argument
+    std::vector<std::string> scales;
+    std::string workdir = "bench_data", output_fname = "bench_suite.json";
+    std::uint64_t n_threads = ::omp_get_max_threads();
+    int n_repeat = 3;
+    bool keep = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-s") || !argument.compare("--scale")) {
+            scales.push_back(std::string(argv[++i]));
+        } else if (!argument.compare("-d") || !argument.compare("--workdir")) {
+            workdir = std::string(argv[++i]);
+        } else if (!argument.compare("-k") || !argument.compare("--keep")) {
+            keep = true;
+        } else if (!argument.compare("-o") || !argument.compare("--output")) {
+            output_fname = std::string(argv[++i]);
+        } else if (!argument.compare("-t") || !argument.compare("--threads")) {
+            n_threads = std::atoi(argv[++i]);
+        } else if (!argument.compare("-n") || !argument.compare("--repeat")) {
+            n_repeat = std::atoi(argv[++i]);
+        } else {
+            throw std::invalid_argument("Unknown option " + argument + ". Execute \"bench_suite --help\".\n");
+        }
+    }
+    if (scales.empty()) {
+        scales = {"small", "medium"};
+    }
+    for (const std::string & scale : scales) {
+        if (!bench_scales.contains(scale)) {
+            throw std::invalid_argument("Unknown scale " + scale + ". Execute \"bench_suite --help\".\n");
+        }
+    }
+    // run each scale
+    bool workdir_existed = std::filesystem::exists(workdir);
+    std::vector<BenchResult> results;
+    for (const std::string & scale : scales) {
+        const SyntheticMpoConfig & config = bench_scales.at(scale);
+        std::cout << "Generating scale " << scale << "...\n";
+        std::vector<std::string> fnames = write_synthetic_mpo_set(stringify(workdir, "/", scale), config);
+        std::vector<std::string> isotopes, reactions = {"Absorption", "Diffusion", "Fission", "Scattering", "Total"};
+        for (std::uint64_t i_iso = 0; i_iso < config.n_isotopes; i_iso++) {
+            isotopes.push_back(stringify("ISO", i_iso));
+        }
+        BenchResult result = {scale, config};
+        {
+            // messages of the master MPO are discarded while timing
+            CoutSilencer silencer;
+            // construction from cold files
+            H5Pool::get_instance().clear();
+            result.t_construction = best_time(1, [&]() {
+                MasterMpo master_mpo(fnames, synthetic_geometry, synthetic_energy_mesh, true);
+            });
+            // valid set discovery
+            std::vector<SingleMpo> mpofiles;
+            for (const std::string & fname : fnames) {
+                mpofiles.push_back(SingleMpo(fname, synthetic_geometry, synthetic_energy_mesh));
+                mpofiles.back().close();
+            }
+            std::map<std::string, ValidSet> valid_set;
+            for (const std::string & isotope : isotopes) {
+                valid_set[isotope] = ValidSet();
+            }
+            std::ofstream valid_set_log(stringify(workdir, "/log_validset.txt"));
+            result.t_valid_set = best_time(1, [&]() {
+                for (SingleMpo & mpofile : mpofiles) {
+                    mpofile.reopen();
+                    mpofile.get_valid_set(valid_set, valid_set_log);
+                    mpofile.close();
+                }
+            });
+            mpofiles.clear();
+            // extraction
+            MasterMpo master_mpo(fnames, synthetic_geometry, synthetic_energy_mesh);
+            std::string logfile = stringify(workdir, "/log.txt");
+            result.t_microlib = best_time(n_repeat, [&]() {
+                master_mpo.build_microlib_xs(isotopes, reactions, {}, XsType::Micro, config.max_anisop_order, logfile,
+                                             n_threads);
+            });
+            result.t_concentration = best_time(n_repeat, [&]() {
+                master_mpo.get_concentration(isotopes, "burnup", n_threads);
+            });
+        }
+        results.push_back(result);
+    }
+    // remove generated files only, and the folder if it is created by the benchmark and is left empty
+    if (!keep) {
+        for (const std::string & scale : scales) {
+            std::filesystem::remove_all(stringify(workdir, "/", scale));
+        }
+        std::filesystem::remove(stringify(workdir, "/log_validset.txt"));
+        std::filesystem::remove(stringify(workdir, "/log.txt"));
+        if (!workdir_existed) {
+            std::error_code error;
+            std::filesystem::remove(workdir, error);
+        }
+    }
+    // write result to JSON file
+    std::ofstream output(output_fname);
+    output << "{\n  \"threads\": " << n_threads << ",\n  \"repeat\": " << n_repeat << ",\n  \"results\": [\n";
+    for (std::uint64_t i = 0; i < results.size(); i++) {
+        const BenchResult & r = results[i];
+        output << "    {\"scale\": \"" << r.scale << "\", \"files\": " << r.config.n_files << ", \"zones\": "
+               << r.config.n_zones << ", \"groups\": " << r.config.n_groups << ", \"isotopes\": "
+               << r.config.n_isotopes << ", \"statepts_per_file\": " << r.config.n_statepts()
+               << ", \"max_anisop_order\": " << r.config.max_anisop_order << ", \"construction_s\": "
+               << r.t_construction << ", \"valid_set_s\": " << r.t_valid_set << ", \"microlib_s\": " << r.t_microlib
+               << ", \"concentration_s\": " << r.t_concentration << "}" << ((i + 1 < results.size()) ? ",\n" : "\n");
+    }
+    output << "  ]\n}\n";
+    // print result
+    std::printf("\n%12s %6s %10s %16s %14s %14s %18s\n", "scale", "files", "statepts", "construction (s)",
+                "valid set (s)", "microlib (s)", "concentration (s)");
+    for (const BenchResult & r : results) {
+        std::printf("%12s %6" PRIu64 " %10" PRIu64 " %16.4f %14.4f %14.4f %18.4f\n", r.scale.c_str(),
+                    r.config.n_files, r.config.n_files * r.config.n_statepts(), r.t_construction, r.t_valid_set,
+                    r.t_microlib, r.t_concentration);
+    }
+    std::cout << "Result written to " << output_fname << "\n";
+    return 0;
+}
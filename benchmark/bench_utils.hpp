@@ -0,0 +1,25 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_BENCHMARK_BENCH_UTILS_HPP_
+#define READMPO_BENCHMARK_BENCH_UTILS_HPP_
+
+#include <chrono>  // std::chrono
+
+namespace readmpo {
+
+/** @brief Time a function in second, return the best time over repetitions.*/
+template <typename Function>
+double best_time(int n_repeat, Function && function) {
+    double best = 0.0;
+    for (int i = 0; i < n_repeat; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(end - begin).count();
+        best = (i == 0 || elapsed < best) ? elapsed : best;
+    }
+    return best;
+}
+
+}  // namespace readmpo
+
+#endif  // READMPO_BENCHMARK_BENCH_UTILS_HPP_
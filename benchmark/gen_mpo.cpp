@@ -0,0 +1,68 @@
+// Copyright 2024 quocdang1998
+#include <cstdlib>   // std::atol
+#include <iostream>  // std::cout
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "synthetic_mpo.hpp"  // readmpo::SyntheticMpoConfig, readmpo::write_synthetic_mpo_set
+
+const char * help_message = R"(Write synthetic MPO files with the layout expected by readmpo.
+Options:
+    -h, --help: Print help message.
+    -o, --outdir: Output folder, files are named mpo_<index>.hdf. Default: "synthetic_mpo".
+    -f, --files: Number of files. Default: 1.
+    -z, --zones: Number of zones. Default: 10.
+    -g, --groups: Number of energy groups. Default: 2.
+    -i, --isotopes: Number of isotopes. Default: 10.
+    -b, --burnup: Number of values of burnup. Default: 10.
+    -p, --params: Number of parameters other than burnup. Default: 1.
+    -v, --values: Number of values of each parameter other than burnup in each file. Default: 3.
+    -mao, --maxanisop: Max anisotropy order of Diffusion and Scattering. Default: 2.
+    -s, --seed: Seed of the random generator of cross sections. Default: 0.
+Result:
+    MPO files with geometry "SYNTH_GEO" and energy mesh "SYNTH_ENE", isotopes ISO0, ISO1, ... and reactions
+    Absorption, Diffusion, Fission, Scattering and Total. Each file covers a disjoint region of the parameter space.
+)";
+
+int main(int argc, char * argv[]) {
+    using namespace readmpo;
+    // parse argument
+    SyntheticMpoConfig config;
+    std::string output_folder = "synthetic_mpo";
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (!argument.compare("-h") || !argument.compare("--help")) {
+            std::cout << help_message;
+            return 0;
+        } else if (!argument.compare("-o") || !argument.compare("--outdir")) {
+            output_folder = std::string(argv[++i]);
+        } else if (!argument.compare("-f") || !argument.compare("--files")) {
+            config.n_files = std::atol(argv[++i]);
+        } else if (!argument.compare("-z") || !argument.compare("--zones")) {
+            config.n_zones = std::atol(argv[++i]);
+        } else if (!argument.compare("-g") || !argument.compare("--groups")) {
+            config.n_groups = std::atol(argv[++i]);
+        } else if (!argument.compare("-i") || !argument.compare("--isotopes")) {
+            config.n_isotopes = std::atol(argv[++i]);
+        } else if (!argument.compare("-b") || !argument.compare("--burnup")) {
+            config.n_burnup = std::atol(argv[++i]);
+        } else if (!argument.compare("-p") || !argument.compare("--params")) {
+            config.n_params = std::atol(argv[++i]);
+        } else if (!argument.compare("-v") || !argument.compare("--values")) {
+            config.n_values = std::atol(argv[++i]);
+        } else if (!argument.compare("-mao") || !argument.compare("--maxanisop")) {
+            config.max_anisop_order = std::atol(argv[++i]);
+        } else if (!argument.compare("-s") || !argument.compare("--seed")) {
+            config.seed = std::atol(argv[++i]);
+        } else {
+            std::cout << "Unknown option " << argument << ".\n" << help_message;
+            return 1;
+        }
+    }
+    // write files
+    std::vector<std::string> fnames = write_synthetic_mpo_set(output_folder, config);
+    for (const std::string & fname : fnames) {
+        std::cout << fname << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Copyright 2024 quocdang1998
+#include "synthetic_mpo.hpp"
+
+#include <algorithm>    // std::max, std::min
+#include <filesystem>   // std::filesystem::create_directories
+#include <random>       // std::mt19937_64, std::uniform_real_distribution
+#include <type_traits>  // std::is_same_v
+
+#include <H5Cpp.h>  // H5::DataSpace, H5::Group, H5::H5File, H5::PredType, H5::StrType
+
+#include "readmpo/h5_utils.hpp"  // readmpo::stringify
+
+namespace readmpo {
+
+// Reactions of synthetic MPO files
+static const std::vector<std::string> synthetic_reactions = {"Absorption", "Diffusion", "Fission", "Scattering",
+                                                             "Total"};
+
+// Name of parameters of synthetic MPO files other than burnup
+static const std::vector<std::string> synthetic_params = {"TFUEL", "CBORE", "TMOD", "DMOD"};
+
+// Length of fixed-size strings in synthetic MPO files
+static constexpr std::uint64_t synthetic_str_length = 24;
+
+// Write a 1D dataset of fixed-size strings
+static void write_str_dset(H5::Group & group, const char * dset_name, const std::vector<std::string> & values) {
+    std::vector<char> buffer(synthetic_str_length * values.size(), ' ');
+    for (std::uint64_t i = 0; i < values.size(); i++) {
+        values[i].copy(buffer.data() + i * synthetic_str_length, synthetic_str_length);
+    }
+    H5::StrType str_type(H5::PredType::C_S1, synthetic_str_length);
+    hsize_t n_values = values.size();
+    H5::DataSpace dspace(1, &n_values);
+    group.createDataSet(dset_name, str_type, dspace).write(buffer.data(), str_type);
+}
+
+// Write a dataset of numeric values (1D if the shape is omitted)
+template <typename T>
+static void write_num_dset(H5::Group & group, const char * dset_name, const std::vector<T> & values,
+                           std::vector<hsize_t> shape = {}) {
+    if (shape.empty()) {
+        shape.push_back(values.size());
+    }
+    H5::DataSpace dspace(shape.size(), shape.data());
+    const H5::PredType & dtype = (std::is_same_v<T, int>) ? H5::PredType::NATIVE_INT : H5::PredType::NATIVE_FLOAT;
+    group.createDataSet(dset_name, dtype, dspace).write(values.data(), dtype);
+}
+
+// Get number of state points of each file
+std::uint64_t SyntheticMpoConfig::n_statepts(void) const {
+    std::uint64_t n_statepts = this->n_burnup;
+    for (std::uint64_t i_param = 0; i_param < this->n_params; i_param++) {
+        n_statepts *= this->n_values;
+    }
+    return n_statepts;
+}
+
+// Write a synthetic MPO file with the layout expected by readmpo::SingleMpo
+void write_synthetic_mpo(const std::string & fname, const SyntheticMpoConfig & config, std::uint64_t i_file) {
+    int n_groups = config.n_groups, n_isotopes = config.n_isotopes, n_reactions = synthetic_reactions.size();
+    int max_order = std::max<std::uint64_t>(config.max_anisop_order, 1);
+    std::mt19937_64 generator(config.seed + i_file);
+    std::uniform_real_distribution<float> distribution(0.1f, 2.0f);
+    H5::H5File file(fname.c_str(), H5F_ACC_TRUNC);
+    // geometry and energy mesh
+    H5::Group geometry = file.createGroup("geometry");
+    write_str_dset(geometry, "GEOMETRY_NAME", {synthetic_geometry});
+    H5::Group geometry_0 = geometry.createGroup("geometry_0");
+    write_num_dset<int>(geometry_0, "NZONE", {static_cast<int>(config.n_zones)});
+    H5::Group energy_mesh = file.createGroup("energymesh");
+    write_str_dset(energy_mesh, "ENERGYMESH_NAME", {synthetic_energy_mesh});
+    H5::Group energy_mesh_0 = energy_mesh.createGroup("energymesh_0");
+    write_num_dset<int>(energy_mesh_0, "NG", {n_groups});
+    H5::Group output = file.createGroup("output");
+    write_num_dset<int>(output, "OUPUTID", {0}, {1, 1});
+    // contents
+    H5::Group contents = file.createGroup("contents");
+    H5::Group contents_isotopes = contents.createGroup("isotopes");
+    std::vector<std::string> isotope_names;
+    for (int i_iso = 0; i_iso < n_isotopes; i_iso++) {
+        isotope_names.push_back(stringify("ISO", i_iso));
+    }
+    write_str_dset(contents_isotopes, "ISOTOPENAME", isotope_names);
+    H5::Group contents_reactions = contents.createGroup("reactions");
+    write_str_dset(contents_reactions, "REACTIONAME", synthetic_reactions);
+    // parameters, values of the first parameter other than burnup are shifted by the index of the file
+    H5::Group parameters = file.createGroup("parameters");
+    H5::Group parameters_info = parameters.createGroup("info");
+    std::vector<std::string> param_names = {"BURNUP"};
+    for (std::uint64_t i_param = 0; i_param < config.n_params; i_param++) {
+        param_names.push_back((i_param < synthetic_params.size()) ? synthetic_params[i_param]
+                                                                   : stringify("PARAM", i_param));
+    }
+    write_str_dset(parameters_info, "PARAMNAME", param_names);
+    H5::Group parameters_values = parameters.createGroup("values");
+    std::vector<float> burnup_values;
+    for (std::uint64_t i_value = 0; i_value < config.n_burnup; i_value++) {
+        burnup_values.push_back(100.f * i_value);
+    }
+    write_num_dset<float>(parameters_values, "PARAM_0", burnup_values);
+    std::vector<std::uint64_t> pspace_shape = {config.n_burnup};
+    for (std::uint64_t i_param = 0; i_param < config.n_params; i_param++) {
+        std::uint64_t shift = (i_param == 0) ? i_file * config.n_values : 0;
+        std::vector<float> param_values;
+        for (std::uint64_t i_value = 0; i_value < config.n_values; i_value++) {
+            param_values.push_back(500.f + 10.f * (shift + i_value));
+        }
+        write_num_dset<float>(parameters_values, stringify("PARAM_", i_param + 1).c_str(), param_values);
+        pspace_shape.push_back(config.n_values);
+    }
+    // isotopes of each zone type: zones of even index contain all isotopes, others only isotopes of even index
+    H5::Group output_0 = output.createGroup("output_0");
+    H5::Group info = output_0.createGroup("info");
+    std::vector<int> addriso = {0}, isotope_list;
+    for (int i_iso = 0; i_iso < n_isotopes; i_iso++) {
+        isotope_list.push_back(i_iso);
+    }
+    addriso.push_back(isotope_list.size());
+    for (int i_iso = 0; i_iso < n_isotopes; i_iso += 2) {
+        isotope_list.push_back(i_iso);
+    }
+    addriso.push_back(isotope_list.size());
+    write_num_dset<int>(info, "ADDRISO", addriso);
+    write_num_dset<int>(info, "ISOTOPE", isotope_list);
+    std::vector<int> reaction_list;
+    for (int i_reac = 0; i_reac < n_reactions; i_reac++) {
+        reaction_list.push_back(i_reac);
+    }
+    write_num_dset<int>(info, "REACTION", reaction_list);
+    // address of each cross section of each isotope in each zone type
+    std::vector<int> addrxs(2 * n_isotopes * (n_reactions + 3), -1), transprofile;
+    std::vector<std::uint64_t> xs_size(2, 0);
+    for (int i_zone_type = 0; i_zone_type < 2; i_zone_type++) {
+        int n_zone_isotopes = addriso[i_zone_type + 1] - addriso[i_zone_type];
+        int address = 0;
+        for (int i_local = 0; i_local < n_zone_isotopes; i_local++) {
+            int i_iso = isotope_list[addriso[i_zone_type] + i_local];
+            int * addrxs_row = addrxs.data() + (i_zone_type * n_isotopes + i_local) * (n_reactions + 3);
+            int diffusion_order = 1 + (i_iso % max_order), scattering_order = 1 + ((i_iso + 1) % max_order);
+            addrxs_row[n_reactions] = diffusion_order;
+            addrxs_row[n_reactions + 1] = scattering_order;
+            addrxs_row[n_reactions + 2] = transprofile.size();
+            // band of Scattering from a group to its neighbors, wider for isotopes of even index
+            std::vector<int> first_arrival(n_groups), band_address(n_groups + 1, 0);
+            for (int g = 0; g < n_groups; g++) {
+                int first = std::max(0, g - 1), last = std::min(n_groups, g + 2 - (i_iso % 2));
+                first_arrival[g] = first;
+                band_address[g + 1] = band_address[g] + (last - first);
+            }
+            transprofile.insert(transprofile.end(), first_arrival.begin(), first_arrival.end());
+            transprofile.insert(transprofile.end(), band_address.begin(), band_address.end());
+            for (int i_reac = 0; i_reac < n_reactions; i_reac++) {
+                // some reactions are absent for some isotopes
+                if ((i_iso + i_reac) % 7 == 6) {
+                    continue;
+                }
+                addrxs_row[i_reac] = address;
+                if (synthetic_reactions[i_reac] == "Diffusion") {
+                    address += diffusion_order * n_groups;
+                } else if (synthetic_reactions[i_reac] == "Scattering") {
+                    address += (scattering_order - 1) * n_groups + band_address[n_groups];
+                } else {
+                    address += n_groups;
+                }
+            }
+        }
+        xs_size[i_zone_type] = address;
+    }
+    write_num_dset<int>(info, "ADDRXS", addrxs,
+                        {2, static_cast<hsize_t>(n_isotopes), static_cast<hsize_t>(n_reactions + 3)});
+    write_num_dset<int>(info, "TRANSPROFILE", transprofile);
+    // state points
+    std::vector<float> concentration, zoneflux, cross_section;
+    for (std::uint64_t i_statept = 0; i_statept < config.n_statepts(); i_statept++) {
+        H5::Group statept = output_0.createGroup(stringify("statept_", i_statept).c_str());
+        std::vector<int> param_idx(pspace_shape.size());
+        for (std::uint64_t i_dim = pspace_shape.size(), c_idx = i_statept; i_dim-- > 0;) {
+            param_idx[i_dim] = c_idx % pspace_shape[i_dim];
+            c_idx /= pspace_shape[i_dim];
+        }
+        write_num_dset<int>(statept, "PARAMVALUEORD", param_idx);
+        for (std::uint64_t i_zone = 0; i_zone < config.n_zones; i_zone++) {
+            H5::Group zone = statept.createGroup(stringify("zone_", i_zone).c_str());
+            int zone_type = i_zone % 2;
+            write_num_dset<int>(zone, "ADDRZX", {zone_type});
+            write_num_dset<int>(zone, "ADDRZI", {zone_type});
+            concentration.resize(addriso[zone_type + 1] - addriso[zone_type]);
+            zoneflux.resize(n_groups);
+            cross_section.resize(xs_size[zone_type]);
+            for (std::vector<float> * data : {&concentration, &zoneflux, &cross_section}) {
+                for (float & value : *data) {
+                    value = distribution(generator);
+                }
+            }
+            write_num_dset<float>(zone, "CONCENTRATION", concentration);
+            write_num_dset<float>(zone, "ZONEFLUX", zoneflux);
+            write_num_dset<float>(zone, "CROSSECTION", cross_section);
+        }
+    }
+}
+
+// Write a set of synthetic MPO files inside a folder
+std::vector<std::string> write_synthetic_mpo_set(const std::string & folder, const SyntheticMpoConfig & config) {
+    std::filesystem::create_directories(folder);
+    std::vector<std::string> fnames;
+    for (std::uint64_t i_file = 0; i_file < config.n_files; i_file++) {
+        fnames.push_back(stringify(folder, "/mpo_", i_file, ".hdf"));
+        write_synthetic_mpo(fnames.back(), config, i_file);
+    }
+    return fnames;
+}
+
+}  // namespace readmpo
@@ -0,0 +1,60 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_BENCHMARK_SYNTHETIC_MPO_HPP_
+#define READMPO_BENCHMARK_SYNTHETIC_MPO_HPP_
+
+#include <cstdint>  // std::uint64_t
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+namespace readmpo {
+
+/** @brief Name of the homogenized geometry of synthetic MPO files.*/
+inline constexpr const char * synthetic_geometry = "SYNTH_GEO";
+
+/** @brief Name of the energy mesh of synthetic MPO files.*/
+inline constexpr const char * synthetic_energy_mesh = "SYNTH_ENE";
+
+/** @brief Size of a set of synthetic MPO files.*/
+struct SyntheticMpoConfig {
+    /** @brief Number of files.*/
+    std::uint64_t n_files = 1;
+    /** @brief Number of zones in the homogenized geometry.*/
+    std::uint64_t n_zones = 10;
+    /** @brief Number of energy groups.*/
+    std::uint64_t n_groups = 2;
+    /** @brief Number of isotopes (zones of odd index only contain isotopes of even index).*/
+    std::uint64_t n_isotopes = 10;
+    /** @brief Number of values of burnup.*/
+    std::uint64_t n_burnup = 10;
+    /** @brief Number of parameters other than burnup.*/
+    std::uint64_t n_params = 1;
+    /** @brief Number of values of each parameter other than burnup in each file.*/
+    std::uint64_t n_values = 3;
+    /** @brief Max anisotropy order of Diffusion and Scattering.*/
+    std::uint64_t max_anisop_order = 2;
+    /** @brief Seed of the random generator of cross sections.*/
+    std::uint64_t seed = 0;
+
+    /** @brief Get number of state points of each file.*/
+    std::uint64_t n_statepts(void) const;
+};
+
+/** @brief Write a synthetic MPO file with the layout expected by readmpo::SingleMpo.
+ *  @details The file contains an output of ``n_burnup * n_values^n_params`` state points. Values of the first
+ *  parameter other than burnup are shifted by the index of the file, so that files of a set cover disjoint regions of
+ *  the parameter space. Each isotope has its own anisotropy orders and Scattering band width, and some reactions are
+ *  absent for some isotopes. Cross sections, fluxes and concentrations are random.
+ *  @param fname Name of the output file.
+ *  @param config Size of the set of files.
+ *  @param i_file Index of the file in the set.
+ */
+void write_synthetic_mpo(const std::string & fname, const SyntheticMpoConfig & config, std::uint64_t i_file = 0);
+
+/** @brief Write a set of synthetic MPO files ``mpo_<index>.hdf`` inside a folder.
+ *  @return Names of the written files.
+ */
+std::vector<std::string> write_synthetic_mpo_set(const std::string & folder, const SyntheticMpoConfig & config);
+
+}  // namespace readmpo
+
+#endif  // READMPO_BENCHMARK_SYNTHETIC_MPO_HPP_
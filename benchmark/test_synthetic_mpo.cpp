@@ -0,0 +1,71 @@
+// Copyright 2024 quocdang1998
+#include <cmath>       // std::abs
+#include <cstdint>     // std::uint64_t
+#include <filesystem>  // std::filesystem::remove_all
+#include <iostream>    // std::cerr, std::cout
+#include <string>      // std::string
+#include <vector>      // std::vector
+
+#include <H5Cpp.h>  // H5::H5File
+
+#include "readmpo/h5_utils.hpp"    // readmpo::get_dset, readmpo::stringify
+#include "readmpo/master_mpo.hpp"  // readmpo::MasterMpo, readmpo::MpoLib, readmpo::XsType
+#include "synthetic_mpo.hpp"       // readmpo::SyntheticMpoConfig, readmpo::write_synthetic_mpo_set
+
+// Check that synthetic MPO files round-trip through the master MPO: metadata match the configuration, and the flux
+// extracted at each state point and zone is the one written to the file
+int main(void) {
+    using namespace readmpo;
+    SyntheticMpoConfig config;
+    config.n_files = 2;
+    config.n_zones = 3;
+    config.n_groups = 2;
+    config.n_isotopes = 3;
+    config.n_burnup = 3;
+    config.n_values = 2;
+    // folder of the files must not have the name of the executable, which is in the working directory of the test
+    const std::string folder = "test_synthetic_mpo_data";
+    std::vector<std::string> fnames = write_synthetic_mpo_set(folder, config);
+    std::uint64_t n_errors = 0;
+    auto check = [&n_errors](bool condition, const std::string & message) {
+        if (!condition) {
+            std::cerr << "Failed: " << message << "\n";
+            n_errors++;
+        }
+    };
+    // check metadata
+    MasterMpo master_mpo(fnames, synthetic_geometry, synthetic_energy_mesh);
+    check(master_mpo.n_zone() == config.n_zones, "number of zones");
+    check(master_mpo.get_isotopes().size() == config.n_isotopes, "number of isotopes");
+    check(master_mpo.get_reactions().size() == 5, "number of reactions");
+    check(master_mpo.master_pspace().at("burnup").size() == config.n_burnup, "values of burnup");
+    check(master_mpo.master_pspace().at("tfuel").size() == config.n_files * config.n_values, "values of tfuel");
+    // check flux at each state point and zone against the file, output has shape [group, zone, burnup, tfuel]
+    std::string logfile = folder + "/log.txt";
+    MpoLib flux = master_mpo.build_microlib_xs({"ISO0"}, {"Absorption"}, {}, XsType::Flux, 1, logfile, 1);
+    const NdArray & iso_flux = flux.at("ISO0").at("Absorption");
+    for (std::uint64_t i_file = 0; i_file < config.n_files; i_file++) {
+        H5::H5File file(fnames[i_file].c_str(), H5F_ACC_RDONLY);
+        for (std::uint64_t i_statept = 0; i_statept < config.n_statepts(); i_statept++) {
+            std::string statept = stringify("output/output_0/statept_", i_statept);
+            std::vector<int> param_idx = get_dset<int>(&file, stringify(statept, "/PARAMVALUEORD").c_str()).first;
+            for (std::uint64_t i_zone = 0; i_zone < config.n_zones; i_zone++) {
+                std::string zone = stringify(statept, "/zone_", i_zone, "/ZONEFLUX");
+                std::vector<float> zoneflux = get_dset<float>(&file, zone.c_str()).first;
+                for (std::uint64_t i_group = 0; i_group < config.n_groups; i_group++) {
+                    std::vector<std::uint64_t> index = {i_group, i_zone, static_cast<std::uint64_t>(param_idx[0]),
+                                                        i_file * config.n_values + param_idx[1]};
+                    check(std::abs(iso_flux[index] - zoneflux[i_group]) <= 1e-6 * std::abs(zoneflux[i_group]),
+                          stringify("flux of ", zone, " at group ", i_group));
+                }
+            }
+        }
+    }
+    std::filesystem::remove_all(folder);
+    if (n_errors != 0) {
+        std::cerr << n_errors << " check(s) failed.\n";
+        return 1;
+    }
+    std::cout << "Synthetic MPO files round-trip through the master MPO.\n";
+    return 0;
+}
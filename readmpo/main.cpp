@@ -1,7 +1,10 @@
 // Copyright 2023 quocdang1998
+#include "readmpo/h5_pool.hpp"     // readmpo::H5Pool
+#include "readmpo/lib_file.hpp"    // readmpo::load_lib, readmpo::save_lib
 #include "readmpo/master_mpo.hpp"  // readmpo::MasterMpo
 #include "readmpo/nd_array.hpp"    // readmpo::NdArray
-#include "readmpo/query_mpo.hpp"   // readmpo::query_mpo
+#include "readmpo/profile.hpp"     // readmpo::Profile
+#include "readmpo/query_mpo.hpp"   // readmpo::MpoMetadata, readmpo::query_mpo, readmpo::query_mpo_metadata
 #include "readmpo/single_mpo.hpp"  // readmpo::SingleMpo
 
 #include <pybind11/pybind11.h>
@@ -14,6 +17,26 @@ namespace py = pybind11;
 
 namespace readmpo {
 
+// Convert an array to a Numpy array sharing its memory, the array is owned by a capsule released by Python
+static py::array_t<double> to_numpy(NdArray && array) {
+    NdArray * owner = new NdArray(std::move(array));
+    py::capsule release_owner(owner, [](void * p) { delete static_cast<NdArray *>(p); });
+    return py::array_t<double>(owner->shape(), owner->strides(), owner->data(), release_owner);
+}
+
+// Convert a library to a Python dictionary of Numpy arrays sharing the memory of the library
+static py::dict to_pydict(MpoLib && microlib) {
+    py::dict result;
+    for (auto & [isotope, rlib] : microlib) {
+        py::dict iso_result;
+        for (auto & [reaction, lib] : rlib) {
+            iso_result[reaction.c_str()] = to_numpy(std::move(lib));
+        }
+        result[isotope.c_str()] = iso_result;
+    }
+    return result;
+}
+
 // Wrap ``readmpo::NdArray`` class
 void wrap_nd_array(py::module & readmpo_package) {
     auto nd_array_pyclass = py::class_<NdArray>(
@@ -133,13 +156,27 @@ void wrap_master_mpo(py::module & readmpo_package) {
     // constructor
     master_mpo_pyclass.def(
         py::init(
-            [](py::list & mpofile_pylist, const std::string & geometry, const std::string & energy_mesh) {
+            [](py::list & mpofile_pylist, const std::string & geometry, const std::string & energy_mesh,
+               bool defer_valid_set) {
                 std::vector<std::string> mpofile_list = mpofile_pylist.cast<std::vector<std::string>>();
-                return new MasterMpo(mpofile_list, geometry, energy_mesh);
+                return new MasterMpo(mpofile_list, geometry, energy_mesh, defer_valid_set);
             }
         ),
-        "Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh.",
-        py::arg("mpofile_list"), py::arg("geometry"), py::arg("energy_mesh")
+        R"(
+        Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh.
+
+        Parameters
+        ----------
+        mpofile_list : List[str]
+            List of MPO file names.
+        geometry : str
+            Name of homogenized geometry.
+        energy_mesh : str
+            Name of energy mesh.
+        defer_valid_set : bool, default=False
+            If ``True``, the valid set of Diffusion and Scattering of each isotope is not computed at construction,
+            but discovered during its first extraction, in the same pass reading cross sections.)",
+        py::arg("mpofile_list"), py::arg("geometry"), py::arg("energy_mesh"), py::arg("defer_valid_set") = false
     );
     // attributes
     master_mpo_pyclass.def_property_readonly(
@@ -157,25 +194,65 @@ void wrap_master_mpo(py::module & readmpo_package) {
         [](MasterMpo & self) { return py::cast(self.get_reactions()); },
         "Get available reactions."
     );
+    // update list of MPO files
+    master_mpo_pyclass.def(
+        "add_files",
+        [](MasterMpo & self, py::list & mpofile_pylist, bool defer_valid_set) {
+            std::vector<std::string> mpofile_list = mpofile_pylist.cast<std::vector<std::string>>();
+            py::gil_scoped_release release;
+            self.add_files(mpofile_list, defer_valid_set);
+        },
+        R"(
+        Add MPO files.
+
+        Parameter values, isotopes, reactions and valid sets of the new files are merged into the master MPO. Files
+        already in the master MPO are not read again.
+
+        Parameters
+        ----------
+        mpofile_list : List[str]
+            List of MPO file names, with the same parameters and number of zones as the files in the master MPO.
+        defer_valid_set : bool, default=False
+            If ``True``, valid sets of isotopes not yet in the master MPO are discovered during their first
+            extraction.)",
+        py::arg("mpofile_list"), py::arg("defer_valid_set") = false
+    );
+    master_mpo_pyclass.def(
+        "remove_files",
+        [](MasterMpo & self, py::list & mpofile_pylist) {
+            std::vector<std::string> mpofile_list = mpofile_pylist.cast<std::vector<std::string>>();
+            self.remove_files(mpofile_list);
+        },
+        R"(
+        Remove MPO files.
+
+        Parameter values, isotopes and reactions present only in the removed files are removed. Valid sets of the
+        remaining isotopes are kept.
+
+        Parameters
+        ----------
+        mpofile_list : List[str]
+            List of MPO file names, as in ``mpofile_list`` at construction.)",
+        py::arg("mpofile_list")
+    );
     // get data
     master_mpo_pyclass.def(
         "build_microlib_xs",
         [](MasterMpo & self, py::list & isotopes_list, py::list & reactions_list, py::list & skipped_dims_list,
-           XsType type, std::uint64_t max_anisop_order, const std::string & logfile) {
+           XsType type, std::uint64_t max_anisop_order, const std::string & logfile, std::uint64_t n_threads,
+           bool expand_scattering) {
             // get microlib
             std::vector<std::string> isotopes = isotopes_list.cast<std::vector<std::string>>();
             std::vector<std::string> reactions = reactions_list.cast<std::vector<std::string>>();
             std::vector<std::string> skipped_dims = skipped_dims_list.cast<std::vector<std::string>>();
-            auto microlib = self.build_microlib_xs(isotopes, reactions, skipped_dims, type, max_anisop_order, logfile);
-            // convert result to Python dictionary
-            py::dict result;
-            for (auto & [isotope, rlib] : microlib) {
-                result[isotope.c_str()] = py::dict();
-                for (auto & [reaction, lib] : rlib) {
-                    result[isotope.c_str()][reaction.c_str()] = new NdArray(std::move(microlib[isotope][reaction]));
-                }
+            MpoLib microlib;
+            {
+                py::gil_scoped_release release;
+                microlib = self.build_microlib_xs(isotopes, reactions, skipped_dims, type, max_anisop_order, logfile,
+                                                  n_threads, expand_scattering);
             }
-            return result;
+            // convert result to Python dictionary of Numpy arrays
+            return to_pydict(std::move(microlib));
         },
         R"(
         Retrieve microscopic homogenized cross sections at some isotopes, reactions and skipped dimensions in all MPO
@@ -195,18 +272,154 @@ void wrap_master_mpo(py::module & readmpo_package) {
             Max anisotropy order to get for Diffusion and Scattering cross section. If the provided value is larger than
             the max anisotropy order recovered from MPO file, it will be clamped.
         logfile : str
-            Log file to write out the process.)",
+            Log file to write out the process.
+        n_threads : int, default=0
+            Number of threads reading MPO files or state points concurrently. If ``0``, all available threads are used.
+            The result is identical to the one obtained in serial.
+        expand_scattering : bool, default=False
+            If ``False``, Scattering at each anisotropy order is stored in a block-sparse array ``Scattering{anisop}``
+            of shape ``[band_size, zones, ...]``, whose band structure is saved in ``ScatteringProfile``: the first
+            arrival group ``fag[d]`` of each departure group, followed by the offset ``adr[d]`` of its band. Transfer
+            from ``d`` to ``a`` is at the position ``adr[d] + a - fag[d]`` if ``fag[d] <= a < fag[d] + adr[d+1] -
+            adr[d]``, and is zero otherwise. If ``True``, it is expanded to one array
+            ``Scattering{anisop}_{departure}-{arrival}`` per transfer group pair.
+
+        Returns
+        -------
+        Dict[str, Dict[str, numpy.ndarray]]
+            Cross sections of each output of each isotope. Arrays share the memory of the library without copy.
+
+        Notes
+        -----
+        The GIL is released during the extraction, so other Python threads can run concurrently.)",
         py::arg("isotopes"), py::arg("reactions"), py::arg("skipped_dims"), py::arg("type") = XsType::Micro,
-        py::arg("max_anisop_order") = 1, py::arg("log_file") = "log.txt"
+        py::arg("max_anisop_order") = 1, py::arg("log_file") = "log.txt", py::arg("n_threads") = 0,
+        py::arg("expand_scattering") = false
+    );
+    master_mpo_pyclass.def(
+        "build_microlib_batch",
+        [](MasterMpo & self, py::list & requests_list, const std::string & logfile, std::uint64_t n_threads) {
+            // get requests
+            std::vector<XsRequest> requests;
+            for (py::handle request_item : requests_list) {
+                py::dict request_dict = request_item.cast<py::dict>();
+                XsRequest & request = requests.emplace_back();
+                request.isotopes = request_dict["isotopes"].cast<std::vector<std::string>>();
+                request.reactions = request_dict["reactions"].cast<std::vector<std::string>>();
+                if (request_dict.contains("skipped_dims")) {
+                    request.skipped_dims = request_dict["skipped_dims"].cast<std::vector<std::string>>();
+                }
+                if (request_dict.contains("type")) {
+                    request.type = request_dict["type"].cast<XsType>();
+                }
+                if (request_dict.contains("max_anisop_order")) {
+                    request.max_anisop_order = request_dict["max_anisop_order"].cast<std::uint64_t>();
+                }
+                if (request_dict.contains("expand_scattering")) {
+                    request.expand_scattering = request_dict["expand_scattering"].cast<bool>();
+                }
+            }
+            // get microlib of each request
+            std::vector<MpoLib> microlibs;
+            {
+                py::gil_scoped_release release;
+                microlibs = self.build_microlib_batch(requests, logfile, n_threads);
+            }
+            py::list result;
+            for (MpoLib & microlib : microlibs) {
+                result.append(to_pydict(std::move(microlib)));
+            }
+            return result;
+        },
+        R"(
+        Retrieve microscopic homogenized cross sections of several requests in a single pass over the MPO files.
+
+        Each MPO file, state point and zone is visited once, and the datasets of each zone are read once for all
+        requests. The result is identical to calling ``build_microlib_xs`` on each request in their order.
+
+        Parameters
+        ----------
+        requests : List[dict]
+            List of requests. Each request is a dictionary with the keys ``isotopes`` and ``reactions``, and optionally
+            ``skipped_dims`` (default ``[]``), ``type`` (default ``readmpo.XsType.Micro``), ``max_anisop_order``
+            (default ``1``) and ``expand_scattering`` (default ``False``), as the arguments of ``build_microlib_xs``.
+        logfile : str
+            Log file to write out the process.
+        n_threads : int, default=0
+            Number of threads reading MPO files or state points concurrently. If ``0``, all available threads are used.
+
+        Returns
+        -------
+        List[Dict[str, Dict[str, numpy.ndarray]]]
+            Cross sections of each output of each isotope of each request, in the order of the requests.
+
+        Notes
+        -----
+        The GIL is released during the extraction, so other Python threads can run concurrently.)",
+        py::arg("requests"), py::arg("log_file") = "log.txt", py::arg("n_threads") = 0
+    );
+    master_mpo_pyclass.def(
+        "stream_microlib_xs",
+        [](MasterMpo & self, const std::string & fname, py::list & isotopes_list, py::list & reactions_list,
+           py::list & skipped_dims_list, XsType type, std::uint64_t max_anisop_order, const std::string & logfile,
+           std::uint64_t n_threads, bool expand_scattering, std::uint64_t memory_cap) {
+            std::vector<std::string> isotopes = isotopes_list.cast<std::vector<std::string>>();
+            std::vector<std::string> reactions = reactions_list.cast<std::vector<std::string>>();
+            std::vector<std::string> skipped_dims = skipped_dims_list.cast<std::vector<std::string>>();
+            py::gil_scoped_release release;
+            self.stream_microlib_xs(fname, isotopes, reactions, skipped_dims, type, max_anisop_order, logfile,
+                                    n_threads, expand_scattering, memory_cap);
+        },
+        R"(
+        Retrieve microscopic homogenized cross sections and write them to an HDF5 file one state point at a time.
+
+        Outputs are written to the datasets ``/<isotope>/<output>`` of the file, with the same name and shape as the
+        arrays returned by ``build_microlib_xs``. Only the cross sections of the state points being read are kept in
+        memory, so that libraries larger than the memory can be extracted.
+
+        Parameters
+        ----------
+        fname : str
+            Name of the output HDF5 file.
+        isotopes : List[str]
+            List of isotopes.
+        reactions : List[str]
+            List of reactions.
+        skipped_dims : List[str]
+            List of lowercased skipped dimension.
+        type : readmpo.XsType
+            Cross section type to get.
+        max_anisop_order : int, default=1
+            Max anisotropy order to get for Diffusion and Scattering cross section.
+        logfile : str
+            Log file to write out the process.
+        n_threads : int, default=0
+            Number of threads reading MPO files or state points concurrently. If ``0``, all available threads are used.
+            It is reduced so that the memory held by all threads fits in ``memory_cap``.
+        expand_scattering : bool, default=False
+            Expand Scattering to one array per transfer group pair (see ``build_microlib_xs``).
+        memory_cap : int, default=1073741824
+            Max number of bytes of cross sections held in memory.
+
+        Notes
+        -----
+        The GIL is released during the extraction, so other Python threads can run concurrently.)",
+        py::arg("fname"), py::arg("isotopes"), py::arg("reactions"), py::arg("skipped_dims"),
+        py::arg("type") = XsType::Micro, py::arg("max_anisop_order") = 1, py::arg("log_file") = "log.txt",
+        py::arg("n_threads") = 0, py::arg("expand_scattering") = false, py::arg("memory_cap") = 1ULL << 30
     );
     master_mpo_pyclass.def(
         "get_concentration",
-        [](MasterMpo & self, py::list & isotopes_list, const std::string & burnup_name) {
+        [](MasterMpo & self, py::list & isotopes_list, const std::string & burnup_name, std::uint64_t n_threads) {
             std::vector<std::string> isotopes = isotopes_list.cast<std::vector<std::string>>();
-            auto conclib = self.get_concentration(isotopes, burnup_name);
+            ConcentrationLib conclib;
+            {
+                py::gil_scoped_release release;
+                conclib = self.get_concentration(isotopes, burnup_name, n_threads);
+            }
             py::dict result;
             for (auto & [isotope, conc] : conclib) {
-                result[isotope.c_str()] = new NdArray(std::move(conc));
+                result[isotope.c_str()] = to_numpy(std::move(conc));
             }
             return result;
         },
@@ -220,8 +433,97 @@ void wrap_master_mpo(py::module & readmpo_package) {
         isotopes : List[str]
             List of isotopes.
         burnup_name : str
-            Name of burnup parameter.)",
-        py::arg("isotopes"), py::arg("burnup_name") = "burnup"
+            Name of burnup parameter.
+        n_threads : int, default=0
+            Number of threads reading state points concurrently. If ``0``, all available threads are used.
+
+        Returns
+        -------
+        Dict[str, numpy.ndarray]
+            Concentration of each isotope, with shape ``(n_burnup, n_zone)``. The GIL is released during the
+            extraction.)",
+        py::arg("isotopes"), py::arg("burnup_name") = "burnup", py::arg("n_threads") = 0
+    );
+    // point query
+    master_mpo_pyclass.def(
+        "query_xs",
+        [](MasterMpo & self, py::dict & param_values_dict, const std::string & isotope, const std::string & reaction,
+           XsType type, std::uint64_t anisop) {
+            std::map<std::string, double> param_values = param_values_dict.cast<std::map<std::string, double>>();
+            NdArray xs;
+            {
+                py::gil_scoped_release release;
+                xs = self.query_xs(param_values, isotope, reaction, type, anisop);
+            }
+            return to_numpy(std::move(xs));
+        },
+        R"(
+        Retrieve cross section of an isotope and a reaction at arbitrary values of parameters.
+
+        The value is interpolated multilinearly between the state points of the master parameter space bracketing
+        the requested values. Only the zones of these state points are read, and cross sections at each state point
+        are cached, so that successive queries at close values are cheap.
+
+        Parameters
+        ----------
+        param_values : Dict[str, float]
+            Value of each parameter, by (case insensitive) name. Parameters having a single value can be omitted.
+        isotope : str
+            Name of the isotope.
+        reaction : str
+            Name of the reaction.
+        type : readmpo.XsType
+            Cross section type to get.
+        anisop : int, default=0
+            Anisotropy order of Diffusion and Scattering.
+
+        Returns
+        -------
+        numpy.ndarray
+            Cross section of shape ``(n_groups, n_zones)``, or ``(n_groups, n_groups, n_zones)`` indexed by departure
+            and arrival group for Scattering.)",
+        py::arg("param_values"), py::arg("isotope"), py::arg("reaction"), py::arg("type") = XsType::Micro,
+        py::arg("anisop") = 0
+    );
+    master_mpo_pyclass.def_property(
+        "query_cache_capacity",
+        [](MasterMpo & self) { return self.query_cache().capacity(); },
+        [](MasterMpo & self, std::uint64_t capacity) { self.query_cache().set_capacity(capacity); },
+        "Max number of state points of an isotope and a reaction kept in the cache of ``query_xs``."
+    );
+    // profiling
+    master_mpo_pyclass.def(
+        "profile",
+        [](MasterMpo & self) {
+            Profile profile = self.profile();
+            py::dict result;
+            result["phases"] = py::cast(profile.phase_times);
+            result["total"] = py::cast(profile.total);
+            result["files"] = py::cast(profile.files);
+            return result;
+        },
+        R"(
+        Get wall time of each phase and I/O counters of each MPO file and in total.
+
+        Phases and counters are accumulated over all calls since the construction or the last call to
+        ``reset_profile``.
+
+        Returns
+        -------
+        Dict[str, Dict]
+            Dictionary with 3 keys:
+
+            - ``"phases"``: wall time in second of each phase (``"open"``, ``"pspace_merge"``, ``"valid_set"``,
+              ``"extraction"`` and ``"serialization"``).
+            - ``"total"``: counters summed over all MPO files (``"objects_opened"``, ``"datasets_read"``,
+              ``"bytes_read"``, ``"allocations"`` and ``"bytes_allocated"``).
+            - ``"files"``: I/O counters of each MPO file, by filename (``"objects_opened"``, ``"datasets_read"`` and
+              ``"bytes_read"``).)"
+    );
+    master_mpo_pyclass.def(
+        "reset_profile",
+        [](MasterMpo & self) { self.reset_profile(); },
+        "Reset phase timers and I/O counters."
     );
     // string representation
     master_mpo_pyclass.def(
@@ -234,18 +536,20 @@ void wrap_master_mpo(py::module & readmpo_package) {
             [](MasterMpo & self) {
                 return py::make_tuple(self.geometry(), self.energy_mesh(), self.n_zone(), self.get_mpo_fnames(),
                                       self.master_pspace(), self.get_isotopes(), self.get_reactions(),
-                                      self.valid_set());
+                                      self.valid_set(), py::bytes(self.get_mpofiles_state()));
             },
             [](py::tuple state) {
-                if (state.size() != 8) {
+                // states pickled without metadata of MPO files have 8 elements
+                if (state.size() != 8 && state.size() != 9) {
                     throw std::runtime_error("Invalid state!");
                 }
+                std::string mpofiles_state = (state.size() == 9) ? state[8].cast<std::string>() : std::string();
                 MasterMpo * obj = new MasterMpo();
                 obj->set_state(state[0].cast<std::string>(), state[1].cast<std::string>(),
                                state[2].cast<std::uint64_t>(), state[3].cast<std::vector<std::string>>(),
                                state[4].cast<std::map<std::string, std::vector<double>>>(),
                                state[5].cast<std::vector<std::string>>(), state[6].cast<std::vector<std::string>>(),
-                               state[7].cast<std::map<std::string, ValidSet>>());
+                               state[7].cast<std::map<std::string, ValidSet>>(), mpofiles_state);
                 return obj;
             }));
 }
@@ -258,6 +562,162 @@ void wrap_query_mpo(py::module & readmpo_package) {
         "Read a MPO file and return geometry names and energy mesh names.",
         py::arg("mpofile_name")
     );
+    readmpo_package.def(
+        "query_mpo_metadata",
+        [] (const std::vector<std::string> & mpofile_list, const std::string & geometry,
+            const std::string & energy_mesh, std::uint64_t n_threads) {
+            std::vector<MpoMetadata> metadata;
+            {
+                py::gil_scoped_release release;
+                metadata = query_mpo_metadata(mpofile_list, geometry, energy_mesh, n_threads);
+            }
+            py::list result;
+            for (MpoMetadata & file_metadata : metadata) {
+                py::dict file_result;
+                file_result["fname"] = file_metadata.fname;
+                file_result["status"] = file_metadata.status;
+                file_result["geometries"] = file_metadata.geometries;
+                file_result["energy_meshes"] = file_metadata.energy_meshes;
+                file_result["n_zones"] = file_metadata.n_zones;
+                file_result["n_groups"] = file_metadata.n_groups;
+                file_result["n_values"] = file_metadata.n_values;
+                file_result["isotopes"] = file_metadata.isotopes;
+                file_result["reactions"] = file_metadata.reactions;
+                result.append(file_result);
+            }
+            return result;
+        },
+        R"(
+        Read metadata of many MPO files concurrently.
+
+        Only the small datasets describing geometries, energy meshes, parameters, isotopes and reactions are read. The
+        reading of a file stops as soon as the requested geometry or energy mesh is found missing, and errors raised
+        while reading a file are reported in its status instead of being raised.
+
+        Parameters
+        ----------
+        mpofile_list : List[str]
+            List of MPO file names.
+        geometry : str, default=""
+            Name of the geometry each file must contain (empty means no requirement).
+        energy_mesh : str, default=""
+            Name of the energy mesh each file must contain (empty means no requirement).
+        n_threads : int, default=0
+            Number of threads reading files concurrently. If ``0``, all available threads are used.
+
+        Returns
+        -------
+        List[dict]
+            Metadata of each file, in the order of the list, with the keys ``fname``, ``status`` (``"ok"``,
+            ``"missing geometry"``, ``"missing energy mesh"``, ``"missing output"`` if no output is computed for the
+            pair of geometry and energy mesh, or the error message), ``geometries``,
+            ``energy_meshes``, ``n_zones`` (by geometry), ``n_groups`` (by energy mesh), ``n_values`` (by lowercased
+            parameter), ``isotopes`` and ``reactions`` (of the output if both geometry and energy mesh are given).)",
+        py::arg("mpofile_list"), py::arg("geometry") = "", py::arg("energy_mesh") = "", py::arg("n_threads") = 0
+    );
+}
+
+// Wrap ``readmpo::save_lib`` and ``readmpo::load_lib`` functions
+void wrap_lib_file(py::module & readmpo_package) {
+    readmpo_package.def(
+        "save_lib",
+        [](const std::string & fname, py::dict & lib) {
+            // convert to library of arrays viewing the Numpy arrays (kept alive until the end of the write)
+            MpoLib c_lib;
+            std::vector<py::array_t<double>> np_arrays;
+            for (auto [isotope, iso_lib] : lib) {
+                std::map<std::string, NdArray> & c_iso_lib = c_lib[isotope.cast<std::string>()];
+                for (auto [output, array] : iso_lib.cast<py::dict>()) {
+                    py::array_t<double> & np_array = np_arrays.emplace_back(array.cast<py::array_t<double>>());
+                    std::vector<std::uint64_t> shape(np_array.shape(), np_array.shape() + np_array.ndim());
+                    std::vector<std::uint64_t> strides(np_array.strides(), np_array.strides() + np_array.ndim());
+                    c_iso_lib[output.cast<std::string>()] = NdArray(np_array.mutable_data(), std::move(shape),
+                                                                    std::move(strides));
+                }
+            }
+            py::gil_scoped_release release;
+            save_lib(fname, c_lib);
+        },
+        R"(
+        Save all arrays of a library to a single indexed file.
+
+        The file starts with a 64-byte header, followed by a table of contents giving the isotope name, the output
+        name, the data type, the shape and the byte offset of each array. Data of each array is stored in C-contiguous
+        order in a block aligned to 64 bytes.
+
+        Parameters
+        ----------
+        fname : str
+            Name of the file.
+        lib : Dict[str, Dict[str, numpy.ndarray]]
+            Arrays of each output of each isotope.)",
+        py::arg("fname"), py::arg("lib")
+    );
+    readmpo_package.def(
+        "load_lib",
+        [](const std::string & fname) {
+            MpoLib c_lib = load_lib(fname);
+            py::dict result;
+            for (auto & [isotope, iso_lib] : c_lib) {
+                py::dict iso_result;
+                for (auto & [output, array] : iso_lib) {
+                    iso_result[output.c_str()] = to_numpy(std::move(array));
+                }
+                result[isotope.c_str()] = iso_result;
+            }
+            return result;
+        },
+        R"(
+        Map a library file saved by ``save_lib`` into memory.
+
+        Parameters
+        ----------
+        fname : str
+            Name of the file.
+
+        Returns
+        -------
+        Dict[str, Dict[str, numpy.ndarray]]
+            Arrays of each output of each isotope. Arrays are views into the mapped file without copy, elements modified
+            in memory are not written back to the file. The file is unmapped once all arrays are released.)",
+        py::arg("fname")
+    );
+}
+
+// Wrap ``readmpo::H5Pool`` class
+void wrap_h5_pool(py::module & readmpo_package) {
+    readmpo_package.def(
+        "get_max_open_files",
+        []() { return H5Pool::get_instance().capacity(); },
+        "Get max number of MPO files kept open between calls."
+    );
+    readmpo_package.def(
+        "set_max_open_files",
+        [](std::uint64_t max_open_files) {
+            py::gil_scoped_release release;
+            H5Pool::get_instance().set_capacity(max_open_files);
+        },
+        R"(
+        Set max number of MPO files kept open between calls.
+
+        MPO files are kept open after being read, so that later calls reuse them without parsing their metadata again.
+        When the number of open files exceeds the limit, the least recently used files are closed. A file modified on
+        disk is reopened at its next use.
+
+        Parameters
+        ----------
+        max_open_files : int
+            Max number of open files. Default value is 256.)",
+        py::arg("max_open_files")
+    );
+    readmpo_package.def(
+        "close_files",
+        []() {
+            py::gil_scoped_release release;
+            H5Pool::get_instance().clear();
+        },
+        "Close all MPO files kept open between calls."
+    );
 }
 
 }  // namespace readmpo
@@ -275,4 +735,8 @@ PYBIND11_MODULE(clib, readmpo_package) {
     readmpo::wrap_master_mpo(readmpo_package);
     // wrap query_mpo
     readmpo::wrap_query_mpo(readmpo_package);
+    // wrap save_lib and load_lib
+    readmpo::wrap_lib_file(readmpo_package);
+    // wrap pool of open files
+    readmpo::wrap_h5_pool(readmpo_package);
 }
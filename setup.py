@@ -23,10 +23,11 @@ ext_options = {
 ext_options["library_dirs"] += [H5_LIB]
 if sys.platform == "linux":
     ext_options["extra_compile_args"] = ["-std=c++20", "-flto=auto", "-fno-fat-lto-objects"]
+    ext_options["extra_link_args"] = ["-fopenmp"]
     ext_options["depends"] = ["readmpo/main.cpp", "build/libreadmpo.a"]
     ext_options["runtime_library_dirs"] = [H5_LIB]
 elif sys.platform == "win32":
-    ext_options["extra_compile_args"] = ["/std:c++20"]
+    ext_options["extra_compile_args"] = ["/std:c++20", "/openmp"]
     ext_options["depends"] = ["readmpo/main.cpp", "build/readmpo.lib"]
 
 # build extension
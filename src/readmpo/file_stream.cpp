@@ -0,0 +1,95 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/file_stream.hpp"
+
+#include <ios>        // std::ios_base
+#include <stdexcept>  // std::invalid_argument, std::runtime_error
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>  // ::CreateFileA, ::CreateFileMappingA, ::MapViewOfFile, ::UnmapViewOfFile
+#else
+    #include <fcntl.h>     // ::open
+    #include <sys/mman.h>  // ::mmap, ::munmap
+    #include <sys/stat.h>  // ::fstat
+    #include <unistd.h>    // ::close
+#endif
+
+namespace readmpo {
+
+// Map a file into memory with copy-on-write
+std::shared_ptr<char[]> map_file(const std::string & fname, std::uint64_t & size) {
+#if defined(_WIN32)
+    HANDLE file = ::CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::invalid_argument("Cannot open file " + fname + "\n");
+    }
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(file, &file_size)) {
+        ::CloseHandle(file);
+        throw std::runtime_error("Cannot get size of file " + fname + "\n");
+    }
+    size = file_size.QuadPart;
+    if (size == 0) {
+        ::CloseHandle(file);
+        return std::shared_ptr<char[]>();
+    }
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    ::CloseHandle(file);
+    if (mapping == nullptr) {
+        throw std::runtime_error("Cannot map file " + fname + "\n");
+    }
+    void * data = ::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    ::CloseHandle(mapping);
+    if (data == nullptr) {
+        throw std::runtime_error("Cannot map file " + fname + "\n");
+    }
+    return std::shared_ptr<char[]>(static_cast<char *>(data), [](char * p) { ::UnmapViewOfFile(p); });
+#else
+    int file = ::open(fname.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::invalid_argument("Cannot open file " + fname + "\n");
+    }
+    struct stat file_stat;
+    if (::fstat(file, &file_stat) != 0) {
+        ::close(file);
+        throw std::runtime_error("Cannot get size of file " + fname + "\n");
+    }
+    size = file_stat.st_size;
+    if (size == 0) {
+        ::close(file);
+        return std::shared_ptr<char[]>();
+    }
+    void * data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file " + fname + "\n");
+    }
+    return std::shared_ptr<char[]>(static_cast<char *>(data), [size](char * p) { ::munmap(p, size); });
+#endif
+}
+
+// Open a file for writing, truncating it if it exists
+BufferedOfstream::BufferedOfstream(const std::string & fname, std::uint64_t buffer_size) : buffer_(buffer_size) {
+    // the buffer must be set before the file is opened
+    this->rdbuf()->pubsetbuf(this->buffer_.data(), this->buffer_.size());
+    this->open(fname.c_str(), std::ios_base::binary | std::ios_base::trunc);
+}
+
+// Flush the buffer and close the file before the buffer is released
+BufferedOfstream::~BufferedOfstream(void) {
+    if (this->is_open()) {
+        this->close();
+    }
+}
+
+// Map a file into memory
+MappedBuffer::MappedBuffer(const std::string & fname) {
+    this->mapping_ = map_file(fname, this->size_);
+    char * begin = this->mapping_.get();
+    this->setg(begin, begin, begin + this->size_);
+}
+
+}  // namespace readmpo
@@ -0,0 +1,109 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_FILE_STREAM_HPP_
+#define READMPO_FILE_STREAM_HPP_
+
+#include <cstdint>    // std::uint64_t
+#include <fstream>    // std::ofstream
+#include <istream>    // std::istream
+#include <memory>     // std::shared_ptr
+#include <streambuf>  // std::streambuf
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+namespace readmpo {
+
+/** @brief Size of the buffer of readmpo::BufferedOfstream (in bytes).*/
+inline constexpr std::uint64_t file_stream_buffer_size = 1 << 20;
+
+/** @brief Map a file into memory with copy-on-write.
+ *  @details The mapping is private, so bytes modified in memory are not written back to the file. It is released with
+ *  the last copy of the returned pointer. The pointer is null if the file is empty.
+ *  @param fname Name of the file.
+ *  @param size Size of the file in bytes.
+ */
+std::shared_ptr<char[]> map_file(const std::string & fname, std::uint64_t & size);
+
+/** @brief Binary output file stream writing through a large buffer.
+ *  @details Bytes are written to the file by chunks of the size of the buffer, instead of the size of the default
+ *  buffer of ``std::ofstream``.
+ */
+class BufferedOfstream : public std::ofstream {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Open a file for writing, truncating it if it exists.
+     *  @param fname Name of the file.
+     *  @param buffer_size Size of the buffer in bytes.
+     */
+    BufferedOfstream(const std::string & fname, std::uint64_t buffer_size = file_stream_buffer_size);
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    BufferedOfstream(const BufferedOfstream & src) = delete;
+    /** @brief Copy assignment.*/
+    BufferedOfstream & operator=(const BufferedOfstream & src) = delete;
+    /// @}
+
+    /// @name Destructor
+    /// @{
+    /** @brief Flush the buffer and close the file before the buffer is released.*/
+    ~BufferedOfstream(void);
+    /// @}
+
+  protected:
+    /** @brief Buffer of the file.*/
+    std::vector<char> buffer_;
+};
+
+/** @brief Stream buffer reading a memory-mapped file.
+ *  @details Bytes are copied from the mapping without system calls. Reading beyond the end of the file fails instead
+ *  of accessing memory outside of the mapping.
+ */
+class MappedBuffer : public std::streambuf {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Map a file into memory.*/
+    MappedBuffer(const std::string & fname);
+    /// @}
+
+    /// @name Attributes
+    /// @{
+    /** @brief Get size of the file in bytes.*/
+    std::uint64_t size(void) const noexcept { return this->size_; }
+    /// @}
+
+  protected:
+    /** @brief Mapping of the file.*/
+    std::shared_ptr<char[]> mapping_;
+    /** @brief Size of the file in bytes.*/
+    std::uint64_t size_ = 0;
+};
+
+/** @brief Input stream reading a memory-mapped file.*/
+class MappedIstream : public std::istream {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Map a file into memory.*/
+    MappedIstream(const std::string & fname) : std::istream(nullptr), buffer_(fname) { this->init(&(this->buffer_)); }
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    MappedIstream(const MappedIstream & src) = delete;
+    /** @brief Copy assignment.*/
+    MappedIstream & operator=(const MappedIstream & src) = delete;
+    /// @}
+
+  protected:
+    /** @brief Stream buffer over the mapping.*/
+    MappedBuffer buffer_;
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_FILE_STREAM_HPP_
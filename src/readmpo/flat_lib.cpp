@@ -0,0 +1,84 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/flat_lib.hpp"
+
+#include <algorithm>  // std::find
+#include <stdexcept>  // std::runtime_error
+
+#include "readmpo/h5_utils.hpp"  // readmpo::stringify
+
+namespace readmpo {
+
+// Get index of a name in a list of interned names, intern it if not yet interned
+static std::uint32_t intern(std::vector<std::string> & names, const std::string & name) {
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end()) {
+        return it - names.begin();
+    }
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+// Get ID of an isotope, intern it if not yet interned
+std::uint32_t FlatLib::isotope_id(const std::string & isotope) { return intern(this->isotopes_, isotope); }
+
+// Get ID of a reaction, intern it if not yet interned
+std::uint32_t FlatLib::reaction_id(const std::string & reaction) { return intern(this->reactions_, reaction); }
+
+// Get name of the output of an array in the library of its isotope
+std::string FlatLib::output_name(const LibKey & key) const {
+    const std::string & reaction = this->reactions_.at(key.reaction);
+    if (reaction.compare("Diffusion") == 0) {
+        return stringify(reaction, key.anisop);
+    } else if (reaction.compare("Scattering") == 0) {
+        if (key.departure == LibKey::band) {
+            return stringify(reaction, key.anisop);
+        }
+        return stringify(reaction, key.anisop, '_', key.departure, '-', key.arrival);
+    }
+    return reaction;
+}
+
+// Register an array to allocate in the arena
+void FlatLib::add(const LibKey & key, const std::vector<std::uint64_t> & shape) {
+    if (this->arena_) {
+        throw std::runtime_error("Cannot register an array after the allocation of the arena.\n");
+    }
+    if (this->offsets_.contains(key)) {
+        return;
+    }
+    std::uint64_t size = 1;
+    for (const std::uint64_t & s : shape) {
+        size *= s;
+    }
+    this->offsets_[key] = this->arena_size_;
+    this->shapes_[key] = shape;
+    this->arena_size_ += size;
+}
+
+// Allocate all registered arrays in a single zero-filled arena
+void FlatLib::allocate(void) {
+    this->arena_ = allocate_arena(this->arena_size_);
+    for (const auto & [key, offset] : this->offsets_) {
+        this->arrays_[key] = NdArray(this->arena_, offset, this->shapes_.at(key));
+    }
+    this->shapes_.clear();
+}
+
+// Insert an array after the allocation
+void FlatLib::insert(const LibKey & key, const NdArray & array) {
+    this->arrays_[key] = (array.arena()) ? array.view() : NdArray(array);
+}
+
+// Get views of all arrays, indexed by isotope name and output name
+MpoLib FlatLib::views(void) const {
+    MpoLib result;
+    for (const std::string & isotope : this->isotopes_) {
+        result[isotope];
+    }
+    for (const auto & [key, array] : this->arrays_) {
+        result[this->isotopes_[key.isotope]][this->output_name(key)] = (array.arena()) ? array.view() : NdArray(array);
+    }
+    return result;
+}
+
+}  // namespace readmpo
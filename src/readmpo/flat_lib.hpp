@@ -0,0 +1,135 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_FLAT_LIB_HPP_
+#define READMPO_FLAT_LIB_HPP_
+
+#include <compare>  // std::strong_ordering
+#include <cstdint>  // std::uint32_t, std::uint64_t
+#include <map>      // std::map
+#include <memory>   // std::shared_ptr
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include "readmpo/nd_array.hpp"  // readmpo::NdArray
+
+namespace readmpo {
+
+/** @brief Library of arrays, indexed by isotope name and name of each output of a reaction.*/
+using MpoLib = std::map<std::string, std::map<std::string, NdArray>>;
+
+/** @brief Key of an array in a flat library.*/
+struct LibKey {
+    /** @brief Interned ID of the isotope.*/
+    std::uint32_t isotope = 0;
+    /** @brief Interned ID of the reaction.*/
+    std::uint32_t reaction = 0;
+    /** @brief Anisotropy order (Diffusion and Scattering only).*/
+    std::uint32_t anisop = 0;
+    /** @brief Departure group (Scattering only).*/
+    std::uint32_t departure = 0;
+    /** @brief Arrival group (Scattering only).*/
+    std::uint32_t arrival = 0;
+
+    /** @brief Departure and arrival group of a block-sparse Scattering array containing all transfer group pairs.*/
+    static constexpr std::uint32_t band = UINT32_MAX;
+
+    /** @brief Comparison operators.*/
+    auto operator<=>(const LibKey & other) const = default;
+};
+
+/** @brief Library whose arrays are allocated from a single arena.
+ *  @details Arrays are first registered with their key and shape, then allocated at once as views into a single
+ *  zero-filled arena. The arena is released when the library and all views into it are destroyed. Arrays inserted
+ *  after the allocation are views into their own arena.
+ */
+class FlatLib {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Default constructor.*/
+    FlatLib(void) = default;
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    FlatLib(const FlatLib & src) = delete;
+    /** @brief Copy assignment.*/
+    FlatLib & operator=(const FlatLib & src) = delete;
+    /** @brief Move constructor.*/
+    FlatLib(FlatLib && src) = default;
+    /** @brief Move assignment.*/
+    FlatLib & operator=(FlatLib && src) = default;
+    /// @}
+
+    /// @name Interned names
+    /// @{
+    /** @brief Get ID of an isotope, intern it if not yet interned.*/
+    std::uint32_t isotope_id(const std::string & isotope);
+    /** @brief Get ID of a reaction, intern it if not yet interned.*/
+    std::uint32_t reaction_id(const std::string & reaction);
+    /** @brief Get interned isotopes.*/
+    const std::vector<std::string> & isotopes(void) const noexcept { return this->isotopes_; }
+    /** @brief Get interned reactions.*/
+    const std::vector<std::string> & reactions(void) const noexcept { return this->reactions_; }
+    /** @brief Get name of the output of an array in the library of its isotope.*/
+    std::string output_name(const LibKey & key) const;
+    /// @}
+
+    /// @name Allocation
+    /// @{
+    /** @brief Register an array to allocate in the arena.*/
+    void add(const LibKey & key, const std::vector<std::uint64_t> & shape);
+    /** @brief Get shape of each registered array (cleared by the allocation).*/
+    const std::map<LibKey, std::vector<std::uint64_t>> & shapes(void) const noexcept { return this->shapes_; }
+    /** @brief Allocate all registered arrays in a single zero-filled arena.*/
+    void allocate(void);
+    /** @brief Insert an array after the allocation.
+     *  @details The array is shared if it is a view into an arena, and copied otherwise.
+     */
+    void insert(const LibKey & key, const NdArray & array);
+    /// @}
+
+    /// @name Access
+    /// @{
+    /** @brief Check if an array is in the library.*/
+    bool contains(const LibKey & key) const { return this->arrays_.contains(key); }
+    /** @brief Get reference to an array.*/
+    NdArray & at(const LibKey & key) { return this->arrays_.at(key); }
+    /** @brief Get arrays of the library.*/
+    const std::map<LibKey, NdArray> & arrays(void) const noexcept { return this->arrays_; }
+    /** @brief Get offset table of arrays in the arena (in number of elements).*/
+    const std::map<LibKey, std::uint64_t> & offsets(void) const noexcept { return this->offsets_; }
+    /** @brief Get pointer to the arena.*/
+    const double * arena(void) const noexcept { return this->arena_.get(); }
+    /** @brief Get number of elements in the arena.*/
+    std::uint64_t arena_size(void) const noexcept { return this->arena_size_; }
+    /// @}
+
+    /// @name Conversion
+    /// @{
+    /** @brief Get views of all arrays, indexed by isotope name and output name.
+     *  @details Each interned isotope has an entry, even if it has no array.
+     */
+    MpoLib views(void) const;
+    /// @}
+
+  protected:
+    /** @brief Interned isotope names.*/
+    std::vector<std::string> isotopes_;
+    /** @brief Interned reaction names.*/
+    std::vector<std::string> reactions_;
+    /** @brief Offset of each array registered in the arena.*/
+    std::map<LibKey, std::uint64_t> offsets_;
+    /** @brief Shape of each array registered in the arena.*/
+    std::map<LibKey, std::vector<std::uint64_t>> shapes_;
+    /** @brief Arrays of the library.*/
+    std::map<LibKey, NdArray> arrays_;
+    /** @brief Arena containing registered arrays.*/
+    std::shared_ptr<double[]> arena_;
+    /** @brief Number of elements in the arena.*/
+    std::uint64_t arena_size_ = 0;
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_FLAT_LIB_HPP_
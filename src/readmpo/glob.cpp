@@ -1,113 +1,203 @@
 // Copyright 2022 quocdang1998
 #include "readmpo/glob.hpp"
 
-#include <cctype>      // std::isalnum
-#include <cstddef>     // std::size_t
-#include <filesystem>  // std::filesystem
-#include <regex>       // std::regex, std::regex::ECMAScript, std::regex_match
+#include <algorithm>     // std::sort, std::unique
+#include <cstddef>       // std::size_t
+#include <filesystem>    // std::filesystem
+#include <system_error>  // std::error_code
 
 namespace readmpo {
 
-// Replace a string
-static bool string_replace(std::string & str, const std::string & substring, const std::string & destination) {
-    auto start_pos = str.find(substring);
-    if (start_pos == std::string::npos) {
-        return false;
+// Match a character against the set of a bracket expression starting after "[", return the position after "]"
+static std::size_t match_bracket(char c, const std::string & pattern, std::size_t begin, bool & matched) {
+    std::size_t i = begin, n = pattern.size();
+    bool negated = (i < n) && (pattern[i] == '!' || pattern[i] == '^');
+    if (negated) {
+        ++i;
     }
-    str.replace(start_pos, substring.length(), destination);
-    return true;
+    // a "]" right after the opening bracket is a member of the set
+    bool in_set = false, first = true;
+    while (i < n && (first || pattern[i] != ']')) {
+        first = false;
+        char low = pattern[i], high = low;
+        if (i + 2 < n && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            high = pattern[i + 2];
+            i += 3;
+        } else {
+            i += 1;
+        }
+        in_set |= (low <= c && c <= high);
+    }
+    if (i >= n) {
+        // unclosed bracket
+        return std::string::npos;
+    }
+    matched = (in_set != negated);
+    return i + 1;
 }
 
-// Glob to regex
-static std::string glob_to_regex(const std::string & pattern) {
-    std::size_t i = 0, j, n = pattern.size();
-    std::string result_string;
-
-    while (i < n) {
-        char c = pattern[i++];
-        switch (c) {
-            case '*' :
-                result_string += ".*";
-                break;
-            case '?' :
-                result_string += ".";
-                break;
-            case '[' :
-                j = i;
-                // skip "[]" and "[!]" (pattern with zero size)
-                if (j < n && pattern[j] == '!') {
-                    ++j;
-                }
-                if (j < n && pattern[j] == ']') {
-                    ++j;
-                }
-                // find the closing "]"
-                while (j < n && pattern[j] != ']') {
-                    ++j;
-                }
-                if (j < n) {
-                    std::string stuff = std::string(&pattern[i], j - i);
-                    string_replace(stuff, "\\", "\\\\");
-                    char first_char = pattern[i];
-                    i = j + 1;
-                    result_string += "[";
-                    switch (first_char) {
-                        case '!' :
-                            result_string += "^" + stuff.substr(1);
-                            break;
-                        case '^' :
-                            result_string += "\\" + stuff;
-                            break;
-                        default :
-                            result_string += stuff;
+// Check if a name matches a wildcard pattern
+bool match_wildcard(const std::string & name, const std::string & pattern) {
+    // greedy matching, backtracking to the last "*" on mismatch
+    std::size_t i_name = 0, i_pattern = 0;
+    std::size_t star_pattern = std::string::npos, star_name = 0;
+    while (i_name < name.size()) {
+        if (i_pattern < pattern.size()) {
+            char p = pattern[i_pattern];
+            if (p == '*') {
+                star_pattern = i_pattern++;
+                star_name = i_name;
+                continue;
+            }
+            if (p == '?') {
+                i_pattern++;
+                i_name++;
+                continue;
+            }
+            if (p == '[') {
+                bool matched = false;
+                std::size_t next = match_bracket(name[i_name], pattern, i_pattern + 1, matched);
+                if (next == std::string::npos) {
+                    // unclosed bracket is a literal character
+                    if (name[i_name] == '[') {
+                        i_pattern++;
+                        i_name++;
+                        continue;
                     }
-                    result_string += "]";
-                } else {
-                    result_string += "\\[";
-                }
-                break;
-            default :
-                if (std::isalnum(c)) {
-                    result_string += c;
-                } else {
-                    result_string += "\\";
-                    result_string += c;
+                } else if (matched) {
+                    i_pattern = next;
+                    i_name++;
+                    continue;
                 }
+            } else if (p == name[i_name]) {
+                i_pattern++;
+                i_name++;
+                continue;
+            }
         }
+        // mismatch: let the last "*" absorb one more character
+        if (star_pattern == std::string::npos) {
+            return false;
+        }
+        i_pattern = star_pattern + 1;
+        i_name = ++star_name;
+    }
+    // remaining pattern must only be "*"
+    while (i_pattern < pattern.size() && pattern[i_pattern] == '*') {
+        i_pattern++;
     }
-    // assert end of string
-    return "^" + result_string + "$";
+    return i_pattern == pattern.size();
 }
 
-// Check if current pathname contains wilcard characters
-static bool has_magic(const std::string & pathname) {
-    static const std::regex magic_check = std::regex("([*?[])");
-    return std::regex_search(pathname, magic_check);
+// Check if a pattern contains wildcard characters
+static bool has_magic(const std::string & pattern) { return pattern.find_first_of("*?[") != std::string::npos; }
+
+// Join a directory and a name, an empty directory denotes the current directory
+static std::string join_path(const std::string & directory, const std::string & name) {
+    if (directory.empty()) {
+        return name;
+    }
+    return (directory.back() == '/') ? directory + name : directory + "/" + name;
+}
+
+// List the entries of a directory matching a component, sorted by name (unreadable directories are skipped)
+static std::vector<std::string> list_matches(const std::string & directory, const std::string & component,
+                                             bool directories_only, bool follow_symlinks = true) {
+    std::vector<std::string> names;
+    std::error_code ec;
+    std::filesystem::directory_iterator it(directory.empty() ? "." : directory, ec);
+    for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (!match_wildcard(name, component)) {
+            continue;
+        }
+        if (!follow_symlinks && it->is_symlink(ec)) {
+            continue;
+        }
+        if (directories_only && !it->is_directory(ec)) {
+            continue;
+        }
+        names.push_back(std::move(name));
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// Append a directory and all of its subdirectories (symbolic links are not followed, so that cycles are not walked)
+static void list_subdirectories(const std::string & directory, std::vector<std::string> & result) {
+    result.push_back(directory);
+    for (const std::string & name : list_matches(directory, "*", true, false)) {
+        list_subdirectories(join_path(directory, name), result);
+    }
 }
 
 // Get list of files satisfying the pattern
 std::vector<std::string> glob(const std::string & pattern) {
-    // get base path
-    std::filesystem::path base_path(pattern);
-    while (has_magic(base_path.string())) {
-        base_path = base_path.parent_path();
-    }
-    if (base_path.empty()) {
-        base_path = std::filesystem::current_path();
+    // pattern without wildcards is returned as is
+    if (!has_magic(pattern)) {
+        if (std::filesystem::is_directory(pattern)) {
+            return std::vector<std::string>();
+        }
+        return std::vector<std::string>(1, pattern);
     }
-    // filter path with given pattern
-    std::vector<std::string> result;
-    if (!std::filesystem::is_directory(base_path)) {
-        result.push_back(base_path.string());
-        return result;
+    // split pattern into components
+    std::vector<std::string> components;
+    std::size_t begin = (pattern.front() == '/') ? 1 : 0;
+    while (begin <= pattern.size()) {
+        std::size_t end = pattern.find('/', begin);
+        if (end == std::string::npos) {
+            end = pattern.size();
+        }
+        if (end > begin) {
+            components.push_back(pattern.substr(begin, end - begin));
+        }
+        begin = end + 1;
     }
-    std::regex regex_pattern(glob_to_regex(pattern), std::regex::ECMAScript);
-    for (const std::filesystem::directory_entry & d_entry : std::filesystem::recursive_directory_iterator(base_path)) {
-        if (std::regex_match(d_entry.path().string(), regex_pattern)) {
-            result.push_back(d_entry.path().string());
+    // match each component in the directories matched by the previous ones
+    std::vector<std::string> paths(1, (pattern.front() == '/') ? "/" : "");
+    for (std::size_t i_comp = 0; i_comp < components.size(); i_comp++) {
+        const std::string & component = components[i_comp];
+        bool is_last = (i_comp == components.size() - 1);
+        std::vector<std::string> next_paths;
+        for (const std::string & path : paths) {
+            if (component == "**" && is_last) {
+                // regular files of zero or more directories, as directories are not MPO files
+                std::vector<std::string> directories;
+                list_subdirectories(path, directories);
+                for (const std::string & directory : directories) {
+                    for (const std::string & name : list_matches(directory, "*", false)) {
+                        std::string file_path = join_path(directory, name);
+                        std::error_code ec;
+                        if (std::filesystem::is_regular_file(file_path, ec)) {
+                            next_paths.push_back(std::move(file_path));
+                        }
+                    }
+                }
+            } else if (component == "**") {
+                // zero or more directories
+                list_subdirectories(path, next_paths);
+            } else if (!has_magic(component)) {
+                // literal component is checked without listing the directory
+                std::string next_path = join_path(path, component);
+                std::error_code ec;
+                bool exists = (is_last) ? std::filesystem::exists(next_path, ec)
+                                        : std::filesystem::is_directory(next_path, ec);
+                if (exists) {
+                    next_paths.push_back(std::move(next_path));
+                }
+            } else {
+                for (const std::string & name : list_matches(path, component, !is_last)) {
+                    next_paths.push_back(join_path(path, name));
+                }
+            }
         }
+        paths = std::move(next_paths);
     }
-    return result;
+    // the current directory is not a file name, and several "**" may match the same path
+    std::erase_if(paths, [](const std::string & path) { return path.empty(); });
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    return paths;
 }
 
 }  // namespace readmpo
@@ -7,7 +7,21 @@
 
 namespace readmpo {
 
-/** @brief Get list of files matching a certain pattern.*/
+/** @brief Check if a name matches a wildcard pattern.
+ *  @details ``*`` matches any sequence of characters, ``?`` matches any character, ``[...]`` matches a character in
+ *  the set (``a-z`` denotes a range), and ``[!...]`` or ``[^...]`` matches a character not in the set. An unclosed
+ *  ``[`` matches itself.
+ */
+bool match_wildcard(const std::string & name, const std::string & pattern);
+
+/** @brief Get list of files matching a certain pattern.
+ *  @details The pattern is matched one path component at a time: only directories matching a component are listed
+ *  for the next one, so that the directories not covered by the pattern are never visited. Wildcards of a component
+ *  never match ``/``, and a component ``**`` matches zero or more directories (symbolic links to directories are not
+ *  followed by ``**``, so that cycles are never walked). A trailing ``**`` matches the regular files of these
+ *  directories only. A pattern without wildcards is returned as is if it is not a directory. Matched paths are
+ *  sorted.
+ */
 std::vector<std::string> glob(const std::string & pattern);
 
 }  // namespace readmpo
@@ -0,0 +1,108 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/h5_pool.hpp"
+
+#include <iterator>  // std::prev
+
+#include "readmpo/h5_utils.hpp"   // readmpo::lock_h5
+#include "readmpo/mpo_index.hpp"  // readmpo::get_fingerprint
+#include "readmpo/profile.hpp"    // readmpo::record_open
+
+namespace readmpo {
+
+// Get the pool shared by all MPO files
+H5Pool & H5Pool::get_instance(void) {
+    // never destroyed, as files must not be closed after the termination of the HDF5 library at exit
+    static H5Pool * instance = new H5Pool();
+    return *instance;
+}
+
+// Get max number of open files kept in the pool
+std::uint64_t H5Pool::capacity(void) {
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    return this->capacity_;
+}
+
+// Set max number of open files kept in the pool
+void H5Pool::set_capacity(std::uint64_t capacity) {
+    auto h5_lock = lock_h5();
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    this->capacity_ = capacity;
+    this->evict(capacity);
+}
+
+// Get number of open files
+std::uint64_t H5Pool::size(void) {
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    return this->lru_list_.size();
+}
+
+// Get handle to an open file
+std::shared_ptr<H5Handle> H5Pool::acquire(const std::string & fname) {
+    auto h5_lock = lock_h5();
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    std::pair<std::uint64_t, std::int64_t> fingerprint = get_fingerprint(fname);
+    auto it = this->entries_.find(fname);
+    if (it != this->entries_.end()) {
+        if (it->second->second->fingerprint == fingerprint) {
+            // move to the front of the list
+            this->lru_list_.splice(this->lru_list_.begin(), this->lru_list_, it->second);
+            std::shared_ptr<H5Handle> handle = this->lru_list_.front().second;
+            this->evict(this->capacity_);
+            return handle;
+        }
+        // file modified since opened, users of the former handle keep it until they release it
+        this->lru_list_.erase(it->second);
+        this->entries_.erase(it);
+    }
+    // open file
+    std::shared_ptr<H5Handle> handle = std::make_shared<H5Handle>();
+    handle->file = H5::H5File(fname.c_str(), H5F_ACC_RDONLY);
+    record_open();
+    handle->fingerprint = fingerprint;
+    this->lru_list_.emplace_front(fname, handle);
+    this->entries_[fname] = this->lru_list_.begin();
+    this->evict(this->capacity_);
+    return handle;
+}
+
+// Get pointer to a group of an acquired file
+H5::Group * H5Pool::open_group(H5Handle & handle, const std::string & group_name) {
+    auto h5_lock = lock_h5();
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    auto it = handle.groups.find(group_name);
+    if (it == handle.groups.end()) {
+        it = handle.groups.emplace(group_name, handle.file.openGroup(group_name.c_str())).first;
+        record_open();
+    }
+    return &(it->second);
+}
+
+// Release a handle to the pool
+void H5Pool::release(std::shared_ptr<H5Handle> & handle) {
+    auto h5_lock = lock_h5();
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    handle.reset();
+    this->evict(this->capacity_);
+}
+
+// Close all files not in use
+void H5Pool::clear(void) {
+    auto h5_lock = lock_h5();
+    std::lock_guard<std::mutex> pool_lock(this->mutex_);
+    this->evict(0);
+}
+
+// Close least recently used files not in use
+void H5Pool::evict(std::uint64_t capacity) {
+    auto it = this->lru_list_.end();
+    while ((this->lru_list_.size() > capacity) && (it != this->lru_list_.begin())) {
+        it = std::prev(it);
+        if (it->second.use_count() > 1) {
+            continue;
+        }
+        this->entries_.erase(it->first);
+        it = this->lru_list_.erase(it);
+    }
+}
+
+}  // namespace readmpo
@@ -0,0 +1,96 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_H5_POOL_HPP_
+#define READMPO_H5_POOL_HPP_
+
+#include <cstdint>  // std::int64_t, std::uint64_t
+#include <list>     // std::list
+#include <map>      // std::map
+#include <memory>   // std::shared_ptr
+#include <mutex>    // std::mutex
+#include <string>   // std::string
+#include <utility>  // std::pair
+
+#include <H5Cpp.h>  // H5::Group, H5::H5File
+
+namespace readmpo {
+
+/** @brief Open HDF5 file in read-only mode, together with its opened groups.*/
+struct H5Handle {
+    /** @brief HDF5 file.*/
+    H5::H5File file;
+    /** @brief Groups opened in the file.*/
+    std::map<std::string, H5::Group> groups;
+    /** @brief Size and last modification time of the file when opened.*/
+    std::pair<std::uint64_t, std::int64_t> fingerprint;
+};
+
+/** @brief Pool of HDF5 files opened in read-only mode, shared by all MPO files.
+ *  @details Files are kept open after being released, so that later calls reuse them without parsing the superblock
+ *  and the B-trees again. When the number of open files exceeds the capacity, the least recently used files no longer
+ *  in use are closed. A file modified since it was opened is reopened at the next acquisition.
+ */
+class H5Pool {
+  public:
+    /// @name Instance
+    /// @{
+    /** @brief Get the pool shared by all MPO files.*/
+    static H5Pool & get_instance(void);
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    H5Pool(const H5Pool & src) = delete;
+    /** @brief Copy assignment.*/
+    H5Pool & operator=(const H5Pool & src) = delete;
+    /// @}
+
+    /// @name Attributes
+    /// @{
+    /** @brief Get max number of open files kept in the pool.*/
+    std::uint64_t capacity(void);
+    /** @brief Set max number of open files kept in the pool, and close least recently used files exceeding it.
+     *  @details Files in use are never closed, so the number of open files may temporarily exceed the capacity.
+     */
+    void set_capacity(std::uint64_t capacity);
+    /** @brief Get number of open files.*/
+    std::uint64_t size(void);
+    /// @}
+
+    /// @name Acquire
+    /// @{
+    /** @brief Get handle to an open file, the file is opened if not yet in the pool.
+     *  @details The file is in use until all copies of the returned pointer are released.
+     */
+    std::shared_ptr<H5Handle> acquire(const std::string & fname);
+    /** @brief Get pointer to a group of an acquired file, the group is opened if not yet opened.*/
+    H5::Group * open_group(H5Handle & handle, const std::string & group_name);
+    /** @brief Release a handle to the pool, the file is kept open until evicted.*/
+    void release(std::shared_ptr<H5Handle> & handle);
+    /// @}
+
+    /// @name Close
+    /// @{
+    /** @brief Close all files not in use.*/
+    void clear(void);
+    /// @}
+
+  protected:
+    /** @brief Default constructor.*/
+    H5Pool(void) = default;
+    /** @brief Close least recently used files not in use until the number of open files fits in the capacity.*/
+    void evict(std::uint64_t capacity);
+
+    /** @brief Open files, from the most to the least recently used.*/
+    std::list<std::pair<std::string, std::shared_ptr<H5Handle>>> lru_list_;
+    /** @brief Map from filename to its position in the list.*/
+    std::map<std::string, std::list<std::pair<std::string, std::shared_ptr<H5Handle>>>::iterator> entries_;
+    /** @brief Max number of open files.*/
+    std::uint64_t capacity_ = 256;
+    /** @brief Mutex protecting the pool.*/
+    std::mutex mutex_;
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_H5_POOL_HPP_
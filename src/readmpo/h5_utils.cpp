@@ -1,12 +1,17 @@
 // Copyright 2023 quocdang1998
 #include "readmpo/h5_utils.hpp"
 
-#include <algorithm>  // std::find_if
+#include <algorithm>  // std::find_if, std::max, std::partition_point, std::sort, std::unique
 #include <cmath>      // std::round
 #include <cctype>     // std::isspace
+#include <exception>  // std::current_exception, std::exception_ptr, std::rethrow_exception
 #include <locale>     // std::locale
+#include <map>        // std::map
+#include <numeric>    // std::iota
 #include <stdexcept>  // std::invalid_argument
 
+#include <omp.h>  // ::omp_get_max_threads
+
 namespace readmpo {
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -18,6 +23,23 @@ void print_process(const double & percent) {
     std::printf("\r\033[FProcessed %u%%\n", unsigned(std::round(100.f * percent)));
 }
 
+// Sort values and remove each value close to the previous kept value
+void sort_unique_near(std::vector<double> & values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end(), is_near), values.end());
+}
+
+// Find the first element close to a value in a sorted vector by binary search
+std::uint64_t find_near(const std::vector<double> & sorted_values, const double & value) {
+    // elements below the range of close elements are the only ones smaller than and not close to the value
+    auto it = std::partition_point(sorted_values.begin(), sorted_values.end(),
+                                   [&value](const double & x) { return (x < value) && !is_near(x, value); });
+    if ((it == sorted_values.end()) || !is_near(*it, value)) {
+        return sorted_values.size();
+    }
+    return it - sorted_values.begin();
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Utils for HDF5 read
 // ---------------------------------------------------------------------------------------------------------------------
@@ -25,15 +47,8 @@ void print_process(const double & percent) {
 // List all subgroups and dataset in a group
 std::vector<std::string> ls_groups(H5::Group * group, const char * substring) {
     // function retrieving the name of subgroups and datasets in a given group
-    auto get_name = [](hid_t loc_id, char const * name, const H5L_info_t * info, void * operator_data) {
-        H5O_info_t infobuf;
-#if H5Oget_info_by_name_vers < 2
-        H5Oget_info_by_name(loc_id, name, &infobuf, H5P_DEFAULT);
-#else
-        H5Oget_info_by_name(loc_id, name, &infobuf, H5O_INFO_BASIC, H5P_DEFAULT);
-#endif  // H5Oget_info_by_name_vers
+    auto get_name = [](hid_t, char const * name, const H5L_info_t *, void * operator_data) {
         auto * ptr_data = static_cast<std::vector<std::string> *>(operator_data);
-        std::string element_name(name);
         ptr_data->push_back(std::string(name));
         return 0;
     };
@@ -49,6 +64,36 @@ std::vector<std::string> ls_groups(H5::Group * group, const char * substring) {
     return result;
 }
 
+// Get shape of an HDF dataset without reading its data
+std::vector<std::uint64_t> get_dset_shape(H5::Group * group, const char * dset_address) {
+    static_assert(sizeof(hsize_t) == sizeof(std::uint64_t), "Expected 64-bit hsize_t.");
+    H5::DataSet dset = group->openDataSet(dset_address);
+    record_open();
+    H5::DataSpace dspace = dset.getSpace();
+    std::vector<std::uint64_t> shape(dspace.getSimpleExtentNdims());
+    dspace.getSimpleExtentDims(reinterpret_cast<hsize_t *>(shape.data()));
+    dset.close();
+    return shape;
+}
+
+// Sort and merge overlapping or adjacent ranges
+std::vector<std::pair<std::uint64_t, std::uint64_t>> merge_ranges(
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> && ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> merged_ranges;
+    for (const auto & [begin, end] : ranges) {
+        if (begin >= end) {
+            continue;
+        }
+        if (!merged_ranges.empty() && (begin <= merged_ranges.back().second)) {
+            merged_ranges.back().second = std::max(merged_ranges.back().second, end);
+        } else {
+            merged_ranges.push_back(std::make_pair(begin, end));
+        }
+    }
+    return merged_ranges;
+}
+
 // ---------------------------------------------------------------------------------------------------------------------
 // Utils for string
 // ---------------------------------------------------------------------------------------------------------------------
@@ -98,6 +143,84 @@ std::uint64_t ndim_to_c_idx(const std::vector<std::uint64_t> & index, const std:
     return c_index;
 }
 
+// ---------------------------------------------------------------------------------------------------------------------
+// Utils for parallel execution
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Acquire the lock serializing HDF5 calls across threads
+std::unique_lock<H5Mutex> lock_h5(void) {
+    static H5Mutex h5_mutex;
+    return std::unique_lock<H5Mutex>(h5_mutex);
+}
+
+// Get number of threads to use
+std::uint64_t get_n_threads(std::uint64_t n_threads) {
+    if (n_threads == 0) {
+        return ::omp_get_max_threads();
+    }
+    return n_threads;
+}
+
+// Execute a function on each index in a range in parallel
+void parallel_for(std::uint64_t n_items, std::uint64_t n_threads, const std::function<void(std::uint64_t)> & function) {
+    std::exception_ptr exception = nullptr;
+    IoCounters * io_counters = current_io_counters();
+    std::int64_t n_loop = static_cast<std::int64_t>(n_items);
+    #pragma omp parallel for schedule(dynamic) num_threads(get_n_threads(n_threads))
+    for (std::int64_t i_item = 0; i_item < n_loop; i_item++) {
+        IoScope io_scope(io_counters);
+        try {
+            function(static_cast<std::uint64_t>(i_item));
+        } catch (...) {
+            #pragma omp critical (readmpo_parallel_for_exception)
+            exception = std::current_exception();
+        }
+    }
+    if (exception != nullptr) {
+        std::rethrow_exception(exception);
+    }
+}
+
+// Find root of an item in a disjoint set
+static std::uint64_t find_root(std::vector<std::uint64_t> & parent, std::uint64_t item) {
+    while (parent[item] != item) {
+        parent[item] = parent[parent[item]];
+        item = parent[item];
+    }
+    return item;
+}
+
+// Group items writing to a common position in the output
+std::vector<std::vector<std::uint64_t>> group_conflicts(
+    const std::vector<std::vector<std::vector<std::uint64_t>>> & positions) {
+    // merge items sharing a position (the root of each set is its smallest item)
+    std::vector<std::uint64_t> parent(positions.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    std::map<std::vector<std::uint64_t>, std::uint64_t> first_writer;
+    for (std::uint64_t i_item = 0; i_item < positions.size(); i_item++) {
+        for (const std::vector<std::uint64_t> & position : positions[i_item]) {
+            auto [it, inserted] = first_writer.insert({position, i_item});
+            if (inserted) {
+                continue;
+            }
+            std::uint64_t root_1 = find_root(parent, it->second), root_2 = find_root(parent, i_item);
+            parent[std::max(root_1, root_2)] = std::min(root_1, root_2);
+        }
+    }
+    // collect items of each set
+    std::vector<std::vector<std::uint64_t>> groups;
+    std::vector<std::uint64_t> group_idx(positions.size(), UINT64_MAX);
+    for (std::uint64_t i_item = 0; i_item < positions.size(); i_item++) {
+        std::uint64_t root = find_root(parent, i_item);
+        if (group_idx[root] == UINT64_MAX) {
+            group_idx[root] = groups.size();
+            groups.push_back(std::vector<std::uint64_t>());
+        }
+        groups[group_idx[root]].push_back(i_item);
+    }
+    return groups;
+}
+
 }  // namespace readmpo
 
 #include "readmpo/h5_utils.tpp"
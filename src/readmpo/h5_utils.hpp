@@ -5,13 +5,18 @@
 #include <algorithm>  // std::copy, std::min
 #include <cmath>      // std::abs
 #include <cstdint>    // std::uint64_t
+#include <functional>  // std::function
 #include <iterator>   // std::ostream_iterator
+#include <mutex>      // std::mutex, std::recursive_mutex, std::unique_lock
 #include <string>     // std::string
 #include <utility>    // std::pair
 #include <vector>     // std::vector
 
 #include <H5Cpp.h>  // H5::Group
 
+#include "readmpo/profile.hpp"  // readmpo::IoScope, readmpo::current_io_counters, readmpo::record_open,
+                                 // readmpo::record_read
+
 namespace readmpo {
 
 // Common utils
@@ -22,6 +27,21 @@ inline bool is_near(const double & a, const double & b) {
     return (std::abs(a - b) <= 1e-6 + 1e-5 * std::abs(std::min(a, b)));
 };
 
+/** @brief Sort values and remove each value close to the previous kept value.
+ *  @details readmpo::is_near is not transitive: for ``a < b < c`` with ``b`` close to both ``a`` and ``c`` but ``a``
+ *  not close to ``c``, ``b`` is removed while ``a`` and ``c`` are both kept. The result only depends on the set of
+ *  values, not on their order.
+ */
+void sort_unique_near(std::vector<double> & values);
+
+/** @brief Find the first element close to a value in a sorted vector by binary search.
+ *  @details Elements close to a value form a contiguous range of a sorted vector, so the first one is found in
+ *  logarithmic time. If the value is close to several elements (like ``b`` in the chain of
+ *  readmpo::sort_unique_near), the smallest one is returned.
+ *  @return Index of the found element, or the size of the vector if no element is close to the value.
+ */
+std::uint64_t find_near(const std::vector<double> & sorted_values, const double & value);
+
 // Stream operator
 template <typename T>
 std::ostream & operator<<(std::ostream & os, const std::vector<T> & v) {
@@ -37,11 +57,47 @@ void print_process(const double & percent);
 // -------------------
 
 /** @brief Get data from an HDF dataset in form of an ``std::vector``.
+ *  @details The opening and the read of the dataset are recorded to the I/O counters of the calling thread, as in
+ *  readmpo::read_dset and readmpo::read_dset_ranges.
  *  @returns Contiguous array of data, and the shape of data.
  */
 template <typename T>
 std::pair<std::vector<T>, std::vector<std::uint64_t>> get_dset(H5::Group * group, const char * dset_address);
 
+/** @brief Read data of a numeric HDF dataset into caller-owned buffers.
+ *  @details Buffers are resized to the size of the dataset, their memory is reused if their capacity is large enough.
+ *  @param group Pointer to the parent group.
+ *  @param dset_address Address of the dataset relative to the group.
+ *  @param data Buffer receiving C-contiguous data.
+ *  @param shape Buffer receiving the shape of data.
+ */
+template <typename T>
+void read_dset(H5::Group * group, const char * dset_address, std::vector<T> & data,
+               std::vector<std::uint64_t> & shape);
+
+/** @brief Read elements inside some ranges of a 1D HDF dataset of floating point values into a caller-owned buffer.
+ *  @details Only elements inside the ranges are read from the file. The buffer is resized to the size of the whole
+ *  dataset and elements are placed at their position in the dataset. Elements outside the ranges are left unchanged
+ *  if they were already in the buffer, and zero otherwise.
+ *  @param group Pointer to the parent group.
+ *  @param dset_address Address of the dataset relative to the group.
+ *  @param ranges Sorted and disjoint ranges ``[begin, end)`` of elements to read. Elements out of the dataset are
+ *  ignored.
+ *  @param data Buffer receiving data.
+ */
+template <typename T>
+void read_dset_ranges(H5::Group * group, const char * dset_address,
+                      const std::vector<std::pair<std::uint64_t, std::uint64_t>> & ranges, std::vector<T> & data);
+
+/** @brief Sort and merge overlapping or adjacent ranges ``[begin, end)``, empty ranges are removed.*/
+std::vector<std::pair<std::uint64_t, std::uint64_t>> merge_ranges(
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> && ranges);
+
+/** @brief Get shape of an HDF dataset without reading its data.
+ *  @details The opening of the dataset is recorded to the I/O counters of the calling thread.
+ */
+std::vector<std::uint64_t> get_dset_shape(H5::Group * group, const char * dset_address);
+
 /** @brief List all subgroups and dataset of an HDF group, if their name contains the substring.*/
 std::vector<std::string> ls_groups(H5::Group * group, const char * substring = "");
 
@@ -77,6 +133,55 @@ std::string stringify(const Args &... args);
  */
 std::uint64_t ndim_to_c_idx(const std::vector<std::uint64_t> & index, const std::vector<std::uint64_t> & shape);
 
+// Utils for parallel execution
+// ----------------------------
+
+/** @brief Mutex serializing HDF5 calls across threads.
+ *  @details The lock is taken whether or not the HDF5 library is built thread-safe, as the thread-safe build only
+ *  protects the C API, not the ``H5::`` C++ wrappers (objects, their reference counting and the state of
+ *  ``H5::Exception``). Only code calling the C API directly on identifiers no other thread closes may skip the lock
+ *  with a thread-safe build.
+ */
+using H5Mutex = std::recursive_mutex;
+
+/** @brief Mutex that can be moved along with the object it guards.
+ *  @details Moving creates a new unlocked mutex instead of moving the lock state, so that both the moved-from and the
+ *  moved-to objects stay usable.
+ */
+struct MovableMutex : std::mutex {
+    MovableMutex(void) = default;
+    MovableMutex(MovableMutex &&) noexcept : std::mutex() {}
+    MovableMutex & operator=(MovableMutex &&) noexcept { return *this; }
+};
+
+/** @brief Acquire the lock serializing HDF5 calls across threads.
+ *  @details Every call through the HDF5 C++ API, including the construction, copy and destruction of ``H5::``
+ *  objects, must hold the lock.
+ */
+std::unique_lock<H5Mutex> lock_h5(void);
+
+/** @brief Get number of threads to use from a user provided value.
+ *  @details Value ``0`` means all threads available for OpenMP.
+ */
+std::uint64_t get_n_threads(std::uint64_t n_threads);
+
+/** @brief Execute a function on each index in a range in parallel.
+ *  @details Exceptions thrown in each thread are caught and the last one is rethrown after the parallel loop. I/O
+ *  operations of each thread are recorded to the I/O counters of the calling thread.
+ *  @param n_items Number of items.
+ *  @param n_threads Number of threads (``0`` means all available threads).
+ *  @param function Function taking the index of an item as argument.
+ */
+void parallel_for(std::uint64_t n_items, std::uint64_t n_threads, const std::function<void(std::uint64_t)> & function);
+
+/** @brief Group items writing to a common position in the output.
+ *  @details Items in different groups write to disjoint positions, so groups can be processed concurrently. Items in
+ *  each group are sorted by their index, and groups are sorted by their first item.
+ *  @param positions List of positions each item writes to.
+ */
+std::vector<std::vector<std::uint64_t>> group_conflicts(
+    const std::vector<std::vector<std::vector<std::uint64_t>>> & positions);
+
 }  // namespace readmpo
 
 #include "readmpo/h5_utils.tpp"
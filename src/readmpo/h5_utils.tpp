@@ -2,8 +2,10 @@
 #ifndef READMPO_H5_UTILS_TPP_
 #define READMPO_H5_UTILS_TPP_
 
-#include <sstream>    // std::ostringstream
-#include <stdexcept>  // std::runtime_error
+#include <algorithm>    // std::min
+#include <sstream>      // std::ostringstream
+#include <stdexcept>    // std::runtime_error
+#include <type_traits>  // std::is_arithmetic_v, std::is_floating_point_v, std::is_integral_v, std::is_same_v
 
 namespace readmpo {
 
@@ -11,19 +13,9 @@ namespace readmpo {
 // Utils for HDF5 read
 // ---------------------------------------------------------------------------------------------------------------------
 
-// Get data from an HDF dataset in form of an ``std::vector``
+// Check type of elements of an HDF dataset
 template <typename T>
-std::pair<std::vector<T>, std::vector<std::uint64_t>> get_dset(H5::Group * group, const char * dset_address) {
-    // open dataset
-    H5::DataSet dset = group->openDataSet(dset_address);
-    // get data shape
-    H5::DataSpace dspace = dset.getSpace();
-    std::uint64_t ndims = dspace.getSimpleExtentNdims();
-    std::vector<hsize_t> shape(ndims);
-    dspace.getSimpleExtentDims(shape.data());
-    // get size of an element
-    std::uint64_t element_size = dset.getDataType().getSize();
-    // check size of data if not std::string
+void check_dset_type(const H5::DataSet & dset, std::uint64_t element_size) {
     ::H5T_class_t type_class = dset.getTypeClass();
     if constexpr (std::is_same_v<T, std::string>) {
         if (type_class != H5T_STRING) {
@@ -44,26 +36,97 @@ std::pair<std::vector<T>, std::vector<std::uint64_t>> get_dset(H5::Group * group
             throw std::runtime_error("Incorrect float type provided to the template.\n");
         }
     }
-    // read data to a buffer
-    std::uint64_t npoint = dspace.getSimpleExtentNpoints();
-    std::vector<T> data(npoint);
+}
+
+// Get data from an HDF dataset in form of an ``std::vector``
+template <typename T>
+std::pair<std::vector<T>, std::vector<std::uint64_t>> get_dset(H5::Group * group, const char * dset_address) {
+    std::vector<T> data;
+    std::vector<std::uint64_t> data_shape;
     if constexpr (std::is_same_v<T, std::string>) {
+        // open dataset
+        H5::DataSet dset = group->openDataSet(dset_address);
+        record_open();
+        // get data shape
+        H5::DataSpace dspace = dset.getSpace();
+        data_shape.resize(dspace.getSimpleExtentNdims());
+        dspace.getSimpleExtentDims(reinterpret_cast<hsize_t *>(data_shape.data()));
+        // check type of data
+        std::uint64_t element_size = dset.getDataType().getSize();
+        check_dset_type<T>(dset, element_size);
         // read data to buffer
+        std::uint64_t npoint = dspace.getSimpleExtentNpoints();
         std::vector<char> buffer(element_size * npoint);
         dset.read(buffer.data(), dset.getDataType());
+        record_read(buffer.size());
         // convert to vector of std::string
+        data.resize(npoint);
         for (int i = 0; i < npoint; i++) {
             data[i].assign(buffer.data() + i * element_size, element_size);
         }
+        dset.close();
     } else {
-        // read data directly
-        dset.read(data.data(), dset.getDataType());
+        read_dset(group, dset_address, data, data_shape);
+    }
+    return std::pair<std::vector<T>, std::vector<std::uint64_t>>(std::move(data), std::move(data_shape));
+}
+
+// Read data of an HDF dataset into caller-owned buffers
+template <typename T>
+void read_dset(H5::Group * group, const char * dset_address, std::vector<T> & data,
+               std::vector<std::uint64_t> & shape) {
+    static_assert(std::is_arithmetic_v<T>, "Only numeric datasets are supported.");
+    static_assert(sizeof(hsize_t) == sizeof(std::uint64_t), "Expected 64-bit hsize_t.");
+    // open dataset
+    H5::DataSet dset = group->openDataSet(dset_address);
+    record_open();
+    // get data shape
+    H5::DataSpace dspace = dset.getSpace();
+    shape.resize(dspace.getSimpleExtentNdims());
+    dspace.getSimpleExtentDims(reinterpret_cast<hsize_t *>(shape.data()));
+    // check type of data
+    H5::DataType dtype = dset.getDataType();
+    check_dset_type<T>(dset, dtype.getSize());
+    // read data directly to the buffer
+    data.resize(dspace.getSimpleExtentNpoints());
+    dset.read(data.data(), dtype);
+    record_read(data.size() * sizeof(T));
+    dset.close();
+}
+
+// Read elements inside some ranges of a 1D HDF dataset of floating point values into a caller-owned buffer
+template <typename T>
+void read_dset_ranges(H5::Group * group, const char * dset_address,
+                      const std::vector<std::pair<std::uint64_t, std::uint64_t>> & ranges, std::vector<T> & data) {
+    static_assert(std::is_floating_point_v<T>, "Only floating point datasets are supported.");
+    // open dataset
+    H5::DataSet dset = group->openDataSet(dset_address);
+    record_open();
+    H5::DataSpace dspace = dset.getSpace();
+    if (dspace.getSimpleExtentNdims() != 1) {
+        throw std::runtime_error("Expected a 1D dataset.\n");
+    }
+    // check type of data
+    H5::DataType dtype = dset.getDataType();
+    check_dset_type<T>(dset, dtype.getSize());
+    // select ranges inside the dataset
+    std::uint64_t npoint = dspace.getSimpleExtentNpoints();
+    data.resize(npoint);
+    bool empty_selection = true;
+    for (const auto & [begin, end] : ranges) {
+        hsize_t start = begin, count = std::min(end, npoint) - std::min(begin, npoint);
+        if (count == 0) {
+            continue;
+        }
+        dspace.selectHyperslab((empty_selection) ? H5S_SELECT_SET : H5S_SELECT_OR, &count, &start);
+        empty_selection = false;
+    }
+    // read selected elements to the same position in memory
+    if (!empty_selection) {
+        dset.read(data.data(), dtype, dspace, dspace);
+        record_read(dspace.getSelectNpoints() * sizeof(T));
     }
-    // close dataset
     dset.close();
-    // convert shape to intvec
-    std::vector<std::uint64_t> data_shape(shape.begin(), shape.end());
-    return std::pair<std::vector<T>, std::vector<std::uint64_t>>(data, data_shape);
 }
 
 // ---------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,214 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/lib_file.hpp"
+
+#include <array>      // std::array
+#include <bit>        // std::endian
+#include <cstdint>    // std::uint64_t
+#include <cstring>    // std::memcmp, std::memcpy
+#include <fstream>    // std::ofstream
+#include <limits>     // std::numeric_limits
+#include <memory>     // std::shared_ptr
+#include <stdexcept>  // std::invalid_argument, std::runtime_error
+#include <vector>     // std::vector
+
+#include "readmpo/file_stream.hpp"  // readmpo::map_file
+#include "readmpo/h5_utils.hpp"     // readmpo::stringify
+#include "readmpo/nd_array.hpp"     // readmpo::NdArray
+
+namespace readmpo {
+
+// Magic bytes at the beginning of a library file
+static constexpr char lib_file_magic[8] = {'R', 'M', 'P', 'O', 'L', 'I', 'B', '\0'};
+
+// Version of the library file format
+static constexpr std::uint64_t lib_file_version = 1;
+
+// Size of the header and alignment of data blocks (in bytes)
+static constexpr std::uint64_t lib_file_alignment = 64;
+
+// Data type of elements, in the notation of Numpy
+static constexpr const char * lib_file_dtype = (std::endian::native == std::endian::little) ? "<f8" : ">f8";
+
+// Header of a library file
+struct LibFileHeader {
+    char magic[8];
+    std::uint64_t version;
+    std::uint64_t n_arrays;
+    std::uint64_t toc_offset;
+    std::uint64_t toc_size;
+    std::uint64_t file_size;
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(LibFileHeader) == lib_file_alignment, "Expected a 64-byte header.");
+
+// Round up a size to the alignment of data blocks
+static std::uint64_t align_size(std::uint64_t size) {
+    return (size + lib_file_alignment - 1) / lib_file_alignment * lib_file_alignment;
+}
+
+// Append an integer to a buffer
+static void append_int(std::vector<char> & buffer, std::uint64_t value) {
+    const char * bytes = reinterpret_cast<const char *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(std::uint64_t));
+}
+
+// Append a string prefixed by its length to a buffer
+static void append_str(std::vector<char> & buffer, const std::string & value) {
+    append_int(buffer, value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+// Max number of elements of an array, so that its number of bytes fits in an integer
+static constexpr std::uint64_t max_n_elements = std::numeric_limits<std::uint64_t>::max() / sizeof(double);
+
+// Cursor reading the table of contents of a mapped file with bound check
+struct TocReader {
+    const char * begin;
+    std::uint64_t size;
+    std::uint64_t position = 0;
+
+    // Check that some bytes are available
+    void require(std::uint64_t n_bytes) {
+        if (n_bytes > this->size - this->position) {
+            throw std::runtime_error("Truncated table of contents.\n");
+        }
+    }
+    // Check that an array of integers is available
+    void require_array(std::uint64_t n_ints) {
+        if (n_ints > (this->size - this->position) / sizeof(std::uint64_t)) {
+            throw std::runtime_error("Truncated table of contents.\n");
+        }
+    }
+    // Read an integer
+    std::uint64_t read_int(void) {
+        this->require(sizeof(std::uint64_t));
+        std::uint64_t value;
+        std::memcpy(&value, this->begin + this->position, sizeof(std::uint64_t));
+        this->position += sizeof(std::uint64_t);
+        return value;
+    }
+    // Read a string prefixed by its length
+    std::string read_str(void) {
+        std::uint64_t length = this->read_int();
+        this->require(length);
+        std::string value(this->begin + this->position, length);
+        this->position += length;
+        return value;
+    }
+};
+
+// Save all arrays of a library to a single indexed file
+void save_lib(const std::string & fname, const MpoLib & lib) {
+    // calculate size of the table of contents
+    std::uint64_t n_arrays = 0, toc_size = 0;
+    for (const auto & [isotope, iso_lib] : lib) {
+        for (const auto & [output, array] : iso_lib) {
+            n_arrays++;
+            toc_size += 4 * sizeof(std::uint64_t) + isotope.size() + output.size() + std::strlen(lib_file_dtype);
+            toc_size += (array.ndim() + 2) * sizeof(std::uint64_t);
+        }
+    }
+    // build table of contents with the offset of each data block
+    std::vector<char> toc;
+    toc.reserve(toc_size);
+    std::uint64_t offset = align_size(sizeof(LibFileHeader) + toc_size);
+    for (const auto & [isotope, iso_lib] : lib) {
+        for (const auto & [output, array] : iso_lib) {
+            append_str(toc, isotope);
+            append_str(toc, output);
+            append_str(toc, lib_file_dtype);
+            append_int(toc, array.ndim());
+            for (const std::uint64_t & s : array.shape()) {
+                append_int(toc, s);
+            }
+            append_int(toc, offset);
+            append_int(toc, array.size() * sizeof(double));
+            offset = align_size(offset + array.size() * sizeof(double));
+        }
+    }
+    // write header and table of contents
+    std::ofstream outfile(fname.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    if (!outfile) {
+        throw std::invalid_argument("Cannot open file " + fname + "\n");
+    }
+    LibFileHeader header = {};
+    std::memcpy(header.magic, lib_file_magic, sizeof(lib_file_magic));
+    header.version = lib_file_version;
+    header.n_arrays = n_arrays;
+    header.toc_offset = sizeof(LibFileHeader);
+    header.toc_size = toc_size;
+    header.file_size = offset;
+    outfile.write(reinterpret_cast<const char *>(&header), sizeof(LibFileHeader));
+    outfile.write(toc.data(), toc.size());
+    // write data blocks, padded to the alignment
+    std::array<char, lib_file_alignment> padding = {};
+    std::uint64_t position = sizeof(LibFileHeader) + toc_size;
+    for (const auto & [isotope, iso_lib] : lib) {
+        for (const auto & [output, array] : iso_lib) {
+            outfile.write(padding.data(), align_size(position) - position);
+            array.write_data(outfile);
+            position = align_size(position) + array.size() * sizeof(double);
+        }
+    }
+    outfile.write(padding.data(), align_size(position) - position);
+    if (!outfile) {
+        throw std::runtime_error("Error while writing file " + fname + "\n");
+    }
+    outfile.close();
+}
+
+// Map a library file saved by readmpo::save_lib into memory
+MpoLib load_lib(const std::string & fname) {
+    // map file and check header
+    std::uint64_t file_size;
+    std::shared_ptr<char[]> file_mapping = map_file(fname, file_size);
+    if (file_size < sizeof(LibFileHeader)) {
+        throw std::runtime_error("File " + fname + " is too small to be a library file.\n");
+    }
+    const char * file_data = file_mapping.get();
+    std::shared_ptr<double[]> mapping(file_mapping, reinterpret_cast<double *>(file_mapping.get()));
+    LibFileHeader header;
+    std::memcpy(&header, file_data, sizeof(LibFileHeader));
+    if (std::memcmp(header.magic, lib_file_magic, sizeof(lib_file_magic)) != 0) {
+        throw std::runtime_error("File " + fname + " is not a library file.\n");
+    }
+    if (header.version != lib_file_version) {
+        throw std::runtime_error(stringify("Unsupported version ", header.version, " of library file ", fname, ".\n"));
+    }
+    if ((header.file_size != file_size) || (header.toc_offset > file_size) ||
+        (header.toc_size > file_size - header.toc_offset)) {
+        throw std::runtime_error("Library file " + fname + " is truncated.\n");
+    }
+    // create a view for each entry of the table of contents
+    MpoLib result;
+    TocReader toc = {file_data + header.toc_offset, header.toc_size};
+    for (std::uint64_t i_array = 0; i_array < header.n_arrays; i_array++) {
+        std::string isotope = toc.read_str();
+        std::string output = toc.read_str();
+        std::string dtype = toc.read_str();
+        if (dtype.compare(lib_file_dtype) != 0) {
+            throw std::runtime_error(stringify("Unsupported data type ", dtype, " of ", isotope, "/", output, ".\n"));
+        }
+        // check the number of dimensions against the remaining bytes before allocating the shape
+        std::uint64_t ndim = toc.read_int();
+        toc.require_array(ndim);
+        std::vector<std::uint64_t> shape(ndim);
+        // number of elements, an overflowing product cannot match the size of the data block
+        std::uint64_t size = 1;
+        bool overflow = false;
+        for (std::uint64_t & s : shape) {
+            s = toc.read_int();
+            overflow = overflow || ((s != 0) && (size > max_n_elements / s));
+            size *= s;
+        }
+        std::uint64_t offset = toc.read_int(), n_bytes = toc.read_int();
+        if (overflow || (offset % lib_file_alignment != 0) || (n_bytes != size * sizeof(double)) ||
+            (offset > file_size) || (n_bytes > file_size - offset)) {
+            throw std::runtime_error(stringify("Invalid data block of ", isotope, "/", output, ".\n"));
+        }
+        result[isotope][output] = NdArray(mapping, offset / sizeof(double), shape);
+    }
+    return result;
+}
+
+}  // namespace readmpo
@@ -0,0 +1,29 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_LIB_FILE_HPP_
+#define READMPO_LIB_FILE_HPP_
+
+#include <string>  // std::string
+
+#include "readmpo/flat_lib.hpp"  // readmpo::MpoLib
+
+namespace readmpo {
+
+/** @brief Save all arrays of a library to a single indexed file.
+ *  @details The file starts with a 64-byte header, followed by a table of contents giving the isotope name, the output
+ *  name, the data type, the shape and the byte offset of each array. Data of each array is stored in C-contiguous order
+ *  in a block aligned to 64 bytes.
+ *  @param fname Name of the file.
+ *  @param lib Library to save.
+ */
+void save_lib(const std::string & fname, const MpoLib & lib);
+
+/** @brief Map a library file saved by readmpo::save_lib into memory.
+ *  @details Arrays are views into the mapped file, without copy. The mapping is private, so elements modified in
+ *  memory are not written back to the file. It is released once all arrays are destroyed.
+ *  @param fname Name of the file.
+ */
+MpoLib load_lib(const std::string & fname);
+
+}  // namespace readmpo
+
+#endif  // READMPO_LIB_FILE_HPP_
@@ -3,19 +3,30 @@
 #include <iostream>  // std::cout
 #include <iterator>  // std::make_move_iterator
 #include <filesystem>  // std::filesystem::exists
+#include <fstream>   // std::ifstream
+#include <sstream>   // std::istringstream
 #include <string>    // std::string
+#include <vector>    // std::vector
 
 #include "readmpo/glob.hpp"        // readmpo::glob
+#include "readmpo/h5_pool.hpp"     // readmpo::H5Pool
 #include "readmpo/h5_utils.hpp"    // readmpo::stringify
+#include "readmpo/lib_file.hpp"    // readmpo::save_lib
 #include "readmpo/master_mpo.hpp"  // readmpo::MasterMpo
-#include "readmpo/query_mpo.hpp"   // readmpo::query_mpo
+#include "readmpo/profile.hpp"     // readmpo::Phase, readmpo::PhaseTimer
+#include "readmpo/query_mpo.hpp"   // readmpo::metadata_json, readmpo::query_mpo_metadata
 
 const char * help_message = R"(Retrieve microscopic cross-section from an MPO.
 Options:
     Help mode:
         -h, --help: Print help message.
-    Query mode: get names of geometries and energy meshes presenting in the MPO.
-        -q, --query: Query the MPO
+    Query mode: print metadata of each MPO (geometries, energy meshes, number of zones and groups, number of values of
+        each parameter, isotopes and reactions) as JSON. Files are read concurrently, and only their metadata is read.
+        -q, --query: Query the MPO.
+        -g, --geometry: Name of geometry each MPO must contain (optional). Isotopes and reactions are those of its
+            output if the energy mesh is also given.
+        -e, --energy-mesh: Name of energy mesh each MPO must contain (optional).
+        -t, --threads: Number of threads reading MPO files concurrently (0 for all available threads). Default: 0.
     Get data from MPO:
         -g, --geometry: Name of geometry.
         -e, --energy-mesh: Name of energy mesh.
@@ -28,19 +39,71 @@ Options:
             1: macro
             2: zoneflux
             3: reaction rate.
+        -mao, --maxanisop: Max anisotropy order to retrieve for Diffusion and Scattering. Default: 1.
+        -d, --defer-validset: Discover valid set of isotopes while reading cross sections instead of at
+            construction of the master MPO (single pass over state points and zones).
+        -t, --threads: Number of threads reading MPO files or state points concurrently (0 for all available
+            threads). Default: 0.
+        -lf, --libfile: Name of a single indexed file inside the output folder to save all arrays to, instead of one
+            file per output.
+        -es, --expand-scattering: Write Scattering to one file per transfer group pair instead of one block-sparse
+            file per anisotropy order (band structure saved in ScatteringProfile).
+        -s, --stream: Name of an HDF5 file inside the output folder to write cross sections to one state point at a
+            time, so that the library is never held in memory as a whole.
+        -mc, --memory-cap: Max memory (in MiB) of cross sections held in memory in stream mode. Default: 1024.
+        -mf, --max-open-files: Max number of MPO files kept open at the same time. Default: 256.
+        -b, --batch: Name of a batch file of requests, retrieved in a single pass over the MPO files. Each non-empty
+            line is a request made of the options -i, -r, -sk, -xs, -mao and -es, separated by spaces. Outputs of
+            the request at line k (counted from 0 over non-empty lines) are prefixed by "request<k>_". Options -i,
+            -r, -sk, -xs, -mao and -es on the command line are ignored.
+        -p, --profile: Print wall time of each phase and I/O counters of each MPO file and in total as JSON at the
+            end of the execution.
 Result:
-    Serialized arrays of homogenized cross-section, which can be read with merlin::array::Stock.
+    Serialized arrays of homogenized cross-section, which can be read with merlin::array::Stock, a single library
+    file, which can be memory-mapped with readmpo::load_lib, or an HDF5 file with one dataset per output.
 )";
 
+// Parse a request of a batch file
+static readmpo::XsRequest parse_request(const std::string & line) {
+    readmpo::XsRequest request;
+    std::istringstream tokens(line);
+    std::string argument, value;
+    while (tokens >> argument) {
+        if (!argument.compare("-es") || !argument.compare("--expand-scattering")) {
+            request.expand_scattering = true;
+            continue;
+        }
+        if (!(tokens >> value)) {
+            throw std::runtime_error("Missing value of option " + argument + " in batch file.\n");
+        }
+        if (!argument.compare("-i") || !argument.compare("--iso")) {
+            request.isotopes.push_back(value);
+        } else if (!argument.compare("-r") || !argument.compare("--reac")) {
+            request.reactions.push_back(value);
+        } else if (!argument.compare("-sk") || !argument.compare("--skipdims")) {
+            request.skipped_dims.push_back(value);
+        } else if (!argument.compare("-xs") || !argument.compare("--type")) {
+            request.type = static_cast<readmpo::XsType>(std::atoi(value.c_str()));
+        } else if (!argument.compare("-mao") || !argument.compare("--maxanisop")) {
+            request.max_anisop_order = std::atoi(value.c_str());
+        } else {
+            throw std::runtime_error("Unknown option " + argument + " in batch file.\n");
+        }
+    }
+    return request;
+}
+
 int main(int argc, char * argv[]) {
     using namespace readmpo;
     // parse argument
     unsigned int mode = 0;
     unsigned int xstype = 0;
     std::uint64_t max_anisotropy_order = 1;
-    std::string geometry, energymesh, output_folder = ".";
+    std::uint64_t n_threads = 0;
+    std::uint64_t memory_cap = 1024;
+    std::string geometry, energymesh, output_folder = ".", libfile_name, stream_name, batch_name;
     std::vector<std::string> filenames, isotopes, reactions, skipped_dims;
-    bool reload = false;
+    bool reload = false, defer_valid_set = false, expand_scattering = false, profile = false;
     std::string mastermpo_name = "master_mpo.txt";
     for (int i = 1; i < argc; i++) {
         std::string argument(argv[i]);
@@ -72,6 +135,33 @@ int main(int argc, char * argv[]) {
         } else if (!argument.compare("-mao") || !argument.compare("--maxanisop")) {
             max_anisotropy_order = std::atoi(argv[++i]);
             mode |= 4;
+        } else if (!argument.compare("-t") || !argument.compare("--threads")) {
+            n_threads = std::atol(argv[++i]);
+            mode |= 4;
+        } else if (!argument.compare("-d") || !argument.compare("--defer-validset")) {
+            defer_valid_set = true;
+            mode |= 4;
+        } else if (!argument.compare("-lf") || !argument.compare("--libfile")) {
+            libfile_name = std::string(argv[++i]);
+            mode |= 4;
+        } else if (!argument.compare("-es") || !argument.compare("--expand-scattering")) {
+            expand_scattering = true;
+            mode |= 4;
+        } else if (!argument.compare("-s") || !argument.compare("--stream")) {
+            stream_name = std::string(argv[++i]);
+            mode |= 4;
+        } else if (!argument.compare("-mc") || !argument.compare("--memory-cap")) {
+            memory_cap = std::atol(argv[++i]);
+            mode |= 4;
+        } else if (!argument.compare("-mf") || !argument.compare("--max-open-files")) {
+            H5Pool::get_instance().set_capacity(std::atol(argv[++i]));
+            mode |= 4;
+        } else if (!argument.compare("-b") || !argument.compare("--batch")) {
+            batch_name = std::string(argv[++i]);
+            mode |= 4;
+        } else if (!argument.compare("-p") || !argument.compare("--profile")) {
+            profile = true;
+            mode |= 4;
         } else if (!argument.compare("-l") || !argument.compare("--reload")) {
             reload = true;
             mode |= 4;
@@ -87,15 +177,9 @@ int main(int argc, char * argv[]) {
         std::cout << help_message;
         return 0;
     }
-    // query mode
-    if (mode == 2) {
-        for (std::string & fname : filenames) {
-            std::cout << "Filename: " << fname << "\n";
-            std::map<std::string, std::vector<std::string>> queried_list = query_mpo(fname);
-            for (auto & [key, values] : queried_list) {
-                std::cout << "    " << key << ": " << values << "\n";
-            }
-        }
+    // query mode (geometry, energy mesh and number of threads are accepted as options)
+    if ((mode & 3) == 2) {
+        std::cout << metadata_json(query_mpo_metadata(filenames, geometry, energymesh, n_threads));
         return 0;
     }
     // construct master MPO and retrieve data
@@ -107,15 +191,66 @@ int main(int argc, char * argv[]) {
             }
             master_mpo.deserialize(mastermpo_name);
         } else {
-            master_mpo = MasterMpo(filenames, geometry, energymesh);
+            master_mpo = MasterMpo(filenames, geometry, energymesh, defer_valid_set);
             master_mpo.serialize(mastermpo_name);
         }
-        MpoLib microlib = master_mpo.build_microlib_xs(isotopes, reactions, skipped_dims, static_cast<XsType>(xstype));
-        for (auto & [isotope, rlib] : microlib) {
-            for (auto & [reaction, lib] : rlib) {
-                std::string outfname = stringify(output_folder, "/", isotope, "_", reaction, ".txt");
-                lib.serialize(outfname);
+        if (!batch_name.empty()) {
+            std::ifstream batch_file(batch_name);
+            if (!batch_file.is_open()) {
+                throw std::runtime_error("Unable to open batch file " + batch_name + ".\n");
+            }
+            std::vector<XsRequest> requests;
+            for (std::string line; std::getline(batch_file, line);) {
+                if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                    requests.push_back(parse_request(line));
+                }
             }
+            std::vector<MpoLib> microlibs = master_mpo.build_microlib_batch(requests, "log.txt", n_threads);
+            if (defer_valid_set) {
+                // save valid set discovered during extraction
+                master_mpo.serialize(mastermpo_name);
+            }
+            PhaseTimer timer = master_mpo.time_phase(Phase::Serialization);
+            for (std::uint64_t i_request = 0; i_request < microlibs.size(); i_request++) {
+                if (!libfile_name.empty()) {
+                    save_lib(stringify(output_folder, "/request", i_request, "_", libfile_name), microlibs[i_request]);
+                    continue;
+                }
+                for (auto & [isotope, rlib] : microlibs[i_request]) {
+                    for (auto & [reaction, lib] : rlib) {
+                        lib.serialize(stringify(output_folder, "/request", i_request, "_", isotope, "_", reaction,
+                                                ".txt"));
+                    }
+                }
+            }
+        } else if (!stream_name.empty()) {
+            master_mpo.stream_microlib_xs(stringify(output_folder, "/", stream_name), isotopes, reactions, skipped_dims,
+                                          static_cast<XsType>(xstype), max_anisotropy_order, "log.txt", n_threads,
+                                          expand_scattering, memory_cap << 20);
+            // save valid set computed before streaming
+            master_mpo.serialize(mastermpo_name);
+        } else {
+            MpoLib microlib = master_mpo.build_microlib_xs(isotopes, reactions, skipped_dims,
+                                                           static_cast<XsType>(xstype), max_anisotropy_order,
+                                                           "log.txt", n_threads, expand_scattering);
+            if (defer_valid_set) {
+                // save valid set discovered during extraction
+                master_mpo.serialize(mastermpo_name);
+            }
+            PhaseTimer timer = master_mpo.time_phase(Phase::Serialization);
+            if (!libfile_name.empty()) {
+                save_lib(stringify(output_folder, "/", libfile_name), microlib);
+            } else {
+                for (auto & [isotope, rlib] : microlib) {
+                    for (auto & [reaction, lib] : rlib) {
+                        std::string outfname = stringify(output_folder, "/", isotope, "_", reaction, ".txt");
+                        lib.serialize(outfname);
+                    }
+                }
+            }
+        }
+        if (profile) {
+            std::cout << master_mpo.profile().json();
         }
         return 0;
     }
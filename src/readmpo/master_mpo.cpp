@@ -1,23 +1,43 @@
 // Copyright 2023 quocdang1998
 #include "readmpo/master_mpo.hpp"
 
-#include <algorithm>  // std::copy, std::find, std::set_union, std::sort, std::unique
+#include <algorithm>  // std::any_of, std::copy, std::equal, std::find, std::find_if, std::lower_bound, std::max,
+                      // std::merge, std::min, std::set_union, std::sort, std::upper_bound
+#include <filesystem>  // std::filesystem::exists
 #include <fstream>
 #include <iomanip>
 #include <iostream>  // std::cout
 #include <iterator>  // std::back_inserter
+#include <mutex>     // std::lock_guard
 #include <set>       // std::set
-#include <sstream>   // std::ostringstream
+#include <sstream>   // std::istringstream, std::ostringstream
 #include <utility>   // std::move
 
-#include "readmpo/h5_utils.hpp"    // readmpo::is_near
-#include "readmpo/serializer.hpp"  // readmpo::serialize_obj, readmpo::deserialize_obj
+#include "readmpo/file_stream.hpp"  // readmpo::BufferedOfstream, readmpo::MappedIstream
+#include "readmpo/h5_utils.hpp"     // readmpo::sort_unique_near, readmpo::stringify, readmpo::get_n_threads,
+                                    // readmpo::group_conflicts, readmpo::parallel_for, readmpo::find_near,
+                                    // readmpo::lowercase
+#include "readmpo/serializer.hpp"   // readmpo::serialize_obj, readmpo::deserialize_obj
 
 namespace readmpo {
 
+// Tag at the beginning of a serialized master MPO followed by metadata of its MPO files
+static const std::string serialization_tag = "readmpo::MasterMpo";
+
+// Version of the serialized master MPO
+static constexpr std::uint64_t serialization_version = 1;
+
+// Check if a serialized master MPO can be read
+static void check_serialization_version(std::uint64_t version) {
+    if (version != serialization_version) {
+        throw std::runtime_error(stringify("Unsupported version ", version, " of serialized master MPO (expected ",
+                                           serialization_version, ").\n"));
+    }
+}
+
 // Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh
 MasterMpo::MasterMpo(const std::vector<std::string> & mpofile_list, const std::string & geometry,
-                     const std::string & energy_mesh) :
+                     const std::string & energy_mesh, bool defer_valid_set) :
 geometry_(geometry), energy_mesh_(energy_mesh) {
     // check for non empty geometry and isotope
     if (geometry.empty()) {
@@ -30,42 +50,46 @@ geometry_(geometry), energy_mesh_(energy_mesh) {
     if (mpofile_list.size() == 0) {
         throw std::invalid_argument("Empty MPO file list.\n");
     }
+    IoScope io_scope(this->io_counters_.get());
     this->mpofiles_.reserve(mpofile_list.size());
     // save each mpo to vector
-    for (const std::string & mpofile_name : mpofile_list) {
-        // save each mpo
-        this->mpofiles_.push_back(SingleMpo(mpofile_name, geometry, energy_mesh));
-        if (this->n_zone_ == 0) {
-            this->n_zone_ = this->mpofiles_.back().n_zones;
-        } else {
-            if (this->n_zone_ != this->mpofiles_.back().n_zones) {
-                throw std::invalid_argument("Inconsistent geometry across MPOs.\n");
+    {
+        PhaseTimer timer = this->time_phase(Phase::Open);
+        for (const std::string & mpofile_name : mpofile_list) {
+            // save each mpo
+            this->mpofiles_.push_back(SingleMpo(mpofile_name, geometry, energy_mesh));
+            if (this->n_zone_ == 0) {
+                this->n_zone_ = this->mpofiles_.back().n_zones;
+            } else {
+                if (this->n_zone_ != this->mpofiles_.back().n_zones) {
+                    throw std::invalid_argument("Inconsistent geometry across MPOs.\n");
+                }
             }
         }
     }
     // construct master parameter space
-    for (SingleMpo & mpofile : this->mpofiles_) {
-        // get pspace of each file
-        std::map<std::string, std::vector<double>> file_pspace = mpofile.get_state_params();
-        // merge each parameter to the master parameter
-        for (auto & [pname, pvalues] : file_pspace) {
-            // add name of parameter of not added
-            if (!this->master_pspace_.contains(pname)) {
-                this->master_pspace_[pname] = std::vector<double>();
+    {
+        PhaseTimer timer = this->time_phase(Phase::PspaceMerge);
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            // get pspace of each file
+            std::map<std::string, std::vector<double>> file_pspace = mpofile.get_state_params();
+            // gather values of each parameter
+            for (auto & [pname, pvalues] : file_pspace) {
+                std::vector<double> & master_values = this->master_pspace_[pname];
+                master_values.insert(master_values.end(), pvalues.begin(), pvalues.end());
             }
-            // merge 2 ranges
-            std::copy(pvalues.begin(), pvalues.end(), std::back_inserter(this->master_pspace_[pname]));
-            std::sort(this->master_pspace_[pname].begin(), this->master_pspace_[pname].end());
-            auto last = std::unique(this->master_pspace_[pname].begin(), this->master_pspace_[pname].end(), is_near);
-            this->master_pspace_[pname].erase(last, this->master_pspace_[pname].end());
         }
-    }
-    for (auto & [name, value] : this->master_pspace_) {
-        std::cout << name << "(" << value.size() << ") : " << value << "\n";
-    }
-    // calculate global index from local index
-    for (SingleMpo & mpofile : this->mpofiles_) {
-        mpofile.construct_global_idx_map(this->master_pspace_);
+        for (auto & [pname, pvalues] : this->master_pspace_) {
+            // sort once and merge close values
+            sort_unique_near(pvalues);
+        }
+        for (auto & [name, value] : this->master_pspace_) {
+            std::cout << name << "(" << value.size() << ") : " << value << "\n";
+        }
+        // calculate global index from local index
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            mpofile.construct_global_idx_map(this->master_pspace_);
+        }
     }
     // get list of available isotopes
     std::set<std::string> set_isotopes;
@@ -86,15 +110,21 @@ geometry_(geometry), energy_mesh_(energy_mesh) {
     for (SingleMpo & mpofile : this->mpofiles_) {
         mpofile.close();
     }
-    // get list of valid set for each isotope
-    for (std::string & isotope : this->avail_isotopes_) {
-        this->valid_set_[isotope] = ValidSet();
+    if (defer_valid_set) {
+        return;
     }
-    std::ofstream logfile("log_validset.txt");
-    for (SingleMpo & mpofile : this->mpofiles_) {
-        mpofile.reopen();
-        mpofile.get_valid_set(this->valid_set_, logfile);
-        mpofile.close();
+    // get list of valid set for each isotope
+    {
+        PhaseTimer timer = this->time_phase(Phase::ValidSet);
+        for (std::string & isotope : this->avail_isotopes_) {
+            this->valid_set_[isotope] = ValidSet();
+        }
+        std::ofstream logfile("log_validset.txt");
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            mpofile.reopen();
+            mpofile.get_valid_set(this->valid_set_, logfile);
+            mpofile.close();
+        }
     }
     std::cout << "Anisotropy order for each isotope(\n";
     std::cout << "isotope              max-diffsion-anisop-order max-scattering-anisop-order valid-in-out-idx-group\n";
@@ -120,11 +150,327 @@ std::vector<std::string> MasterMpo::get_mpo_fnames(void) const {
     return mpo_fnames;
 }
 
+// Add MPO files
+void MasterMpo::add_files(const std::vector<std::string> & mpofile_list, bool defer_valid_set) {
+    // check for constructed master MPO and files not yet added
+    if (this->mpofiles_.empty()) {
+        throw std::runtime_error("Cannot add MPO files to an empty master MPO.\n");
+    }
+    std::set<std::string> fnames;
+    for (const SingleMpo & mpofile : this->mpofiles_) {
+        fnames.insert(mpofile.fname());
+    }
+    for (const std::string & mpofile_name : mpofile_list) {
+        if (!fnames.insert(mpofile_name).second) {
+            throw std::invalid_argument(stringify("MPO file ", mpofile_name, " is already in the master MPO.\n"));
+        }
+    }
+    IoScope io_scope(this->io_counters_.get());
+    // open new files
+    std::vector<SingleMpo> new_files;
+    new_files.reserve(mpofile_list.size());
+    {
+        PhaseTimer timer = this->time_phase(Phase::Open);
+        for (const std::string & mpofile_name : mpofile_list) {
+            new_files.push_back(SingleMpo(mpofile_name, this->geometry_, this->energy_mesh_));
+            if (this->n_zone_ != new_files.back().n_zones) {
+                throw std::invalid_argument("Inconsistent geometry across MPOs.\n");
+            }
+        }
+    }
+    // insert values of new files absent from the master parameter space (the master MPO is updated only after all
+    // reads from the new files succeed)
+    std::map<std::string, std::vector<double>> merged_pspace = this->master_pspace_;
+    bool pspace_changed = false;
+    std::vector<std::vector<std::uint64_t>> new_global_idx;
+    {
+        PhaseTimer timer = this->time_phase(Phase::PspaceMerge);
+        std::map<std::string, std::vector<double>> inserted_pspace;
+        for (SingleMpo & mpofile : new_files) {
+            std::map<std::string, std::vector<double>> file_pspace = mpofile.get_state_params();
+            if (!std::equal(file_pspace.begin(), file_pspace.end(), this->master_pspace_.begin(),
+                            this->master_pspace_.end(),
+                            [](const auto & file_param, const auto & master_param) {
+                                return file_param.first == master_param.first;
+                            })) {
+                throw std::invalid_argument(stringify("Parameters of MPO file ", mpofile.fname(),
+                                                      " differ from those of the master MPO.\n"));
+            }
+            for (auto & [pname, pvalues] : file_pspace) {
+                const std::vector<double> & master_values = this->master_pspace_.at(pname);
+                std::vector<double> & inserted_values = inserted_pspace[pname];
+                for (const double & value : pvalues) {
+                    if (find_near(master_values, value) == master_values.size()) {
+                        inserted_values.push_back(value);
+                    }
+                }
+            }
+        }
+        // merge inserted values and get the new global index of each former value
+        for (auto & [pname, master_values] : merged_pspace) {
+            std::vector<double> & inserted_values = inserted_pspace[pname];
+            sort_unique_near(inserted_values);
+            std::vector<double> merged_values;
+            merged_values.reserve(master_values.size() + inserted_values.size());
+            std::merge(master_values.begin(), master_values.end(), inserted_values.begin(), inserted_values.end(),
+                       std::back_inserter(merged_values));
+            std::vector<std::uint64_t> & dim_global_idx = new_global_idx.emplace_back(master_values.size());
+            for (std::uint64_t i_value = 0; i_value < master_values.size(); i_value++) {
+                auto it = std::lower_bound(merged_values.begin(), merged_values.end(), master_values[i_value]);
+                dim_global_idx[i_value] = it - merged_values.begin();
+            }
+            pspace_changed = pspace_changed || !inserted_values.empty();
+            master_values = std::move(merged_values);
+        }
+        // calculate global index of new files
+        for (SingleMpo & mpofile : new_files) {
+            mpofile.construct_global_idx_map(merged_pspace);
+        }
+    }
+    // merge available isotopes and reactions
+    std::set<std::string> set_isotopes(this->avail_isotopes_.begin(), this->avail_isotopes_.end());
+    std::set<std::string> set_reactions(this->avail_reactions_.begin(), this->avail_reactions_.end());
+    std::map<std::string, ValidSet> merged_valid_set = this->valid_set_;
+    for (SingleMpo & mpofile : new_files) {
+        for (const std::string & isotope : mpofile.get_isotopes()) {
+            if (set_isotopes.insert(isotope).second && !defer_valid_set) {
+                merged_valid_set[isotope] = ValidSet();
+            }
+        }
+        std::vector<std::string> mpo_reactions = mpofile.get_reactions();
+        set_reactions.insert(mpo_reactions.begin(), mpo_reactions.end());
+    }
+    // update known valid sets with new files
+    if (!merged_valid_set.empty()) {
+        PhaseTimer timer = this->time_phase(Phase::ValidSet);
+        std::ofstream logfile("log_validset.txt", std::ios::app);
+        for (SingleMpo & mpofile : new_files) {
+            mpofile.get_valid_set(merged_valid_set, logfile);
+        }
+    }
+    // commit: shift global index of former files and append new files
+    for (SingleMpo & mpofile : new_files) {
+        mpofile.close();
+    }
+    if (pspace_changed) {
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            mpofile.remap_global_idx(new_global_idx);
+        }
+    }
+    this->master_pspace_ = std::move(merged_pspace);
+    this->avail_isotopes_.assign(set_isotopes.begin(), set_isotopes.end());
+    this->avail_reactions_.assign(set_reactions.begin(), set_reactions.end());
+    this->valid_set_ = std::move(merged_valid_set);
+    for (SingleMpo & mpofile : new_files) {
+        this->mpofiles_.push_back(std::move(mpofile));
+    }
+    this->statept_locations_.clear();
+    this->query_cache_.clear();
+}
+
+// Remove MPO files
+void MasterMpo::remove_files(const std::vector<std::string> & mpofile_list) {
+    // check for files in the master MPO
+    std::set<std::string> removed_fnames(mpofile_list.begin(), mpofile_list.end());
+    for (const std::string & mpofile_name : removed_fnames) {
+        auto it = std::find_if(this->mpofiles_.begin(), this->mpofiles_.end(),
+                               [&mpofile_name](const SingleMpo & mpofile) { return mpofile.fname() == mpofile_name; });
+        if (it == this->mpofiles_.end()) {
+            throw std::invalid_argument(stringify("MPO file ", mpofile_name, " is not in the master MPO.\n"));
+        }
+    }
+    if (removed_fnames.size() == this->mpofiles_.size()) {
+        throw std::invalid_argument("Cannot remove all MPO files of the master MPO.\n");
+    }
+    PhaseTimer timer = this->time_phase(Phase::PspaceMerge);
+    std::erase_if(this->mpofiles_,
+                  [&removed_fnames](const SingleMpo & mpofile) { return removed_fnames.contains(mpofile.fname()); });
+    // remove values of the master parameter space no longer in any file, and get the new global index of each value
+    bool pspace_changed = false;
+    std::vector<std::vector<std::uint64_t>> new_global_idx;
+    std::uint64_t global_idim = 0;
+    for (auto & [pname, master_values] : this->master_pspace_) {
+        std::vector<bool> is_used(master_values.size(), false);
+        for (const SingleMpo & mpofile : this->mpofiles_) {
+            for (const std::uint64_t & global_idx : mpofile.global_idx(global_idim)) {
+                is_used[global_idx] = true;
+            }
+        }
+        std::vector<double> kept_values;
+        std::vector<std::uint64_t> & dim_global_idx = new_global_idx.emplace_back(master_values.size(), 0);
+        for (std::uint64_t i_value = 0; i_value < master_values.size(); i_value++) {
+            if (is_used[i_value]) {
+                dim_global_idx[i_value] = kept_values.size();
+                kept_values.push_back(master_values[i_value]);
+            }
+        }
+        pspace_changed = pspace_changed || (kept_values.size() != master_values.size());
+        master_values = std::move(kept_values);
+        global_idim++;
+    }
+    if (pspace_changed) {
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            mpofile.remap_global_idx(new_global_idx);
+        }
+    }
+    // get available isotopes and reactions of the remaining files
+    std::set<std::string> set_isotopes, set_reactions;
+    for (SingleMpo & mpofile : this->mpofiles_) {
+        std::set<std::string> mpo_isotopes = mpofile.get_isotopes();
+        set_isotopes.insert(mpo_isotopes.begin(), mpo_isotopes.end());
+        std::vector<std::string> mpo_reactions = mpofile.get_reactions();
+        set_reactions.insert(mpo_reactions.begin(), mpo_reactions.end());
+    }
+    this->avail_isotopes_.assign(set_isotopes.begin(), set_isotopes.end());
+    this->avail_reactions_.assign(set_reactions.begin(), set_reactions.end());
+    std::erase_if(this->valid_set_, [&set_isotopes](const auto & item) { return !set_isotopes.contains(item.first); });
+    this->statept_locations_.clear();
+    this->query_cache_.clear();
+}
+
 // Retrieve microscopic homogenized cross sections at some isotopes, reactions and skipped dimensions
 MpoLib MasterMpo::build_microlib_xs(const std::vector<std::string> & isotopes,
                                     const std::vector<std::string> & reactions,
                                     const std::vector<std::string> & skipped_dims, XsType type,
-                                    std::uint64_t max_anisop_order, const std::string & logfile) {
+                                    std::uint64_t max_anisop_order, const std::string & logfile,
+                                    std::uint64_t n_threads, bool expand_scattering) {
+    FlatLib flat_lib = this->build_flatlib_xs(isotopes, reactions, skipped_dims, type, max_anisop_order, logfile,
+                                              n_threads, expand_scattering);
+    return flat_lib.views();
+}
+
+// Retrieve microscopic homogenized cross sections in a flat library
+FlatLib MasterMpo::build_flatlib_xs(const std::vector<std::string> & isotopes,
+                                    const std::vector<std::string> & reactions,
+                                    const std::vector<std::string> & skipped_dims, XsType type,
+                                    std::uint64_t max_anisop_order, const std::string & logfile,
+                                    std::uint64_t n_threads, bool expand_scattering) {
+    XsRequest request = {isotopes, reactions, skipped_dims, type, max_anisop_order, expand_scattering};
+    std::vector<FlatLib> flat_libs = this->build_flatlib_batch({request}, logfile, n_threads);
+    return std::move(flat_libs[0]);
+}
+
+// Retrieve microscopic homogenized cross sections of several requests in a single pass over the MPO files
+std::vector<MpoLib> MasterMpo::build_microlib_batch(const std::vector<XsRequest> & requests,
+                                                    const std::string & logfile, std::uint64_t n_threads) {
+    std::vector<FlatLib> flat_libs = this->build_flatlib_batch(requests, logfile, n_threads);
+    std::vector<MpoLib> micro_libs;
+    micro_libs.reserve(flat_libs.size());
+    for (FlatLib & flat_lib : flat_libs) {
+        micro_libs.push_back(flat_lib.views());
+    }
+    return micro_libs;
+}
+
+// Retrieve microscopic homogenized cross sections of several requests in flat libraries
+std::vector<FlatLib> MasterMpo::build_flatlib_batch(const std::vector<XsRequest> & requests,
+                                                    const std::string & logfile, std::uint64_t n_threads) {
+    IoScope io_scope(this->io_counters_.get());
+    PhaseTimer timer = this->time_phase(Phase::Extraction);
+    // allocate data of each request in a single arena
+    std::vector<FlatLib> flat_libs(requests.size());
+    std::vector<MpoLib> micro_libs(requests.size());
+    std::vector<std::map<std::string, DiscoveryLib>> discovery_libs(requests.size());
+    std::vector<XsTarget> targets(requests.size());
+    for (std::uint64_t i_request = 0; i_request < requests.size(); i_request++) {
+        const XsRequest & request = requests[i_request];
+        XsTarget & target = targets[i_request];
+        FlatLib & flat_lib = flat_libs[i_request];
+        std::map<std::uint32_t, NdArray> band_profiles;
+        flat_lib = this->register_outputs(request.isotopes, request.reactions, request.skipped_dims,
+                                          request.max_anisop_order, request.expand_scattering,
+                                          target.global_skipped_dims, discovery_libs[i_request], band_profiles);
+        flat_lib.allocate();
+        for (const auto & [isotope_id, profile] : band_profiles) {
+            flat_lib.insert({isotope_id, flat_lib.reaction_id("ScatteringProfile"), 0, 0, 0}, profile);
+        }
+        micro_libs[i_request] = flat_lib.views();
+        target.request = &request;
+        target.micro_lib = &(micro_libs[i_request]);
+        target.discovery_lib = &(discovery_libs[i_request]);
+    }
+    // retrieve data of all requests from each MPO file
+    this->read_outputs(targets, logfile, n_threads, nullptr);
+    // save discovered valid set and insert Diffusion and Scattering outputs to the library
+    for (std::uint64_t i_request = 0; i_request < requests.size(); i_request++) {
+        const XsRequest & request = requests[i_request];
+        for (auto & [isotope, iso_discovery] : discovery_libs[i_request]) {
+            for (const std::string & reaction : request.reactions) {
+                iso_discovery.finalize(flat_libs[i_request].isotope_id(isotope), reaction, flat_libs[i_request],
+                                       request.expand_scattering);
+            }
+            // merge with the valid sets discovered by other requests, which may cover other state points
+            ValidSet & iso_valid_set = this->valid_set_[isotope];
+            const ValidSet & discovered = iso_discovery.valid_set();
+            std::get<0>(iso_valid_set) = std::max(std::get<0>(iso_valid_set), std::get<0>(discovered));
+            std::get<1>(iso_valid_set) = std::max(std::get<1>(iso_valid_set), std::get<1>(discovered));
+            std::get<2>(iso_valid_set).insert(std::get<2>(discovered).begin(), std::get<2>(discovered).end());
+        }
+    }
+    return flat_libs;
+}
+
+// Retrieve microscopic homogenized cross sections and write them to an HDF5 file one state point at a time
+void MasterMpo::stream_microlib_xs(const std::string & fname, const std::vector<std::string> & isotopes,
+                                   const std::vector<std::string> & reactions,
+                                   const std::vector<std::string> & skipped_dims, XsType type,
+                                   std::uint64_t max_anisop_order, const std::string & logfile,
+                                   std::uint64_t n_threads, bool expand_scattering, std::uint64_t memory_cap) {
+    IoScope io_scope(this->io_counters_.get());
+    // compute valid set of isotopes whose valid set is deferred (outputs must be known before the first write)
+    std::map<std::string, ValidSet> missing_valid_set;
+    for (const std::string & isotope : isotopes) {
+        if (!this->valid_set_.contains(isotope)) {
+            missing_valid_set[isotope] = ValidSet();
+        }
+    }
+    if (!missing_valid_set.empty()) {
+        PhaseTimer timer = this->time_phase(Phase::ValidSet);
+        std::ofstream valid_set_log("log_validset.txt");
+        for (SingleMpo & mpofile : this->mpofiles_) {
+            mpofile.reopen();
+            mpofile.get_valid_set(missing_valid_set, valid_set_log);
+            mpofile.close();
+        }
+        this->valid_set_.merge(missing_valid_set);
+    }
+    PhaseTimer timer = this->time_phase(Phase::Extraction);
+    // create datasets of each output in the file
+    XsRequest request = {isotopes, reactions, skipped_dims, type, max_anisop_order, expand_scattering};
+    std::vector<XsTarget> targets(1);
+    std::map<std::string, DiscoveryLib> discovery_lib;
+    std::map<std::uint32_t, NdArray> band_profiles;
+    FlatLib flat_lib = this->register_outputs(isotopes, reactions, skipped_dims, max_anisop_order, expand_scattering,
+                                              targets[0].global_skipped_dims, discovery_lib, band_profiles);
+    StreamLib stream(fname, flat_lib);
+    for (const auto & [isotope_id, profile] : band_profiles) {
+        stream.write(flat_lib.isotopes()[isotope_id], "ScatteringProfile", profile);
+    }
+    // limit number of threads so that staging libraries of all threads fit in the memory cap
+    if (stream.staging_size() > memory_cap) {
+        throw std::invalid_argument(stringify("Memory cap of ", memory_cap, " bytes is smaller than the ",
+                                              stream.staging_size(), " bytes of cross sections at a state point.\n"));
+    }
+    n_threads = get_n_threads(n_threads);
+    if (stream.staging_size() != 0) {
+        n_threads = std::max<std::uint64_t>(std::min(n_threads, memory_cap / stream.staging_size()), 1);
+    }
+    // retrieve data from each MPO file
+    MpoLib micro_lib;
+    targets[0].request = &request;
+    targets[0].micro_lib = &micro_lib;
+    targets[0].discovery_lib = &discovery_lib;
+    this->read_outputs(targets, logfile, n_threads, &stream);
+    stream.close();
+}
+
+// Check isotopes and reactions, and register the output arrays of each isotope
+FlatLib MasterMpo::register_outputs(const std::vector<std::string> & isotopes,
+                                    const std::vector<std::string> & reactions,
+                                    const std::vector<std::string> & skipped_dims, std::uint64_t max_anisop_order,
+                                    bool expand_scattering, std::vector<std::uint64_t> & global_skipped_idims,
+                                    std::map<std::string, DiscoveryLib> & discovery_lib,
+                                    std::map<std::uint32_t, NdArray> & band_profiles) {
     // check isotope and reaction
     for (const std::string & isotope : isotopes) {
         auto it = std::find(this->avail_isotopes_.begin(), this->avail_isotopes_.end(), isotope);
@@ -139,7 +485,6 @@ MpoLib MasterMpo::build_microlib_xs(const std::vector<std::string> & isotopes,
         }
     }
     // get shape of each microlib
-    std::vector<std::uint64_t> global_skipped_idims;
     std::vector<std::uint64_t> shape_lib;
     shape_lib.push_back(this->mpofiles_[0].n_groups);
     shape_lib.push_back(this->mpofiles_[0].n_zones);
@@ -155,44 +500,107 @@ MpoLib MasterMpo::build_microlib_xs(const std::vector<std::string> & isotopes,
     }
     std::vector<std::uint64_t> scattering_shape_lib(shape_lib);
     scattering_shape_lib[0] = 1;
-    // allocate data for microlib
-    MpoLib micro_lib;
+    // register outputs of each isotope (Diffusion and Scattering of isotopes with unknown valid set are allocated on
+    // write)
+    FlatLib flat_lib;
     for (const std::string & isotope : isotopes) {
+        std::uint32_t isotope_id = flat_lib.isotope_id(isotope);
+        bool discover_valid_set = !this->valid_set_.contains(isotope);
+        if (discover_valid_set) {
+            discovery_lib.try_emplace(isotope, shape_lib, max_anisop_order);
+        }
         for (const std::string & reaction : reactions) {
+            std::uint32_t reaction_id = flat_lib.reaction_id(reaction);
+            if (discover_valid_set && (reaction.compare("Diffusion") == 0 || reaction.compare("Scattering") == 0)) {
+                continue;
+            }
             if (reaction.compare("Diffusion") == 0) {
                 std::uint64_t max_anisop = std::min(std::get<0>(this->valid_set_[isotope]), max_anisop_order);
-                for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
-                    micro_lib[isotope][stringify(reaction, anisop)] = NdArray(shape_lib);
+                for (std::uint32_t anisop = 0; anisop < max_anisop; anisop++) {
+                    flat_lib.add({isotope_id, reaction_id, anisop, 0, 0}, shape_lib);
                 }
+            } else if (reaction.compare("Scattering") == 0 && !expand_scattering) {
+                ScatteringBand band(this->valid_set_[isotope], shape_lib[0]);
+                std::vector<std::uint64_t> band_shape_lib(shape_lib);
+                band_shape_lib[0] = band.size();
+                std::uint64_t max_anisop = std::min(std::get<1>(this->valid_set_[isotope]), max_anisop_order);
+                for (std::uint32_t anisop = 0; anisop < max_anisop; anisop++) {
+                    flat_lib.add({isotope_id, reaction_id, anisop, LibKey::band, LibKey::band}, band_shape_lib);
+                }
+                band_profiles[isotope_id] = band.profile();
             } else if (reaction.compare("Scattering") == 0) {
                 std::uint64_t max_anisop = std::min(std::get<1>(this->valid_set_[isotope]), max_anisop_order);
-                for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+                for (std::uint32_t anisop = 0; anisop < max_anisop; anisop++) {
                     for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(this->valid_set_[isotope])) {
-                        micro_lib[isotope][stringify(reaction, anisop, '_', p.first, '-', p.second)] = NdArray(
-                            scattering_shape_lib);
+                        LibKey key = {isotope_id, reaction_id, anisop, static_cast<std::uint32_t>(p.first),
+                                      static_cast<std::uint32_t>(p.second)};
+                        flat_lib.add(key, scattering_shape_lib);
                     }
                 }
             } else {
-                micro_lib[isotope][reaction] = NdArray(shape_lib);
+                flat_lib.add({isotope_id, reaction_id, 0, 0, 0}, shape_lib);
             }
         }
     }
-    // retrieve data from each MPO file
+    return flat_lib;
+}
+
+// Retrieve cross sections of each request from each MPO file
+void MasterMpo::read_outputs(const std::vector<XsTarget> & targets, const std::string & logfile,
+                             std::uint64_t n_threads, StreamLib * stream) {
+    // state points are read in parallel, or files if there are more independent files than threads
     std::printf("\n");
     std::ofstream log(logfile.c_str());
-    for (std::uint64_t i_fmpo = 0; i_fmpo < this->mpofiles_.size(); i_fmpo++) {
-        this->mpofiles_[i_fmpo].reopen();
-        this->mpofiles_[i_fmpo].get_microlib(isotopes, reactions, global_skipped_idims, this->valid_set_, micro_lib,
-                                             type, max_anisop_order, log);
-        print_process(static_cast<double>(i_fmpo) / static_cast<double>(this->mpofiles_.size()));
-        this->mpofiles_[i_fmpo].close();
+    n_threads = get_n_threads(n_threads);
+    std::vector<std::vector<std::uint64_t>> file_groups;
+    if (n_threads > 1) {
+        // group files writing to the same state points of any request (index of the request is appended, so that
+        // positions of different requests never coincide)
+        std::vector<std::vector<std::vector<std::uint64_t>>> file_output_idx(this->mpofiles_.size());
+        for (std::uint64_t i_fmpo = 0; i_fmpo < this->mpofiles_.size(); i_fmpo++) {
+            this->mpofiles_[i_fmpo].reopen();
+            for (std::uint64_t i_target = 0; i_target < targets.size(); i_target++) {
+                for (std::vector<std::uint64_t> & position :
+                     this->mpofiles_[i_fmpo].get_output_idx(targets[i_target].global_skipped_dims)) {
+                    position.push_back(i_target);
+                    file_output_idx[i_fmpo].push_back(std::move(position));
+                }
+            }
+            this->mpofiles_[i_fmpo].close();
+        }
+        file_groups = group_conflicts(file_output_idx);
+    }
+    if (file_groups.size() < n_threads) {
+        for (std::uint64_t i_fmpo = 0; i_fmpo < this->mpofiles_.size(); i_fmpo++) {
+            this->mpofiles_[i_fmpo].reopen();
+            this->mpofiles_[i_fmpo].get_microlib_batch(targets, this->valid_set_, log, n_threads, stream);
+            print_process(static_cast<double>(i_fmpo) / static_cast<double>(this->mpofiles_.size()));
+            this->mpofiles_[i_fmpo].close();
+        }
+    } else {
+        // retrieve data from each group of files in parallel
+        std::uint64_t n_processed = 0;
+        parallel_for(file_groups.size(), n_threads, [&](std::uint64_t i_group) {
+            for (std::uint64_t i_fmpo : file_groups[i_group]) {
+                std::ostringstream file_log;
+                this->mpofiles_[i_fmpo].reopen();
+                this->mpofiles_[i_fmpo].get_microlib_batch(targets, this->valid_set_, file_log, 1, stream);
+                this->mpofiles_[i_fmpo].close();
+                #pragma omp critical (readmpo_log)
+                {
+                    log << file_log.str();
+                    print_process(static_cast<double>(n_processed++) / static_cast<double>(this->mpofiles_.size()));
+                }
+            }
+        });
     }
-    return micro_lib;
 }
 
 // Retrieve concentration of some isotopes at each value of burnup in each zone
 ConcentrationLib MasterMpo::get_concentration(const std::vector<std::string> & isotopes,
-                                              const std::string & burnup_name) {
+                                              const std::string & burnup_name, std::uint64_t n_threads) {
+    IoScope io_scope(this->io_counters_.get());
+    PhaseTimer timer = this->time_phase(Phase::Extraction);
     // check isotope
     for (const std::string & isotope : isotopes) {
         auto it = std::find(this->avail_isotopes_.begin(), this->avail_isotopes_.end(), isotope);
@@ -204,21 +612,127 @@ ConcentrationLib MasterMpo::get_concentration(const std::vector<std::string> & i
     ConcentrationLib conc_lib;
     for (const std::string & isotope : isotopes) {
         conc_lib[isotope] = NdArray({this->master_pspace_.at(burnup_name).size(), this->n_zone_});
+        record_allocation(conc_lib[isotope].size() * sizeof(double));
     }
     // get concentration of isotope from each MPO
     std::uint64_t bu_idx = std::distance(this->master_pspace_.begin(), this->master_pspace_.find(burnup_name));
     for (std::uint64_t i_fmpo = 0; i_fmpo < this->mpofiles_.size(); i_fmpo++) {
         SingleMpo & mpofile = this->mpofiles_[i_fmpo];
         mpofile.reopen();
-        mpofile.get_concentration(isotopes, bu_idx, conc_lib);
+        mpofile.get_concentration(isotopes, bu_idx, conc_lib, n_threads);
         mpofile.close();
     }
     return conc_lib;
 }
 
+// Retrieve cross section of an isotope and a reaction at arbitrary values of parameters
+NdArray MasterMpo::query_xs(const std::map<std::string, double> & param_values, const std::string & isotope,
+                            const std::string & reaction, XsType type, std::uint64_t anisop) {
+    IoScope io_scope(this->io_counters_.get());
+    PhaseTimer timer = this->time_phase(Phase::Extraction);
+    // check isotope, reaction and parameter names
+    if (std::find(this->avail_isotopes_.begin(), this->avail_isotopes_.end(), isotope) == this->avail_isotopes_.end()) {
+        throw std::invalid_argument(stringify("Isotope ", isotope, " not found.\n"));
+    }
+    if (std::find(this->avail_reactions_.begin(), this->avail_reactions_.end(), reaction) ==
+        this->avail_reactions_.end()) {
+        throw std::invalid_argument(stringify("Reaction ", reaction, " not found.\n"));
+    }
+    std::map<std::string, double> lowercased_values;
+    for (const auto & [param_name, value] : param_values) {
+        if (!this->master_pspace_.contains(lowercase(param_name))) {
+            throw std::invalid_argument(stringify("Parameter ", param_name, " not found.\n"));
+        }
+        lowercased_values[lowercase(param_name)] = value;
+    }
+    // get bracketing indices and their weights on each dimension
+    std::vector<std::vector<std::pair<std::uint64_t, double>>> brackets;
+    for (const auto & [param_name, grid] : this->master_pspace_) {
+        auto it_value = lowercased_values.find(param_name);
+        if (it_value == lowercased_values.end()) {
+            if (grid.size() != 1) {
+                throw std::invalid_argument(stringify("Value of parameter ", param_name, " not provided.\n"));
+            }
+            brackets.push_back({std::make_pair(0, 1.0)});
+            continue;
+        }
+        double value = it_value->second;
+        std::uint64_t i_near = find_near(grid, value);
+        if (i_near != grid.size()) {
+            brackets.push_back({std::make_pair(i_near, 1.0)});
+            continue;
+        }
+        auto it_upper = std::upper_bound(grid.begin(), grid.end(), value);
+        if ((it_upper == grid.begin()) || (it_upper == grid.end())) {
+            throw std::invalid_argument(stringify("Value ", value, " of parameter ", param_name, " out of range [",
+                                                  grid.front(), ", ", grid.back(), "].\n"));
+        }
+        std::uint64_t i_upper = it_upper - grid.begin();
+        double t = (value - grid[i_upper - 1]) / (grid[i_upper] - grid[i_upper - 1]);
+        brackets.push_back({std::make_pair(i_upper - 1, 1.0 - t), std::make_pair(i_upper, t)});
+    }
+    // sum cross sections at each corner of the bracketing hypercube weighted by its multilinear coefficient
+    std::uint64_t n_corners = 1;
+    for (const std::vector<std::pair<std::uint64_t, double>> & bracket : brackets) {
+        n_corners *= bracket.size();
+    }
+    NdArray result;
+    XsKey key = {std::vector<std::uint64_t>(brackets.size()), isotope, reaction, type, anisop};
+    for (std::uint64_t i_corner = 0; i_corner < n_corners; i_corner++) {
+        double weight = 1.0;
+        for (std::uint64_t i_dim = brackets.size(), c_idx = i_corner; i_dim-- > 0;) {
+            const std::pair<std::uint64_t, double> & bound = brackets[i_dim][c_idx % brackets[i_dim].size()];
+            key.index[i_dim] = bound.first;
+            weight *= bound.second;
+            c_idx /= brackets[i_dim].size();
+        }
+        // read cross sections at the state point if not cached
+        NdArray corner_xs = this->query_cache_.find(key);
+        if (corner_xs.size() == 0) {
+            // map of state points and MPO files are not thread safe, the cache is guarded by its own mutex
+            std::lock_guard<std::mutex> query_lock(this->query_mutex_);
+            auto [i_fmpo, i_statept] = this->locate_statept(key.index);
+            SingleMpo & mpofile = this->mpofiles_[i_fmpo];
+            mpofile.reopen();
+            corner_xs = mpofile.get_statept_xs(i_statept, isotope, reaction, type, anisop);
+            mpofile.close();
+            this->query_cache_.insert(key, corner_xs.view());
+        }
+        if (result.size() == 0) {
+            result = NdArray(corner_xs.shape());
+        }
+        for (std::uint64_t i = 0; i < result.size(); i++) {
+            result[i] += weight * corner_xs[i];
+        }
+    }
+    return result;
+}
+
+// Get index of the MPO file and index of the state point inside its output at an index of the master parameter space
+std::pair<std::uint64_t, std::uint64_t> MasterMpo::locate_statept(const std::vector<std::uint64_t> & index) {
+    if (this->statept_locations_.empty()) {
+        for (std::uint64_t i_fmpo = 0; i_fmpo < this->mpofiles_.size(); i_fmpo++) {
+            this->mpofiles_[i_fmpo].reopen();
+            std::vector<std::vector<std::uint64_t>> statepts_idx = this->mpofiles_[i_fmpo].get_output_idx({});
+            this->mpofiles_[i_fmpo].close();
+            for (std::uint64_t i_statept = 0; i_statept < statepts_idx.size(); i_statept++) {
+                this->statept_locations_[statepts_idx[i_statept]] = std::make_pair(i_fmpo, i_statept);
+            }
+        }
+    }
+    auto it = this->statept_locations_.find(index);
+    if (it == this->statept_locations_.end()) {
+        throw std::runtime_error(stringify("State point at index ", index, " not found in any MPO file.\n"));
+    }
+    return it->second;
+}
+
 // Serialize
 void MasterMpo::serialize(const std::string & fname) {
-    std::ofstream out(fname.c_str());
+    PhaseTimer timer = this->time_phase(Phase::Serialization);
+    BufferedOfstream out(fname);
+    serialize_obj(out, serialization_tag);
+    serialize_obj(out, serialization_version);
     serialize_obj(out, this->geometry_);
     serialize_obj(out, this->energy_mesh_);
     serialize_obj(out, this->n_zone_);
@@ -228,20 +742,82 @@ void MasterMpo::serialize(const std::string & fname) {
     serialize_obj(out, this->avail_isotopes_);
     serialize_obj(out, this->avail_reactions_);
     serialize_obj(out, this->valid_set_);
+    for (const SingleMpo & mpofile : this->mpofiles_) {
+        mpofile.serialize(out);
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error while writing file " + fname + "\n");
+    }
+    // save structural index of each MPO file to the sidecar file
+    std::string index_fname = stringify(fname, ".index");
+    BufferedOfstream index_out(index_fname);
+    serialize_obj(index_out, mpo_fnames);
+    for (const SingleMpo & mpofile : this->mpofiles_) {
+        mpofile.index().serialize(index_out);
+    }
+    index_out.close();
+    if (!index_out) {
+        throw std::runtime_error("Error while writing file " + index_fname + "\n");
+    }
 }
 
 // Deserialize
 void MasterMpo::deserialize(const std::string & fname) {
-    std::ifstream in(fname.c_str());
-    deserialize_obj(in, this->geometry_);
-    deserialize_obj(in, this->energy_mesh_);
-    deserialize_obj(in, this->n_zone_);
+    IoScope io_scope(this->io_counters_.get());
+    MappedIstream in(fname);
     std::vector<std::string> mpo_fnames;
-    deserialize_obj(in, mpo_fnames);
-    deserialize_obj(in, this->master_pspace_);
-    deserialize_obj(in, this->avail_isotopes_);
-    deserialize_obj(in, this->avail_reactions_);
-    deserialize_obj(in, this->valid_set_);
+    bool has_metadata = false;
+    {
+        PhaseTimer timer = this->time_phase(Phase::Serialization);
+        // files serialized without metadata of MPO files begin with the geometry
+        std::string tag;
+        deserialize_obj(in, tag);
+        if (tag == serialization_tag) {
+            has_metadata = true;
+            std::uint64_t version;
+            deserialize_obj(in, version);
+            check_serialization_version(version);
+            deserialize_obj(in, this->geometry_);
+        } else {
+            this->geometry_ = std::move(tag);
+        }
+        deserialize_obj(in, this->energy_mesh_);
+        deserialize_obj(in, this->n_zone_);
+        deserialize_obj(in, mpo_fnames);
+        deserialize_obj(in, this->master_pspace_);
+        deserialize_obj(in, this->avail_isotopes_);
+        deserialize_obj(in, this->avail_reactions_);
+        deserialize_obj(in, this->valid_set_);
+    }
+    if (has_metadata) {
+        this->load_mpofiles(in, mpo_fnames);
+    } else {
+        this->open_mpofiles(mpo_fnames);
+    }
+    // load structural index of each MPO file from the sidecar file, if exists
+    PhaseTimer timer = this->time_phase(Phase::Serialization);
+    std::string index_fname = stringify(fname, ".index");
+    if (!std::filesystem::exists(index_fname)) {
+        return;
+    }
+    MappedIstream index_in(index_fname);
+    std::vector<std::string> indexed_fnames;
+    deserialize_obj(index_in, indexed_fnames);
+    if (indexed_fnames != mpo_fnames) {
+        return;
+    }
+    for (SingleMpo & mpofile : this->mpofiles_) {
+        MpoIndex index;
+        index.deserialize(index_in);
+        mpofile.load_index(std::move(index));
+    }
+}
+
+// Open each MPO file and read its metadata
+void MasterMpo::open_mpofiles(const std::vector<std::string> & mpo_fnames) {
+    PhaseTimer timer = this->time_phase(Phase::Open);
+    this->mpofiles_.reserve(mpo_fnames.size());
     for (const std::string & mpofile_name : mpo_fnames) {
         this->mpofiles_.push_back(SingleMpo(mpofile_name, this->geometry_, this->energy_mesh_));
         this->mpofiles_.back().construct_global_idx_map(this->master_pspace_);
@@ -249,6 +825,118 @@ void MasterMpo::deserialize(const std::string & fname) {
     }
 }
 
+// Read metadata of each MPO file from an input stream, and read again files modified since
+void MasterMpo::load_mpofiles(std::istream & is, const std::vector<std::string> & mpo_fnames) {
+    std::vector<std::string> modified_fnames;
+    {
+        PhaseTimer timer = this->time_phase(Phase::Serialization);
+        this->mpofiles_.resize(mpo_fnames.size());
+        for (std::uint64_t i_mpo = 0; i_mpo < mpo_fnames.size(); i_mpo++) {
+            SingleMpo & mpofile = this->mpofiles_[i_mpo];
+            mpofile.deserialize(is);
+            if (!is || (mpofile.fname() != mpo_fnames[i_mpo])) {
+                throw std::runtime_error("Corrupted metadata of MPO files.\n");
+            }
+            if (!mpofile.is_up_to_date()) {
+                modified_fnames.push_back(mpofile.fname());
+            }
+        }
+    }
+    if (modified_fnames.empty()) {
+        return;
+    }
+    std::cout << "MPO files modified since serialization: " << modified_fnames << "\n";
+    // valid sets of modified files are deferred if some isotopes are
+    bool defer_valid_set = std::any_of(this->avail_isotopes_.begin(), this->avail_isotopes_.end(),
+                                       [this](const std::string & isotope) {
+                                           return !this->valid_set_.contains(isotope);
+                                       });
+    this->statept_locations_.clear();
+    this->query_cache_.clear();
+    if (modified_fnames.size() == mpo_fnames.size()) {
+        // all files are modified, rebuild the master MPO
+        MasterMpo rebuilt(mpo_fnames, this->geometry_, this->energy_mesh_, defer_valid_set);
+        this->n_zone_ = rebuilt.n_zone_;
+        this->mpofiles_ = std::move(rebuilt.mpofiles_);
+        this->master_pspace_ = std::move(rebuilt.master_pspace_);
+        this->avail_isotopes_ = std::move(rebuilt.avail_isotopes_);
+        this->avail_reactions_ = std::move(rebuilt.avail_reactions_);
+        this->valid_set_ = std::move(rebuilt.valid_set_);
+        std::lock_guard<std::mutex> lock(this->phase_mutex_);
+        for (std::uint64_t i_phase = 0; i_phase < n_phases; i_phase++) {
+            this->phase_times_[i_phase] += rebuilt.phase_times_[i_phase];
+        }
+        return;
+    }
+    // isotopes of the former version of modified files, whose contributions to valid sets cannot be removed
+    std::set<std::string> stale_isotopes;
+    for (SingleMpo & mpofile : this->mpofiles_) {
+        if (std::find(modified_fnames.begin(), modified_fnames.end(), mpofile.fname()) != modified_fnames.end()) {
+            std::set<std::string> mpo_isotopes = mpofile.get_isotopes();
+            stale_isotopes.insert(mpo_isotopes.begin(), mpo_isotopes.end());
+        }
+    }
+    // remove and add modified files, then restore the order of files (if a modified file cannot be read, the master
+    // MPO is reset, so that a partially reloaded state is never observed), valid sets of stale isotopes still in the
+    // remaining files are discovered again at the next extraction
+    try {
+        this->remove_files(modified_fnames);
+        std::erase_if(this->valid_set_,
+                      [&stale_isotopes](const auto & item) { return stale_isotopes.contains(item.first); });
+        this->add_files(modified_fnames, defer_valid_set);
+    } catch (...) {
+        *this = MasterMpo();
+        throw;
+    }
+    std::map<std::string, std::uint64_t> positions;
+    for (std::uint64_t i_mpo = 0; i_mpo < mpo_fnames.size(); i_mpo++) {
+        positions[mpo_fnames[i_mpo]] = i_mpo;
+    }
+    std::sort(this->mpofiles_.begin(), this->mpofiles_.end(),
+              [&positions](const SingleMpo & a, const SingleMpo & b) {
+                  return positions[a.fname()] < positions[b.fname()];
+              });
+}
+
+// Get wall time of each phase and I/O counters of each MPO file and in total
+Profile MasterMpo::profile(void) const {
+    Profile result;
+    {
+        std::lock_guard<std::mutex> lock(this->phase_mutex_);
+        for (std::uint64_t i_phase = 0; i_phase < n_phases; i_phase++) {
+            result.phase_times[phase_name(static_cast<Phase>(i_phase))] = this->phase_times_[i_phase];
+        }
+    }
+    if (this->io_counters_ != nullptr) {
+        result.total = this->io_counters_->to_map();
+    }
+    // output arrays are shared by all files, so allocations are only reported in total
+    for (const SingleMpo & mpofile : this->mpofiles_) {
+        std::map<std::string, std::uint64_t> & file_counters = result.files[mpofile.fname()];
+        for (const auto & [name, value] : mpofile.io_counters().to_map()) {
+            if ((name != "allocations") && (name != "bytes_allocated")) {
+                file_counters[name] += value;
+            }
+            result.total[name] += value;
+        }
+    }
+    return result;
+}
+
+// Reset phase timers and I/O counters
+void MasterMpo::reset_profile(void) {
+    {
+        std::lock_guard<std::mutex> lock(this->phase_mutex_);
+        this->phase_times_.fill(0.0);
+    }
+    if (this->io_counters_ != nullptr) {
+        this->io_counters_->reset();
+    }
+    for (SingleMpo & mpofile : this->mpofiles_) {
+        mpofile.io_counters().reset();
+    }
+}
+
 // String representation
 std::string MasterMpo::str(void) const {
     std::ostringstream out;
@@ -280,12 +968,22 @@ std::string MasterMpo::str(void) const {
     return out.str();
 }
 
+// Get serialized metadata of each MPO file
+std::string MasterMpo::get_mpofiles_state(void) const {
+    std::ostringstream out;
+    serialize_obj(out, serialization_version);
+    for (const SingleMpo & mpofile : this->mpofiles_) {
+        mpofile.serialize(out);
+    }
+    return out.str();
+}
+
 // Load pickled data
 void MasterMpo::set_state(const std::string & geometry, const std::string & energy_mesh, std::uint64_t n_zone,
                           const std::vector<std::string> & mpo_fnames,
                           const std::map<std::string, std::vector<double>> & master_pspace,
                           const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
-                          const std::map<std::string, ValidSet> & valid_set) {
+                          const std::map<std::string, ValidSet> & valid_set, const std::string & mpofiles_state) {
     // copy other data
     this->geometry_ = geometry;
     this->energy_mesh_ = energy_mesh;
@@ -295,12 +993,16 @@ void MasterMpo::set_state(const std::string & geometry, const std::string & ener
     this->avail_reactions_ = reactions;
     this->valid_set_ = valid_set;
     // save each mpo to vector
-    this->mpofiles_.reserve(mpo_fnames.size());
-    for (const std::string & mpofile_name : mpo_fnames) {
-        this->mpofiles_.push_back(SingleMpo(mpofile_name, geometry, energy_mesh));
-        this->mpofiles_.back().construct_global_idx_map(this->master_pspace_);
-        this->mpofiles_.back().close();
+    IoScope io_scope(this->io_counters_.get());
+    if (mpofiles_state.empty()) {
+        this->open_mpofiles(mpo_fnames);
+        return;
     }
+    std::istringstream in(mpofiles_state);
+    std::uint64_t version;
+    deserialize_obj(in, version);
+    check_serialization_version(version);
+    this->load_mpofiles(in, mpo_fnames);
 }
 
 }  // namespace readmpo
@@ -2,16 +2,24 @@
 #ifndef READMPO_MASTER_MPO_HPP_
 #define READMPO_MASTER_MPO_HPP_
 
-#include <map>     // std::map
-#include <string>  // std::string
-#include <vector>  // std::vector
+#include <array>    // std::array
+#include <istream>  // std::istream
+#include <map>      // std::map
+#include <memory>   // std::make_unique, std::unique_ptr
+#include <string>   // std::string
+#include <utility>  // std::pair
+#include <vector>   // std::vector
 
+#include "readmpo/flat_lib.hpp"    // readmpo::FlatLib, readmpo::MpoLib
+#include "readmpo/h5_utils.hpp"    // readmpo::MovableMutex
 #include "readmpo/nd_array.hpp"    // readmpo::NdArray
-#include "readmpo/single_mpo.hpp"  // readmpo::SingleMpo, readmpo::XsType
+#include "readmpo/profile.hpp"     // readmpo::IoCounters, readmpo::Phase, readmpo::PhaseTimer, readmpo::Profile
+#include "readmpo/single_mpo.hpp"  // readmpo::SingleMpo, readmpo::XsRequest, readmpo::XsTarget, readmpo::XsType
+#include "readmpo/stream_lib.hpp"  // readmpo::StreamLib
+#include "readmpo/xs_cache.hpp"    // readmpo::XsCache
 
 namespace readmpo {
 
-using MpoLib = std::map<std::string, std::map<std::string, NdArray>>;
 using ConcentrationLib = std::map<std::string, NdArray>;
 
 /** @brief Class containing merged information of all MPOs.*/
@@ -21,9 +29,15 @@ class MasterMpo {
     /// @{
     /** @brief Default constructor.*/
     MasterMpo(void) = default;
-    /** @brief Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh.*/
+    /** @brief Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh.
+     *  @param mpofile_list List of MPO file names.
+     *  @param geometry Name of homogenized geometry.
+     *  @param energy_mesh Name of energy mesh.
+     *  @param defer_valid_set If ``true``, the valid set of each isotope is not computed at construction, but is
+     *  discovered during its first extraction, in the same pass over state points and zones reading cross sections.
+     */
     MasterMpo(const std::vector<std::string> & mpofile_list, const std::string & geometry,
-              const std::string & energy_mesh);
+              const std::string & energy_mesh, bool defer_valid_set = false);
     /// @}
 
     /// @name Copy and move
@@ -56,40 +70,170 @@ class MasterMpo {
     constexpr const std::vector<std::string> & get_isotopes(void) const noexcept { return this->avail_isotopes_; }
     /** @brief Get available reactions.*/
     constexpr const std::vector<std::string> & get_reactions(void) const noexcept { return this->avail_reactions_; }
-    /** @brief Get valid set.*/
+    /** @brief Get valid set (isotopes with deferred valid set that have never been extracted are not present).*/
     const std::map<std::string, ValidSet> & valid_set(void) const noexcept { return this->valid_set_; }
     /// @}
 
+    /// @name Update list of MPO files
+    /// @{
+    /** @brief Add MPO files.
+     *  @details Parameter values, isotopes, reactions and valid sets of the new files are merged into the master MPO.
+     *  Files already in the master MPO are not read again: if values are inserted into the master parameter space,
+     *  their maps from local to global index are shifted in memory. The master MPO is left unchanged if reading
+     *  one of the new files fails.
+     *  @param mpofile_list List of MPO file names. Files must have the same parameters and number of zones as the
+     *  files already in the master MPO.
+     *  @param defer_valid_set If ``true``, valid sets of isotopes not yet in the master MPO are discovered during their
+     *  first extraction. Valid sets already known are updated with the new files in both cases.
+     */
+    void add_files(const std::vector<std::string> & mpofile_list, bool defer_valid_set = false);
+    /** @brief Remove MPO files.
+     *  @details Parameter values, isotopes and reactions present only in the removed files are removed, and maps from
+     *  local to global index of the remaining files are shifted in memory. Valid sets of the remaining isotopes are
+     *  kept, as reducing them would require reading all remaining files: anisotropy orders and transfer group pairs
+     *  present only in the removed files are extracted as zero.
+     *  @param mpofile_list List of MPO file names, as returned by MasterMpo::get_mpo_fnames.
+     */
+    void remove_files(const std::vector<std::string> & mpofile_list);
+    /// @}
+
     /// @name Retrieve data from MPO
     /// @{
     /** @brief Retrieve microscopic homogenized cross sections at some isotopes, reactions and skipped dimensions in
      *  all MPO files.
+     *  @details If the valid set of an isotope is unknown, it is discovered while reading cross sections and saved.
+     *  In this case, only anisotropy orders and transfer group pairs present in each zone are read, other entries are
+     *  left to zero.
      *  @param isotopes List of isotopes.
      *  @param reactions List of reactions.
      *  @param skipped_dims List of lowercased skipped dimension.
      *  @param type Cross section type to get.
      *  @param max_anisop_order Max anisotropy order to retrieve.
      *  @param logfile Filename of the log file.
+     *  @param n_threads Number of threads (``0`` means all available threads). If there are more independent files
+     *  than threads, files are read concurrently, otherwise state points of each file are. Files or state points
+     *  writing to a common index of the output are read by the same thread in their order, so the result is identical
+     *  to the one obtained in serial.
+     *  @param expand_scattering If ``false``, Scattering at each anisotropy order is stored in a block-sparse array
+     *  ``Scattering{anisop}``, whose first dimension is the position inside the band structure of the isotope saved
+     *  in ``ScatteringProfile`` (see readmpo::ScatteringBand). If ``true``, it is expanded to one array
+     *  ``Scattering{anisop}_{departure}-{arrival}`` per transfer group pair.
      */
     MpoLib build_microlib_xs(const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
                              const std::vector<std::string> & skipped_dims, XsType type = XsType::Micro,
-                             std::uint64_t max_anisop_order = 1, const std::string & logfile = "log.txt");
+                             std::uint64_t max_anisop_order = 1, const std::string & logfile = "log.txt",
+                             std::uint64_t n_threads = 0, bool expand_scattering = false);
+    /** @brief Retrieve microscopic homogenized cross sections in a flat library.
+     *  @details Same as MasterMpo::build_microlib_xs, but all arrays are allocated in a single arena and indexed by
+     *  interned IDs.
+     */
+    FlatLib build_flatlib_xs(const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
+                             const std::vector<std::string> & skipped_dims, XsType type = XsType::Micro,
+                             std::uint64_t max_anisop_order = 1, const std::string & logfile = "log.txt",
+                             std::uint64_t n_threads = 0, bool expand_scattering = false);
+    /** @brief Retrieve microscopic homogenized cross sections of several requests in a single pass over the MPO
+     *  files.
+     *  @details Each MPO file, state point and zone is visited once, and datasets of a zone are read once for all
+     *  requests (ranges of CROSSECTION are merged over requests). The result is identical to calling
+     *  MasterMpo::build_microlib_xs on each request in their order.
+     *  @param requests List of requests (isotopes, reactions, skipped dimensions, type, max anisotropy order and
+     *  expansion of Scattering).
+     *  @param logfile Filename of the log file.
+     *  @param n_threads Number of threads (``0`` means all available threads).
+     *  @return Library of each request, in the order of the requests.
+     */
+    std::vector<MpoLib> build_microlib_batch(const std::vector<XsRequest> & requests,
+                                             const std::string & logfile = "log.txt", std::uint64_t n_threads = 0);
+    /** @brief Retrieve microscopic homogenized cross sections of several requests in flat libraries.
+     *  @details Same as MasterMpo::build_microlib_batch, but arrays of each request are allocated in a single arena.
+     */
+    std::vector<FlatLib> build_flatlib_batch(const std::vector<XsRequest> & requests,
+                                             const std::string & logfile = "log.txt", std::uint64_t n_threads = 0);
+    /** @brief Retrieve microscopic homogenized cross sections and write them to an HDF5 file one state point at a
+     *  time.
+     *  @details Outputs are written to the datasets ``/<isotope>/<output>`` of the file, with the same name and shape
+     *  as in MasterMpo::build_microlib_xs (see readmpo::StreamLib). Only the cross sections of the state points being
+     *  read are kept in memory, so the memory footprint does not depend on the size of the library. Valid sets of
+     *  isotopes not yet known are computed in a first pass over all MPO files.
+     *  @param fname Name of the output HDF5 file.
+     *  @param memory_cap Max number of bytes of cross sections held in memory. The number of threads is reduced so
+     *  that the cross sections at a state point of each thread fit in the cap.
+     */
+    void stream_microlib_xs(const std::string & fname, const std::vector<std::string> & isotopes,
+                            const std::vector<std::string> & reactions, const std::vector<std::string> & skipped_dims,
+                            XsType type = XsType::Micro, std::uint64_t max_anisop_order = 1,
+                            const std::string & logfile = "log.txt", std::uint64_t n_threads = 0,
+                            bool expand_scattering = false, std::uint64_t memory_cap = std::uint64_t(1) << 30);
     /** @brief Retrieve concentration of some isotopes at each value of burnup in each zone.
      *  @param isotopes List of isotopes.
      *  @param burnup_name Name of parameter representing burnup.
+     *  @param n_threads Number of threads reading state points of each file concurrently (``0`` means all available
+     *  threads).
      */
     ConcentrationLib get_concentration(const std::vector<std::string> & isotopes,
-                                       const std::string & burnup_name = "burnup");
+                                       const std::string & burnup_name = "burnup", std::uint64_t n_threads = 0);
+    /// @}
+
+    /// @name Point query
+    /// @{
+    /** @brief Retrieve cross section of an isotope and a reaction at arbitrary values of parameters.
+     *  @details The value is interpolated multilinearly between the state points of the master parameter space
+     *  bracketing the requested values. Only the datasets of the zones of these state points are read, and cross
+     *  sections at each state point are kept in MasterMpo::query_cache, so that successive queries at close values
+     *  read the file only for the state points not yet cached. Queries can be run concurrently by several threads.
+     *  @param param_values Value of each parameter, by (case insensitive) name. Parameters having a single value in
+     *  the master parameter space can be omitted.
+     *  @param isotope Name of the isotope.
+     *  @param reaction Name of the reaction.
+     *  @param type Type of cross section to retrieve.
+     *  @param anisop Anisotropy order of Diffusion and Scattering.
+     *  @return Array of shape ``[n_groups, n_zones]``, or ``[n_groups, n_groups, n_zones]`` indexed by departure and
+     *  arrival group for Scattering.
+     */
+    NdArray query_xs(const std::map<std::string, double> & param_values, const std::string & isotope,
+                     const std::string & reaction, XsType type = XsType::Micro, std::uint64_t anisop = 0);
+    /** @brief Get cache of cross sections at state points read by point queries.*/
+    XsCache & query_cache(void) noexcept { return this->query_cache_; }
     /// @}
 
     /// @name Serialization
     /// @{
-    /** @brief Serialize.*/
+    /** @brief Serialize.
+     *  @details Metadata of each MPO file (name of the output, maps of isotopes and reactions, maps from local to
+     *  global index, size and last modification time) are saved with the master MPO, so that it can be reloaded
+     *  without opening any file. Structural index of each MPO file is saved to the sidecar file ``<fname>.index``.
+     */
     void serialize(const std::string & fname);
-    /** @brief Deserialize.*/
+    /** @brief Deserialize.
+     *  @details MPO files are not opened until data is retrieved from them. Files modified since the serialization
+     *  are read again and merged into the master MPO as in MasterMpo::add_files (if one of them cannot be read, the
+     *  master MPO is reset to an empty one before the exception is rethrown). Valid sets of the isotopes of the former
+     *  version of modified files are discarded and computed again from the current files, at the next extraction if
+     *  the isotopes are also in unmodified files. Structural index of each MPO file is loaded from the sidecar file
+     *  ``<fname>.index`` if it exists and the MPO file has not been modified since.
+     */
     void deserialize(const std::string & fname);
     /// @}
 
+    /// @name Profiling
+    /// @{
+    /** @brief Get wall time of each phase and I/O counters of each MPO file and in total.
+     *  @details Phases and counters are accumulated over all calls since the construction or the last reset. Files
+     *  are counted when a file is opened and not reused from readmpo::H5Pool, groups and datasets each time they are
+     *  opened, and bytes of a partially read dataset are only those of the selected elements. Allocations of output
+     *  arrays are only reported in total, as outputs are shared by all files.
+     */
+    Profile profile(void) const;
+    /** @brief Reset phase timers and I/O counters.*/
+    void reset_profile(void);
+    /** @brief Add the wall time elapsed until the end of the scope of the returned timer to a phase.
+     *  @details Used to account operations performed outside of the master MPO, such as saving the retrieved data.
+     */
+    PhaseTimer time_phase(Phase phase) {
+        return PhaseTimer(this->phase_times_[static_cast<unsigned int>(phase)], this->phase_mutex_);
+    }
+    /// @}
+
     /// @name Representation
     /// @{
     /** @brief String representation.*/
@@ -98,15 +242,46 @@ class MasterMpo {
 
     /// @name Set state
     /// @{
-    /** @brief Load pickled data.*/
+    /** @brief Get serialized metadata of each MPO file, to be pickled with the master MPO.*/
+    std::string get_mpofiles_state(void) const;
+    /** @brief Load pickled data.
+     *  @param mpofiles_state Serialized metadata of each MPO file returned by MasterMpo::get_mpofiles_state. If
+     *  empty, each MPO file is opened and read again.
+     */
     void set_state(const std::string & geometry, const std::string & energy_mesh, std::uint64_t n_zone,
                    const std::vector<std::string> & mpo_fnames,
                    const std::map<std::string, std::vector<double>> & master_pspace,
                    const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
-                   const std::map<std::string, ValidSet> & valid_set);
+                   const std::map<std::string, ValidSet> & valid_set,
+                   const std::string & mpofiles_state = std::string());
     /// @}
 
   protected:
+    /** @brief Check isotopes and reactions, and register the output arrays of each isotope.
+     *  @param global_skipped_idims Index of skipped dimensions in the parameter space.
+     *  @param discovery_lib Diffusion and Scattering outputs of isotopes whose valid set is unknown.
+     *  @param band_profiles Band structure of Scattering of each isotope, by interned isotope ID.
+     */
+    FlatLib register_outputs(const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
+                             const std::vector<std::string> & skipped_dims, std::uint64_t max_anisop_order,
+                             bool expand_scattering, std::vector<std::uint64_t> & global_skipped_idims,
+                             std::map<std::string, DiscoveryLib> & discovery_lib,
+                             std::map<std::uint32_t, NdArray> & band_profiles);
+    /** @brief Retrieve cross sections of each request from each MPO file to its library, or to a streamed output if
+     *  not null (single request only).
+     */
+    void read_outputs(const std::vector<XsTarget> & targets, const std::string & logfile, std::uint64_t n_threads,
+                      StreamLib * stream);
+    /** @brief Get index of the MPO file and index of the state point inside its output at an index of the master
+     *  parameter space.
+     *  @details If several files contain the state point, the last one is used, as in the extraction.
+     */
+    std::pair<std::uint64_t, std::uint64_t> locate_statept(const std::vector<std::uint64_t> & index);
+    /** @brief Open each MPO file and read its metadata.*/
+    void open_mpofiles(const std::vector<std::string> & mpo_fnames);
+    /** @brief Read metadata of each MPO file from an input stream, and read again files modified since.*/
+    void load_mpofiles(std::istream & is, const std::vector<std::string> & mpo_fnames);
+
     /** @brief Name of geometry.*/
     std::string geometry_;
     /** @brief Name of energy.*/
@@ -125,6 +300,20 @@ class MasterMpo {
     std::vector<std::string> avail_reactions_;
     /** @brief Valid configuration for each isotope.*/
     std::map<std::string, ValidSet> valid_set_;
+
+    /** @brief Index of the MPO file and index of the state point inside its output of each state point.*/
+    std::map<std::vector<std::uint64_t>, std::pair<std::uint64_t, std::uint64_t>> statept_locations_;
+    /** @brief Cache of cross sections at state points read by point queries.*/
+    XsCache query_cache_;
+    /** @brief Mutex guarding the map of state points and the MPO files read by concurrent point queries.*/
+    MovableMutex query_mutex_;
+
+    /** @brief Wall time in second of each phase.*/
+    std::array<double, n_phases> phase_times_ = {};
+    /** @brief Mutex guarding wall times of phases ended by concurrent calls.*/
+    mutable MovableMutex phase_mutex_;
+    /** @brief Counters of allocations and I/O operations not bound to an MPO file.*/
+    std::unique_ptr<IoCounters> io_counters_ = std::make_unique<IoCounters>();
 };
 
 }  // namespace readmpo
@@ -0,0 +1,45 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/mpo_index.hpp"
+
+#include <filesystem>  // std::filesystem::file_size, std::filesystem::last_write_time
+
+#include "readmpo/serializer.hpp"  // readmpo::serialize_obj, readmpo::deserialize_obj
+
+namespace readmpo {
+
+// Check if the index is up to date with the MPO file
+bool MpoIndex::is_valid_for(const std::string & fname) const {
+    auto [file_size, file_mtime] = get_fingerprint(fname);
+    return this->built() && (this->file_size == file_size) && (this->file_mtime == file_mtime);
+}
+
+// Write index to an output stream
+void MpoIndex::serialize(std::ostream & os) const {
+    serialize_obj(os, this->file_size);
+    serialize_obj(os, this->file_mtime);
+    serialize_obj(os, this->statepts);
+    serialize_obj(os, this->param_idx);
+    serialize_obj(os, this->zone_addr);
+}
+
+// Read index from an input stream
+void MpoIndex::deserialize(std::istream & is) {
+    deserialize_obj(is, this->file_size);
+    deserialize_obj(is, this->file_mtime);
+    deserialize_obj(is, this->statepts);
+    deserialize_obj(is, this->param_idx);
+    deserialize_obj(is, this->zone_addr);
+}
+
+// Get size and last modification time of a file
+std::pair<std::uint64_t, std::int64_t> get_fingerprint(const std::string & fname) {
+    std::error_code error;
+    std::uint64_t file_size = std::filesystem::file_size(fname, error);
+    if (error) {
+        return std::make_pair(0, 0);
+    }
+    std::int64_t file_mtime = std::filesystem::last_write_time(fname, error).time_since_epoch().count();
+    return std::make_pair(file_size, file_mtime);
+}
+
+}  // namespace readmpo
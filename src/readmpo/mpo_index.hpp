@@ -0,0 +1,60 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_MPO_INDEX_HPP_
+#define READMPO_MPO_INDEX_HPP_
+
+#include <cstdint>  // std::int64_t, std::uint64_t
+#include <istream>  // std::istream
+#include <ostream>  // std::ostream
+#include <string>   // std::string
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+namespace readmpo {
+
+/** @brief Structural index of the output of an MPO file.
+ *  @details Local index of each state point in the parameter space and addresses of each zone, allowing to read cross
+ *  sections without traversing metadata groups. The index is invalidated if the size or the last modification time of
+ *  the file changes.
+ */
+struct MpoIndex {
+    /// @name Fingerprint
+    /// @{
+    /** @brief Size of the MPO file.*/
+    std::uint64_t file_size = 0;
+    /** @brief Last modification time of the MPO file.*/
+    std::int64_t file_mtime = 0;
+    /// @}
+
+    /// @name Index
+    /// @{
+    /** @brief Name of state point groups.*/
+    std::vector<std::string> statepts;
+    /** @brief Local index of each state point on each dimension (``PARAMVALUEORD``).*/
+    std::vector<std::vector<int>> param_idx;
+    /** @brief ``ADDRZX`` and ``ADDRZI`` of each zone of each state point (``-1`` if not yet read).*/
+    std::vector<std::pair<int, int>> zone_addr;
+    /// @}
+
+    /// @name Status
+    /// @{
+    /** @brief Check if state points are indexed.*/
+    bool built(void) const noexcept { return !this->statepts.empty(); }
+    /** @brief Check if the index is up to date with the MPO file.*/
+    bool is_valid_for(const std::string & fname) const;
+    /// @}
+
+    /// @name Serialization
+    /// @{
+    /** @brief Write index to an output stream.*/
+    void serialize(std::ostream & os) const;
+    /** @brief Read index from an input stream.*/
+    void deserialize(std::istream & is);
+    /// @}
+};
+
+/** @brief Get size and last modification time of a file.*/
+std::pair<std::uint64_t, std::int64_t> get_fingerprint(const std::string & fname);
+
+}  // namespace readmpo
+
+#endif  // READMPO_MPO_INDEX_HPP_
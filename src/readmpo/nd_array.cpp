@@ -1,13 +1,20 @@
 // Copyright 2023 quocdang1998
 #include "readmpo/nd_array.hpp"
 
-#include <cstring>    // std::memset
-#include <fstream>    // std::ofstream
+#include <algorithm>  // std::min
+#include <cstdlib>    // std::calloc, std::free
+#include <cstring>    // std::memcpy, std::memset
+#include <fstream>    // std::ofstream, std::ostream
 #include <sstream>    // std::ostringstream
-#include <stdexcept>  // std::invalid_argument
+#include <stdexcept>  // std::invalid_argument, std::runtime_error
+
+#include "readmpo/profile.hpp"  // readmpo::record_allocation
 
 namespace readmpo {
 
+// Number of elements gathered before each write when serializing a non-contiguous array
+static constexpr std::uint64_t serialize_buffer_size = 1 << 16;
+
 // Get leap
 static std::uintptr_t get_leap(std::uint64_t index, const std::vector<std::uint64_t> & shape,
                                const std::vector<std::uint64_t> & strides) {
@@ -21,8 +28,63 @@ static std::uintptr_t get_leap(std::uint64_t index, const std::vector<std::uint6
     return leap;
 }
 
+// Get strides of a C-contiguous array
+static std::vector<std::uint64_t> get_c_strides(const std::vector<std::uint64_t> & shape) {
+    std::vector<std::uint64_t> strides(shape.size());
+    std::uint64_t cumprod = sizeof(double);
+    for (std::int64_t i = shape.size() - 1; i >= 0; i--) {
+        strides[i] = cumprod;
+        cumprod *= shape[i];
+    }
+    return strides;
+}
+
+// Apply a function on each element in C order, walking the strides directly
+template <typename Function>
+static void for_each_element(const double * data, std::uint64_t size, const std::vector<std::uint64_t> & shape,
+                             const std::vector<std::uint64_t> & strides, Function && function) {
+    if (size == 0) {
+        return;
+    }
+    std::uint64_t ndim = shape.size();
+    if (ndim == 0) {
+        function(*data);
+        return;
+    }
+    std::vector<std::uint64_t> nd_index(ndim, 0);
+    std::uintptr_t row = reinterpret_cast<std::uintptr_t>(data);
+    std::uint64_t row_size = shape[ndim - 1], row_stride = strides[ndim - 1];
+    for (std::uint64_t i_row = 0; i_row < size / row_size; i_row++) {
+        // walk the last dimension
+        std::uintptr_t element = row;
+        for (std::uint64_t i = 0; i < row_size; i++) {
+            function(*(reinterpret_cast<const double *>(element)));
+            element += row_stride;
+        }
+        // move to the next row
+        for (std::int64_t i_dim = ndim - 2; i_dim >= 0; i_dim--) {
+            row += strides[i_dim];
+            if (++nd_index[i_dim] < shape[i_dim]) {
+                break;
+            }
+            row -= shape[i_dim] * strides[i_dim];
+            nd_index[i_dim] = 0;
+        }
+    }
+}
+
+// Copy data of an array to a C-contiguous buffer
+static void copy_to_contiguous(const NdArray & src, double * destination) {
+    if (src.is_contiguous()) {
+        std::memcpy(destination, src.data(), src.size() * sizeof(double));
+        return;
+    }
+    for_each_element(src.data(), src.size(), src.shape(), src.strides(),
+                     [&destination](const double & element) { *(destination++) = element; });
+}
+
 // Constructor from shape
-NdArray::NdArray(const std::vector<std::uint64_t> & shape) : shape_(shape), strides_(shape.size()) {
+NdArray::NdArray(const std::vector<std::uint64_t> & shape) : shape_(shape), strides_(get_c_strides(shape)) {
     // calculate number of element and allocate memory
     this->size_ = 1;
     for (std::uint64_t i = 0; i < this->ndim(); i++) {
@@ -30,17 +92,30 @@ NdArray::NdArray(const std::vector<std::uint64_t> & shape) : shape_(shape), stri
     }
     this->data_ = new double[this->size_];
     std::memset(this->data_, 0, this->size_ * sizeof(double));
-    // calculate stride vector
-    std::uint64_t cumprod = sizeof(double);
-    for (std::int64_t i = this->ndim() - 1; i >= 0; i--) {
-        this->strides_[i] = cumprod;
-        cumprod *= shape[i];
-    }
 }
 
 // Constructor from buffer protocol
 NdArray::NdArray(double * data, std::vector<std::uint64_t> && shape, std::vector<std::uint64_t> && strides) :
-data_(data), shape_(std::move(shape)), strides_(std::move(strides)), free(false) {
+data_(data), free(false), shape_(std::move(shape)), strides_(std::move(strides)) {
+    // calculate number of element
+    this->size_ = 1;
+    for (std::uint64_t i = 0; i < this->ndim(); i++) {
+        this->size_ *= this->shape_[i];
+    }
+    // check if the buffer is C-contiguous (strides of dimensions with one element are irrelevant)
+    std::vector<std::uint64_t> c_strides = get_c_strides(this->shape_);
+    for (std::uint64_t i = 0; i < this->ndim(); i++) {
+        if ((this->shape_[i] > 1) && (this->strides_[i] != c_strides[i])) {
+            this->contiguous_ = false;
+            break;
+        }
+    }
+}
+
+// Constructor of a C-contiguous view into an arena
+NdArray::NdArray(const std::shared_ptr<double[]> & arena, std::uint64_t offset,
+                 const std::vector<std::uint64_t> & shape) :
+data_(arena.get() + offset), free(false), shape_(shape), strides_(get_c_strides(shape)), arena_(arena) {
     // calculate number of element
     this->size_ = 1;
     for (std::uint64_t i = 0; i < this->ndim(); i++) {
@@ -49,66 +124,75 @@ data_(data), shape_(std::move(shape)), strides_(std::move(strides)), free(false)
 }
 
 // Copy constructor
-NdArray::NdArray(const NdArray & src) : shape_(src.shape_), strides_(src.ndim()), size_(src.size_) {
-    // copy data
+NdArray::NdArray(const NdArray & src) : size_(src.size_), shape_(src.shape_), strides_(get_c_strides(src.shape_)) {
     this->data_ = new double[src.size_];
-    for (std::uint64_t i = 0; i < src.size_; i++) {
-        this->data_[i] = src[i];
-    }
-    // calculate strides
-    std::uint64_t cumprod = sizeof(double);
-    for (std::int64_t i = this->ndim() - 1; i >= 0; i--) {
-        this->strides_[i] = cumprod;
-        cumprod *= this->shape_[i];
-    }
+    copy_to_contiguous(src, this->data_);
 }
 
 // Copy assignment
 NdArray & NdArray::operator=(const NdArray & src) {
+    if (this == &src) {
+        return *this;
+    }
     // free current data
     if ((this->data_ != nullptr) && this->free) {
         delete[] this->data_;
     }
     // direct assignment
     this->shape_ = src.shape_;
+    this->strides_ = get_c_strides(src.shape_);
     this->size_ = src.size_;
     this->free = true;
+    this->contiguous_ = true;
+    this->arena_.reset();
     // copy data
     this->data_ = new double[src.size_];
-    for (std::uint64_t i = 0; i < src.size_; i++) {
-        this->data_[i] = src[i];
-    }
-    // calculate strides
-    this->strides_ = std::vector<std::uint64_t>(src.ndim());
-    std::uint64_t cumprod = sizeof(double);
-    for (std::int64_t i = this->ndim() - 1; i >= 0; i--) {
-        this->strides_[i] = cumprod;
-        cumprod *= this->shape_[i];
-    }
+    copy_to_contiguous(src, this->data_);
     return *this;
 }
 
 // Move constructor
 NdArray::NdArray(NdArray && src) :
+free(src.free),
+contiguous_(src.contiguous_),
 shape_(std::forward<std::vector<std::uint64_t>>(src.shape_)),
 strides_(std::forward<std::vector<std::uint64_t>>(src.strides_)),
-free(src.free) {
+arena_(std::move(src.arena_)) {
     std::swap(this->size_, src.size_);
     std::swap(this->data_, src.data_);
 }
 
 // Move assignment
 NdArray & NdArray::operator=(NdArray && src) {
+    if (this == &src) {
+        return *this;
+    }
+    if ((this->data_ != nullptr) && this->free) {
+        delete[] this->data_;
+    }
     this->shape_ = std::move(src.shape_);
     this->strides_ = std::move(src.strides_);
     this->free = src.free;
+    this->contiguous_ = src.contiguous_;
+    this->arena_ = std::move(src.arena_);
     this->size_ = std::exchange(src.size_, 0);
     this->data_ = std::exchange(src.data_, nullptr);
     return *this;
 }
 
+// Get another view of the same data
+NdArray NdArray::view(void) const {
+    if (!this->arena_) {
+        throw std::runtime_error("Cannot create a view of an array not allocated in an arena.\n");
+    }
+    return NdArray(this->arena_, this->data_ - this->arena_.get(), this->shape_);
+}
+
 // Get reference to an element by C-contiguous index
 double & NdArray::operator[](std::uint64_t index) {
+    if (this->contiguous_) {
+        return this->data_[index];
+    }
     std::uintptr_t destination = reinterpret_cast<std::uintptr_t>(this->data_);
     destination += get_leap(index, this->shape_, this->strides_);
     return *(reinterpret_cast<double *>(destination));
@@ -116,6 +200,9 @@ double & NdArray::operator[](std::uint64_t index) {
 
 // Get constant reference to an element by C-contiguous index
 const double & NdArray::operator[](std::uint64_t index) const {
+    if (this->contiguous_) {
+        return this->data_[index];
+    }
     std::uintptr_t destination = reinterpret_cast<std::uintptr_t>(this->data_);
     destination += get_leap(index, this->shape_, this->strides_);
     return *(reinterpret_cast<double *>(destination));
@@ -149,10 +236,11 @@ const double & NdArray::operator[](const std::vector<std::uint64_t> & index) con
 std::string NdArray::str(void) const {
     std::ostringstream os;
     os << "<NdData(";
-    for (std::uint64_t i = 0; i < this->size_; i++) {
-        os << ((i != 0) ? " " : "");
-        os << this->operator[](i);
-    }
+    const char * separator = "";
+    for_each_element(this->data_, this->size_, this->shape_, this->strides_, [&](const double & element) {
+        os << separator << element;
+        separator = " ";
+    });
     os << ")>";
     return os.str();
 }
@@ -166,14 +254,30 @@ void NdArray::serialize(const std::string & fname) const {
     std::uint64_t ndim = this->ndim();
     outfile.write(reinterpret_cast<char *>(&ndim), sizeof(std::uint64_t));
     outfile.write(reinterpret_cast<const char *>(this->shape_.data()), ndim * sizeof(std::uint64_t));
-    // outfile.write(reinterpret_cast<const char *>(this->data_.data()), this->data_.size() * sizeof(double));
-    for (std::uint64_t i = 0; i < this->size_; i++) {
-        const double * p_elem = &(this->operator[](i));
-        outfile.write(reinterpret_cast<const char *>(p_elem), sizeof(double));
-    }
+    this->write_data(outfile);
     outfile.close();
 }
 
+// Write elements in C-contiguous order to a binary stream
+void NdArray::write_data(std::ostream & os) const {
+    if (this->contiguous_) {
+        // write data directly
+        os.write(reinterpret_cast<const char *>(this->data_), this->size_ * sizeof(double));
+        return;
+    }
+    // gather elements to a buffer and write it when full
+    std::vector<double> buffer;
+    buffer.reserve(std::min<std::uint64_t>(this->size_, serialize_buffer_size));
+    for_each_element(this->data_, this->size_, this->shape_, this->strides_, [&](const double & element) {
+        buffer.push_back(element);
+        if (buffer.size() == buffer.capacity()) {
+            os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(double));
+            buffer.clear();
+        }
+    });
+    os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(double));
+}
+
 // Destructor
 NdArray::~NdArray(void) {
     if ((this->data_ != nullptr) && this->free) {
@@ -181,4 +285,14 @@ NdArray::~NdArray(void) {
     }
 }
 
+// Allocate a zero-filled arena of double
+std::shared_ptr<double[]> allocate_arena(std::uint64_t size) {
+    double * data = static_cast<double *>(std::calloc((size != 0) ? size : 1, sizeof(double)));
+    if (data == nullptr) {
+        throw std::runtime_error("Cannot allocate memory for the arena.\n");
+    }
+    record_allocation(size * sizeof(double));
+    return std::shared_ptr<double[]>(data, [](double * p) { std::free(p); });
+}
+
 }  // namespace readmpo
@@ -3,13 +3,18 @@
 #define READMPO_ND_ARRAY_HPP_
 
 #include <cstdint>  // std::uint64_t
+#include <memory>   // std::shared_ptr
+#include <ostream>  // std::ostream
 #include <string>   // std::string
 #include <utility>  // std::forward, std::move
 #include <vector>   // std::vector
 
 namespace readmpo {
 
-/** @brief C-contiguous multi-dimensional array.*/
+/** @brief Multi-dimensional array.
+ *  @details Arrays allocated by the library are C-contiguous. Arrays constructed from the buffer protocol may be
+ *  strided, in which case elements are accessed by walking the strides.
+ */
 class NdArray {
   public:
     /// @name Constructors
@@ -20,6 +25,12 @@ class NdArray {
     NdArray(const std::vector<std::uint64_t> & shape);
     /** @brief Constructor from buffer protocol.*/
     NdArray(double * data, std::vector<std::uint64_t> && shape, std::vector<std::uint64_t> && strides);
+    /** @brief Constructor of a C-contiguous view into an arena.
+     *  @param arena Arena shared by all of its views, released when the last view is destroyed.
+     *  @param offset Offset (in number of elements) of the first element of the view in the arena.
+     *  @param shape Shape of the view.
+     */
+    NdArray(const std::shared_ptr<double[]> & arena, std::uint64_t offset, const std::vector<std::uint64_t> & shape);
     /// @}
 
     /// @name Copy and move
@@ -38,6 +49,16 @@ class NdArray {
     /// @{
     /** @brief Get pointer to data.*/
     const double * data(void) const noexcept { return this->data_; }
+    /** @brief Get number of elements.*/
+    std::uint64_t size(void) const noexcept { return this->size_; }
+    /** @brief Check if elements are stored in C-contiguous order.*/
+    bool is_contiguous(void) const noexcept { return this->contiguous_; }
+    /** @brief Get arena containing the data (empty if the array is not a view into an arena).*/
+    const std::shared_ptr<double[]> & arena(void) const noexcept { return this->arena_; }
+    /** @brief Get another view of the same data.
+     *  @details Only available for views into an arena.
+     */
+    NdArray view(void) const;
     /** @brief Get number of dimensions.*/
     std::uint64_t ndim(void) const noexcept { return this->shape_.size(); }
     /** @brief Get constant reference to the shape vector.*/
@@ -68,6 +89,8 @@ class NdArray {
     /// @{
     /** @brief Write data in form of a Stock file to storage.*/
     void serialize(const std::string & fname) const;
+    /** @brief Write elements in C-contiguous order to a binary stream.*/
+    void write_data(std::ostream & os) const;
     /// @}
 
     /// @name Destructor
@@ -83,12 +106,22 @@ class NdArray {
     std::uint64_t size_ = 0;
     /** @brief De-allocate memory in destructor.*/
     bool free = true;
+    /** @brief Elements are stored in C-contiguous order.*/
+    bool contiguous_ = true;
     /** @brief Shape vector.*/
     std::vector<std::uint64_t> shape_;
     /** @brief Stride vector.*/
     std::vector<std::uint64_t> strides_;
+    /** @brief Arena containing the data.*/
+    std::shared_ptr<double[]> arena_;
 };
 
+/** @brief Allocate a zero-filled arena of double.
+ *  @details The allocation is recorded to the I/O counters of the calling thread (see readmpo::IoScope).
+ *  @param size Number of elements.
+ */
+std::shared_ptr<double[]> allocate_arena(std::uint64_t size);
+
 }  // namespace readmpo
 
 #endif  // READMPO_ND_ARRAY_HPP_
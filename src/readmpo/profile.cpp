@@ -0,0 +1,116 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/profile.hpp"
+
+#include <cstdio>   // std::snprintf
+#include <ostream>  // std::ostream
+#include <sstream>  // std::ostringstream
+
+namespace readmpo {
+
+// Name of each phase
+static const std::array<const char *, n_phases> phase_names = {"open", "pspace_merge", "valid_set", "extraction",
+                                                               "serialization"};
+
+// Get name of a phase
+const char * phase_name(Phase phase) noexcept { return phase_names[static_cast<unsigned int>(phase)]; }
+
+// Reset all counters to zero
+void IoCounters::reset(void) noexcept {
+    this->objects_opened = 0;
+    this->datasets_read = 0;
+    this->bytes_read = 0;
+    this->allocations = 0;
+    this->bytes_allocated = 0;
+}
+
+// Get value of each counter by its name
+std::map<std::string, std::uint64_t> IoCounters::to_map(void) const {
+    std::map<std::string, std::uint64_t> result;
+    result["objects_opened"] = this->objects_opened.load();
+    result["datasets_read"] = this->datasets_read.load();
+    result["bytes_read"] = this->bytes_read.load();
+    result["allocations"] = this->allocations.load();
+    result["bytes_allocated"] = this->bytes_allocated.load();
+    return result;
+}
+
+// Get a reference to the pointer to the counters recording I/O operations of the calling thread
+IoCounters *& current_io_counters(void) noexcept {
+    static thread_local IoCounters * counters = nullptr;
+    return counters;
+}
+
+// Record the opening of HDF5 objects by the calling thread
+void record_open(std::uint64_t n_objects) noexcept {
+    if (IoCounters * counters = current_io_counters(); counters != nullptr) {
+        counters->objects_opened.fetch_add(n_objects, std::memory_order_relaxed);
+    }
+}
+
+// Record the read of a dataset by the calling thread
+void record_read(std::uint64_t n_bytes) noexcept {
+    if (IoCounters * counters = current_io_counters(); counters != nullptr) {
+        counters->datasets_read.fetch_add(1, std::memory_order_relaxed);
+        counters->bytes_read.fetch_add(n_bytes, std::memory_order_relaxed);
+    }
+}
+
+// Record the allocation of an output array by the calling thread
+void record_allocation(std::uint64_t n_bytes) noexcept {
+    if (IoCounters * counters = current_io_counters(); counters != nullptr) {
+        counters->allocations.fetch_add(1, std::memory_order_relaxed);
+        counters->bytes_allocated.fetch_add(n_bytes, std::memory_order_relaxed);
+    }
+}
+
+// Write a string as a JSON string literal
+void write_json_string(std::ostream & os, const std::string & s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+            os << escaped;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+// Write counters as a JSON object
+static void write_json_counters(std::ostream & os, const std::map<std::string, std::uint64_t> & counters) {
+    os << "{";
+    for (auto it = counters.begin(); it != counters.end(); ++it) {
+        os << ((it == counters.begin()) ? "" : ", ");
+        write_json_string(os, it->first);
+        os << ": " << it->second;
+    }
+    os << "}";
+}
+
+// Get JSON representation
+std::string Profile::json(void) const {
+    std::ostringstream os;
+    os << "{\n  \"phases\": {";
+    for (auto it = this->phase_times.begin(); it != this->phase_times.end(); ++it) {
+        os << ((it == this->phase_times.begin()) ? "" : ", ");
+        write_json_string(os, it->first);
+        os << ": " << it->second;
+    }
+    os << "},\n  \"total\": ";
+    write_json_counters(os, this->total);
+    os << ",\n  \"files\": {";
+    for (auto it = this->files.begin(); it != this->files.end(); ++it) {
+        os << ((it == this->files.begin()) ? "\n    " : ",\n    ");
+        write_json_string(os, it->first);
+        os << ": ";
+        write_json_counters(os, it->second);
+    }
+    os << ((this->files.empty()) ? "}\n}\n" : "\n  }\n}\n");
+    return os.str();
+}
+
+}  // namespace readmpo
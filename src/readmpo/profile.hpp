@@ -0,0 +1,158 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_PROFILE_HPP_
+#define READMPO_PROFILE_HPP_
+
+#include <array>    // std::array
+#include <atomic>   // std::atomic
+#include <chrono>   // std::chrono::steady_clock
+#include <cstdint>  // std::uint64_t
+#include <map>      // std::map
+#include <mutex>    // std::lock_guard, std::mutex
+#include <ostream>  // std::ostream
+#include <string>   // std::string
+
+namespace readmpo {
+
+/** @brief Phase of the retrieval of data from MPO files.*/
+enum class Phase : unsigned int {
+    /** @brief Open MPO files and read their metadata.*/
+    Open = 0,
+    /** @brief Merge parameter spaces of all MPO files.*/
+    PspaceMerge = 1,
+    /** @brief Compute valid set of Diffusion and Scattering.*/
+    ValidSet = 2,
+    /** @brief Retrieve cross sections or concentrations.*/
+    Extraction = 3,
+    /** @brief Serialize or deserialize the master MPO and the retrieved data.*/
+    Serialization = 4
+};
+
+/** @brief Number of phases.*/
+inline constexpr std::uint64_t n_phases = 5;
+
+/** @brief Get name of a phase.*/
+const char * phase_name(Phase phase) noexcept;
+
+/** @brief Counters of I/O operations and output allocations.
+ *  @details Counters are atomic, so that threads reading state points of the same file update them concurrently.
+ */
+struct IoCounters {
+    /** @brief Number of HDF5 files, groups and datasets opened.*/
+    std::atomic<std::uint64_t> objects_opened = 0;
+    /** @brief Number of datasets read.*/
+    std::atomic<std::uint64_t> datasets_read = 0;
+    /** @brief Number of bytes read from datasets.*/
+    std::atomic<std::uint64_t> bytes_read = 0;
+    /** @brief Number of allocations of output arrays.*/
+    std::atomic<std::uint64_t> allocations = 0;
+    /** @brief Number of bytes allocated for output arrays.*/
+    std::atomic<std::uint64_t> bytes_allocated = 0;
+
+    /** @brief Reset all counters to zero.*/
+    void reset(void) noexcept;
+    /** @brief Get value of each counter by its name.*/
+    std::map<std::string, std::uint64_t> to_map(void) const;
+};
+
+/** @brief Get a reference to the pointer to the counters recording I/O operations of the calling thread.
+ *  @details Operations are not recorded if the pointer is null.
+ */
+IoCounters *& current_io_counters(void) noexcept;
+
+/** @brief Record I/O operations of the calling thread to some counters until the end of the scope.
+ *  @details Counters recorded to before the scope are restored at its end, so that scopes can be nested.
+ */
+class IoScope {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Constructor from the counters to record to.*/
+    IoScope(IoCounters * counters) noexcept : previous_(current_io_counters()) { current_io_counters() = counters; }
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    IoScope(const IoScope & src) = delete;
+    /** @brief Copy assignment.*/
+    IoScope & operator=(const IoScope & src) = delete;
+    /// @}
+
+    /// @name Destructor
+    /// @{
+    /** @brief Restore the counters recorded to before the scope.*/
+    ~IoScope(void) { current_io_counters() = this->previous_; }
+    /// @}
+
+  protected:
+    /** @brief Counters recorded to before the scope.*/
+    IoCounters * previous_;
+};
+
+/** @brief Record the opening of HDF5 objects by the calling thread.*/
+void record_open(std::uint64_t n_objects = 1) noexcept;
+
+/** @brief Record the read of a dataset by the calling thread.*/
+void record_read(std::uint64_t n_bytes) noexcept;
+
+/** @brief Record the allocation of an output array by the calling thread.*/
+void record_allocation(std::uint64_t n_bytes) noexcept;
+
+/** @brief Add the wall time elapsed between its construction and its destruction to a phase.
+ *  @details The accumulated time is updated under a mutex, so that timers of the same phase can end concurrently.
+ */
+class PhaseTimer {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Constructor from the accumulated time of the phase in second and the mutex guarding it.*/
+    PhaseTimer(double & elapsed, std::mutex & mutex) noexcept :
+    elapsed_(elapsed), mutex_(mutex), begin_(std::chrono::steady_clock::now()) {}
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    PhaseTimer(const PhaseTimer & src) = delete;
+    /** @brief Copy assignment.*/
+    PhaseTimer & operator=(const PhaseTimer & src) = delete;
+    /// @}
+
+    /// @name Destructor
+    /// @{
+    /** @brief Add elapsed time to the phase.*/
+    ~PhaseTimer(void) {
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->begin_).count();
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->elapsed_ += elapsed;
+    }
+    /// @}
+
+  protected:
+    /** @brief Accumulated time of the phase.*/
+    double & elapsed_;
+    /** @brief Mutex guarding the accumulated time.*/
+    std::mutex & mutex_;
+    /** @brief Time point of the construction.*/
+    std::chrono::steady_clock::time_point begin_;
+};
+
+/** @brief Write a string as a JSON string literal.*/
+void write_json_string(std::ostream & os, const std::string & s);
+
+/** @brief Wall time of each phase and I/O counters of each MPO file.*/
+struct Profile {
+    /** @brief Wall time in second of each phase, by name of the phase.*/
+    std::map<std::string, double> phase_times;
+    /** @brief Sum of the counters of all MPO files and of the operations not bound to a file.*/
+    std::map<std::string, std::uint64_t> total;
+    /** @brief I/O counters of each MPO file, by filename (allocations of output arrays are only counted in total).*/
+    std::map<std::string, std::map<std::string, std::uint64_t>> files;
+
+    /** @brief Get JSON representation.*/
+    std::string json(void) const;
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_PROFILE_HPP_
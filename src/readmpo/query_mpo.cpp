@@ -1,9 +1,17 @@
 // Copyright 2023 quocdang1998
 #include "readmpo/query_mpo.hpp"
 
+#include <exception>  // std::exception
+#include <set>        // std::set
+#include <sstream>    // std::ostringstream
+#include <utility>    // std::pair
+
 #include "H5Cpp.h"  // H5::H5File
 
-#include "readmpo/h5_utils.hpp"  // readmpo::get_dset, readmpo::trim
+#include "readmpo/h5_utils.hpp"  // readmpo::check_string_in_array, readmpo::get_dset, readmpo::get_dset_shape,
+                                 // readmpo::lock_h5, readmpo::lowercase, readmpo::ndim_to_c_idx,
+                                 // readmpo::parallel_for, readmpo::stringify, readmpo::trim
+#include "readmpo/profile.hpp"   // readmpo::record_open, readmpo::write_json_string
 
 namespace readmpo {
 
@@ -28,4 +36,208 @@ std::map<std::string, std::vector<std::string>> query_mpo(const std::string & mp
     return result;
 }
 
+// Read a dataset under the HDF5 lock, so that threads reading other files can run in between
+template <typename T>
+static std::pair<std::vector<T>, std::vector<std::uint64_t>> get_dset_locked(H5::Group * group,
+                                                                             const std::string & dset_address) {
+    auto h5_lock = lock_h5();
+    return get_dset<T>(group, dset_address.c_str());
+}
+
+// Read metadata of an MPO file, stop as soon as the requested geometry or energy mesh is missing
+static void read_metadata(H5::H5File & mpofile, const std::string & geometry, const std::string & energy_mesh,
+                          MpoMetadata & metadata) {
+    // get geometry names and check for the requested one
+    auto [geometry_names, n_geometry] = get_dset_locked<std::string>(&mpofile, "geometry/GEOMETRY_NAME");
+    for (std::string & geometry_name : geometry_names) {
+        metadata.geometries.push_back(trim(geometry_name));
+    }
+    std::uint64_t geom_id = (geometry.empty()) ? 0 : check_string_in_array(geometry, metadata.geometries);
+    if (geom_id == UINT64_MAX) {
+        metadata.status = "missing geometry";
+        return;
+    }
+    // get energy mesh names and check for the requested one
+    auto [emesh_names, n_emesh] = get_dset_locked<std::string>(&mpofile, "energymesh/ENERGYMESH_NAME");
+    for (std::string & emesh_name : emesh_names) {
+        metadata.energy_meshes.push_back(trim(emesh_name));
+    }
+    std::uint64_t emesh_id = (energy_mesh.empty()) ? 0 : check_string_in_array(energy_mesh, metadata.energy_meshes);
+    if (emesh_id == UINT64_MAX) {
+        metadata.status = "missing energy mesh";
+        return;
+    }
+    // get number of zones and groups (of the requested geometry and energy mesh only if any)
+    for (std::uint64_t i_geom = 0; i_geom < metadata.geometries.size(); i_geom++) {
+        if (!geometry.empty() && (i_geom != geom_id)) {
+            continue;
+        }
+        auto [nzone, _nz] = get_dset_locked<int>(&mpofile, stringify("geometry/geometry_", i_geom, "/NZONE"));
+        metadata.n_zones[metadata.geometries[i_geom]] = nzone[0];
+    }
+    for (std::uint64_t i_emesh = 0; i_emesh < metadata.energy_meshes.size(); i_emesh++) {
+        if (!energy_mesh.empty() && (i_emesh != emesh_id)) {
+            continue;
+        }
+        auto [ngroup, _ng] = get_dset_locked<int>(&mpofile, stringify("energymesh/energymesh_", i_emesh, "/NG"));
+        metadata.n_groups[metadata.energy_meshes[i_emesh]] = ngroup[0];
+    }
+    // get number of values of each parameter (values are not read)
+    auto [param_names, n_params] = get_dset_locked<std::string>(&mpofile, "parameters/info/PARAMNAME");
+    for (std::uint64_t i_param = 0; i_param < param_names.size(); i_param++) {
+        std::string param_id = stringify("parameters/values/PARAM_", i_param);
+        std::vector<std::uint64_t> values_shape;
+        {
+            auto h5_lock = lock_h5();
+            values_shape = get_dset_shape(&mpofile, param_id.c_str());
+        }
+        metadata.n_values[lowercase(trim(param_names[i_param]))] = (values_shape.empty()) ? 1 : values_shape[0];
+    }
+    // get isotopes and reactions of the file, or of the output if both geometry and energy mesh are requested
+    auto [isotope_names, n_isotopes] = get_dset_locked<std::string>(&mpofile, "contents/isotopes/ISOTOPENAME");
+    auto [reaction_names, n_reactions] = get_dset_locked<std::string>(&mpofile, "contents/reactions/REACTIONAME");
+    if (geometry.empty() || energy_mesh.empty()) {
+        for (std::string & isotope_name : isotope_names) {
+            metadata.isotopes.push_back(trim(isotope_name));
+        }
+        for (std::string & reaction_name : reaction_names) {
+            metadata.reactions.push_back(trim(reaction_name));
+        }
+        metadata.status = "ok";
+        return;
+    }
+    auto [output_ids, outputid_shape] = get_dset_locked<int>(&mpofile, "output/OUPUTID");
+    int output_id = output_ids[ndim_to_c_idx({geom_id, emesh_id}, outputid_shape)];
+    if (output_id < 0) {
+        metadata.status = "missing output";
+        return;
+    }
+    std::vector<int> i_isos, i_reacs;
+    {
+        // the group is closed before the lock is released
+        auto h5_lock = lock_h5();
+        H5::Group output = mpofile.openGroup(stringify("output/output_", output_id).c_str());
+        i_isos = get_dset<int>(&output, "info/ISOTOPE").first;
+        i_reacs = get_dset<int>(&output, "info/REACTION").first;
+    }
+    std::set<std::string> output_isotopes;
+    for (int i_iso : i_isos) {
+        output_isotopes.insert(trim(isotope_names.at(i_iso)));
+    }
+    metadata.isotopes.assign(output_isotopes.begin(), output_isotopes.end());
+    for (int i_reac : i_reacs) {
+        metadata.reactions.push_back(trim(reaction_names.at(i_reac)));
+    }
+    metadata.status = "ok";
+}
+
+// Disable the automatic printing of HDF5 errors by the calling thread until the end of the scope
+class H5ErrorSilencer {
+  public:
+    H5ErrorSilencer(void) {
+        auto h5_lock = lock_h5();
+        H5::Exception::getAutoPrint(this->func_, &(this->client_data_));
+        H5::Exception::dontPrint();
+    }
+    H5ErrorSilencer(const H5ErrorSilencer & src) = delete;
+    H5ErrorSilencer & operator=(const H5ErrorSilencer & src) = delete;
+    ~H5ErrorSilencer(void) {
+        auto h5_lock = lock_h5();
+        H5::Exception::setAutoPrint(this->func_, this->client_data_);
+    }
+
+  protected:
+    H5E_auto2_t func_ = nullptr;
+    void * client_data_ = nullptr;
+};
+
+// Read metadata of many MPO files concurrently
+std::vector<MpoMetadata> query_mpo_metadata(const std::vector<std::string> & mpofile_list,
+                                            const std::string & geometry, const std::string & energy_mesh,
+                                            std::uint64_t n_threads) {
+    // errors are reported in the status of each file, so the HDF5 error stack is not printed during the query
+    H5ErrorSilencer silencer;
+    std::vector<MpoMetadata> metadata(mpofile_list.size());
+    parallel_for(mpofile_list.size(), n_threads, [&](std::uint64_t i_file) {
+#ifdef H5_HAVE_THREADSAFE
+        // the thread-safe library keeps one error handler per thread
+        H5ErrorSilencer thread_silencer;
+#endif  // H5_HAVE_THREADSAFE
+        MpoMetadata & file_metadata = metadata[i_file];
+        file_metadata.fname = mpofile_list[i_file];
+        try {
+            // files are opened without the pool, as each of them is read once, and the HDF5 lock is only held during
+            // each HDF5 call, so that threads take turns reading their files
+            auto h5_lock = lock_h5();
+            H5::H5File mpofile(mpofile_list[i_file].c_str(), H5F_ACC_RDONLY);
+            record_open();
+            h5_lock.unlock();
+            try {
+                read_metadata(mpofile, geometry, energy_mesh, file_metadata);
+            } catch (...) {
+                // close the file under the lock
+                h5_lock.lock();
+                throw;
+            }
+            h5_lock.lock();
+        } catch (const H5::Exception & e) {
+            file_metadata.status = e.getDetailMsg();
+        } catch (const std::exception & e) {
+            file_metadata.status = e.what();
+        }
+    });
+    return metadata;
+}
+
+// Write a list of strings as a JSON array
+static void write_json_strings(std::ostream & os, const std::vector<std::string> & strings) {
+    os << "[";
+    for (std::uint64_t i = 0; i < strings.size(); i++) {
+        os << ((i == 0) ? "" : ", ");
+        write_json_string(os, strings[i]);
+    }
+    os << "]";
+}
+
+// Write a map of counts as a JSON object
+static void write_json_counts(std::ostream & os, const std::map<std::string, std::uint64_t> & counts) {
+    os << "{";
+    for (auto it = counts.begin(); it != counts.end(); ++it) {
+        os << ((it == counts.begin()) ? "" : ", ");
+        write_json_string(os, it->first);
+        os << ": " << it->second;
+    }
+    os << "}";
+}
+
+// Get JSON representation of the metadata of MPO files
+std::string metadata_json(const std::vector<MpoMetadata> & metadata) {
+    std::ostringstream os;
+    os << "[";
+    for (std::uint64_t i_file = 0; i_file < metadata.size(); i_file++) {
+        const MpoMetadata & file_metadata = metadata[i_file];
+        os << ((i_file == 0) ? "\n  {" : ",\n  {") << "\"fname\": ";
+        write_json_string(os, file_metadata.fname);
+        os << ", \"status\": ";
+        write_json_string(os, file_metadata.status);
+        os << ", \"geometries\": ";
+        write_json_strings(os, file_metadata.geometries);
+        os << ", \"energy_meshes\": ";
+        write_json_strings(os, file_metadata.energy_meshes);
+        os << ", \"n_zones\": ";
+        write_json_counts(os, file_metadata.n_zones);
+        os << ", \"n_groups\": ";
+        write_json_counts(os, file_metadata.n_groups);
+        os << ", \"n_values\": ";
+        write_json_counts(os, file_metadata.n_values);
+        os << ", \"isotopes\": ";
+        write_json_strings(os, file_metadata.isotopes);
+        os << ", \"reactions\": ";
+        write_json_strings(os, file_metadata.reactions);
+        os << "}";
+    }
+    os << ((metadata.empty()) ? "]\n" : "\n]\n");
+    return os.str();
+}
+
 }  // namespace readmpo
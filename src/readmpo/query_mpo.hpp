@@ -2,9 +2,10 @@
 #ifndef READMPO_QUERY_MPO_HPP_
 #define READMPO_QUERY_MPO_HPP_
 
-#include <map>     // std::map
-#include <string>  // std::string
-#include <vector>  // std::vector
+#include <cstdint>  // std::uint64_t
+#include <map>      // std::map
+#include <string>   // std::string
+#include <vector>   // std::vector
 
 namespace readmpo {
 
@@ -14,6 +15,48 @@ namespace readmpo {
  */
 std::map<std::string, std::vector<std::string>> query_mpo(const std::string & mpofile_name);
 
+/** @brief Metadata of an MPO file.*/
+struct MpoMetadata {
+    /** @brief Name of the MPO file.*/
+    std::string fname;
+    /** @brief Status of the query: ``ok``, ``missing geometry``, ``missing energy mesh``, ``missing output`` (both
+     *  are present but no output is computed for the pair), or the message of the error raised while reading the file.
+     */
+    std::string status;
+    /** @brief Names of geometries.*/
+    std::vector<std::string> geometries;
+    /** @brief Names of energy meshes.*/
+    std::vector<std::string> energy_meshes;
+    /** @brief Number of zones of each geometry (only the requested one if any).*/
+    std::map<std::string, std::uint64_t> n_zones;
+    /** @brief Number of groups of each energy mesh (only the requested one if any).*/
+    std::map<std::string, std::uint64_t> n_groups;
+    /** @brief Number of values of each lowercased parameter.*/
+    std::map<std::string, std::uint64_t> n_values;
+    /** @brief Isotopes (of the output of the requested geometry and energy mesh if both are given).*/
+    std::vector<std::string> isotopes;
+    /** @brief Reactions (of the output of the requested geometry and energy mesh if both are given).*/
+    std::vector<std::string> reactions;
+};
+
+/** @brief Read metadata of many MPO files concurrently.
+ *  @details Only the small datasets describing geometries, energy meshes, parameters, isotopes and reactions are
+ *  read, cross sections and state points are never opened. The reading of a file stops as soon as the requested
+ *  geometry or energy mesh is found missing. Errors raised while reading a file are reported in its status instead of
+ *  being thrown.
+ *  @param mpofile_list List of MPO file names.
+ *  @param geometry Name of the geometry each file must contain (empty means no requirement).
+ *  @param energy_mesh Name of the energy mesh each file must contain (empty means no requirement).
+ *  @param n_threads Number of threads reading files concurrently (``0`` means all available threads).
+ *  @return Metadata of each file, in the order of the list.
+ */
+std::vector<MpoMetadata> query_mpo_metadata(const std::vector<std::string> & mpofile_list,
+                                            const std::string & geometry = "", const std::string & energy_mesh = "",
+                                            std::uint64_t n_threads = 0);
+
+/** @brief Get JSON representation of the metadata of MPO files, as an array with one object per file.*/
+std::string metadata_json(const std::vector<MpoMetadata> & metadata);
+
 }  // namespace readmpo
 
 #endif  // READMPO_QUERY_MPO_HPP_
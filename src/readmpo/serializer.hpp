@@ -2,19 +2,51 @@
 #ifndef READMPO_SERIALIZER_HPP_
 #define READMPO_SERIALIZER_HPP_
 
-#include <cstdint>        // std::uint32_t
+#include <cstdint>        // std::uint32_t, std::uint64_t
 #include <istream>        // std::istream
 #include <map>            // std::map
 #include <ostream>        // std::ostream
 #include <string>         // std::string
 #include <tuple>          // std::tuple
-#include <type_traits>    // std::is_trivially_copyable
+#include <type_traits>    // std::bool_constant, std::is_trivially_copyable
 #include <unordered_set>  // std::unordered_set
 #include <utility>        // std::pair
 #include <vector>         // std::vector
 
 namespace readmpo {
 
+// Bytes
+// -----
+
+/** @brief Size of the chunks by which strings and vectors are allocated during the deserialization (in bytes).
+ *  @details A corrupted size fails at the end of the data instead of allocating the whole size at once.
+ */
+inline constexpr std::uint64_t serializer_chunk_size = 1 << 20;
+
+/** @brief Check if a vector of objects can be serialized as a single block of bytes.
+ *  @details Trivially copyable objects, and pairs of them without padding, have the same bytes in memory as when they
+ *  are serialized one by one.
+ */
+template <class T>
+struct is_bulk_serializable : std::is_trivially_copyable<T> {};
+
+/** @brief Check if a vector of pairs can be serialized as a single block of bytes.*/
+template <class F, class S>
+struct is_bulk_serializable<std::pair<F, S>> :
+std::bool_constant<is_bulk_serializable<F>::value && is_bulk_serializable<S>::value &&
+                   (sizeof(std::pair<F, S>) == sizeof(F) + sizeof(S))> {};
+
+/** @brief Write bytes to the buffer of an output stream.
+ *  @details Bytes are put to the stream buffer without constructing a sentry for each object. The stream is marked
+ *  as bad if not all bytes are written.
+ */
+void write_bytes(std::ostream & os, const void * data, std::uint64_t n_bytes);
+
+/** @brief Read bytes from the buffer of an input stream.
+ *  @details An exception is thrown if the stream ends before all bytes are read.
+ */
+void read_bytes(std::istream & is, void * data, std::uint64_t n_bytes);
+
 // Serialize
 // ---------
 
@@ -34,7 +66,9 @@ void serialize_obj(std::ostream & os, const std::tuple<Args...> & obj);
 template <>
 void serialize_obj(std::ostream & os, const std::string & obj);
 
-/** @brief Serialize a vector.*/
+/** @brief Serialize a vector.
+ *  @details Elements are written as a single block if they are bulk serializable (see readmpo::is_bulk_serializable).
+ */
 template <class T>
 void serialize_obj(std::ostream & os, const std::vector<T> & obj);
 
@@ -65,7 +99,9 @@ void deserialize_obj(std::istream & is, std::tuple<Args...> & obj);
 template <>
 void deserialize_obj(std::istream & is, std::string & obj);
 
-/** @brief Deserialize a vector.*/
+/** @brief Deserialize a vector.
+ *  @details Elements are read as a single block if they are bulk serializable (see readmpo::is_bulk_serializable).
+ */
 template <class T>
 void deserialize_obj(std::istream & is, std::vector<T> & obj);
 
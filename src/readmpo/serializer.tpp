@@ -2,13 +2,34 @@
 #ifndef READMPO_SERIALIZER_TPP_
 #define READMPO_SERIALIZER_TPP_
 
+#include <algorithm>  // std::max, std::min
+#include <ios>        // std::ios_base, std::streamsize
+#include <stdexcept>  // std::runtime_error
+
 namespace readmpo {
 
+// Write bytes to the buffer of an output stream
+inline void write_bytes(std::ostream & os, const void * data, std::uint64_t n_bytes) {
+    std::streamsize n_written = os.rdbuf()->sputn(static_cast<const char *>(data), n_bytes);
+    if (n_written != static_cast<std::streamsize>(n_bytes)) {
+        os.setstate(std::ios_base::badbit);
+    }
+}
+
+// Read bytes from the buffer of an input stream
+inline void read_bytes(std::istream & is, void * data, std::uint64_t n_bytes) {
+    std::streamsize n_read = is.rdbuf()->sgetn(static_cast<char *>(data), n_bytes);
+    if (n_read != static_cast<std::streamsize>(n_bytes)) {
+        is.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+        throw std::runtime_error("Unexpected end of serialized data.\n");
+    }
+}
+
 // Serialize a class to an output stream
 template <class T>
 requires std::is_trivially_copyable<T>::value
 void serialize_obj(std::ostream & os, const T & obj) {
-    os.write(reinterpret_cast<const char *>(&obj), sizeof(T));
+    write_bytes(os, &obj, sizeof(T));
 }
 
 // Serialize a pair
@@ -26,19 +47,23 @@ void serialize_obj(std::ostream & os, const std::tuple<Args...> & obj) {
 
 // Serialize a string
 template <>
-void serialize_obj(std::ostream & os, const std::string & obj) {
+inline void serialize_obj(std::ostream & os, const std::string & obj) {
     std::uint32_t size = obj.size();
-    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
-    os.write(obj.c_str(), size);
+    write_bytes(os, &size, sizeof(std::uint32_t));
+    write_bytes(os, obj.data(), size);
 }
 
 // Serialize a vector
 template <class T>
 void serialize_obj(std::ostream & os, const std::vector<T> & obj) {
     std::uint32_t size = obj.size();
-    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
-    for (const T & element : obj) {
-        serialize_obj(os, element);
+    write_bytes(os, &size, sizeof(std::uint32_t));
+    if constexpr (is_bulk_serializable<T>::value && !std::is_same<T, bool>::value) {
+        write_bytes(os, obj.data(), size * sizeof(T));
+    } else {
+        for (const T & element : obj) {
+            serialize_obj(os, element);
+        }
     }
 }
 
@@ -46,7 +71,7 @@ void serialize_obj(std::ostream & os, const std::vector<T> & obj) {
 template <class T>
 void serialize_obj(std::ostream & os, const std::unordered_set<T> & obj) {
     std::uint32_t size = obj.size();
-    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    write_bytes(os, &size, sizeof(std::uint32_t));
     for (const T & element : obj) {
         serialize_obj(os, element);
     }
@@ -56,7 +81,7 @@ void serialize_obj(std::ostream & os, const std::unordered_set<T> & obj) {
 template <class K, class T>
 void serialize_obj(std::ostream & os, const std::map<K, T> & obj) {
     std::uint32_t size = obj.size();
-    os.write(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    write_bytes(os, &size, sizeof(std::uint32_t));
     for (const auto & [key, value] : obj) {
         serialize_obj(os, key);
         serialize_obj(os, value);
@@ -67,7 +92,7 @@ void serialize_obj(std::ostream & os, const std::map<K, T> & obj) {
 template <class T>
 requires std::is_trivially_copyable<T>::value
 void deserialize_obj(std::istream & is, T & obj) {
-    is.read(reinterpret_cast<char *>(&obj), sizeof(T));
+    read_bytes(is, &obj, sizeof(T));
 }
 
 // Deserialize a pair
@@ -85,21 +110,35 @@ void deserialize_obj(std::istream & is, std::tuple<Args...> & obj) {
 
 // Deserialize a string
 template <>
-void deserialize_obj(std::istream & is, std::string & obj) {
+inline void deserialize_obj(std::istream & is, std::string & obj) {
     std::uint32_t size;
-    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
-    obj.resize(size);
-    is.read(&(obj[0]), size);
+    read_bytes(is, &size, sizeof(std::uint32_t));
+    obj.clear();
+    for (std::uint64_t begin = 0; begin < size; begin += serializer_chunk_size) {
+        std::uint64_t n_bytes = std::min<std::uint64_t>(serializer_chunk_size, size - begin);
+        obj.resize(begin + n_bytes);
+        read_bytes(is, obj.data() + begin, n_bytes);
+    }
 }
 
 // Deserialize a vector
 template <class T>
 void deserialize_obj(std::istream & is, std::vector<T> & obj) {
     std::uint32_t size;
-    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
-    obj.resize(size);
-    for (T & element : obj) {
-        deserialize_obj(is, element);
+    read_bytes(is, &size, sizeof(std::uint32_t));
+    obj.clear();
+    if constexpr (is_bulk_serializable<T>::value && !std::is_same<T, bool>::value) {
+        constexpr std::uint64_t chunk_size = std::max<std::uint64_t>(serializer_chunk_size / sizeof(T), 1);
+        for (std::uint64_t begin = 0; begin < size; begin += chunk_size) {
+            std::uint64_t n_elements = std::min<std::uint64_t>(chunk_size, size - begin);
+            obj.resize(begin + n_elements);
+            read_bytes(is, obj.data() + begin, n_elements * sizeof(T));
+        }
+    } else {
+        for (std::uint32_t i_elem = 0; i_elem < size; i_elem++) {
+            obj.emplace_back();
+            deserialize_obj(is, obj.back());
+        }
     }
 }
 
@@ -107,7 +146,8 @@ void deserialize_obj(std::istream & is, std::vector<T> & obj) {
 template <class T>
 void deserialize_obj(std::istream & is, std::unordered_set<T> & obj) {
     std::uint32_t size;
-    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    read_bytes(is, &size, sizeof(std::uint32_t));
+    obj.reserve(obj.size() + std::min<std::uint64_t>(size, serializer_chunk_size / sizeof(T)));
     for (std::uint32_t i_elem = 0; i_elem < size; i_elem++) {
         T element;
         deserialize_obj(is, element);
@@ -119,7 +159,7 @@ void deserialize_obj(std::istream & is, std::unordered_set<T> & obj) {
 template <class K, class T>
 void deserialize_obj(std::istream & is, std::map<K, T> & obj) {
     std::uint32_t size;
-    is.read(reinterpret_cast<char *>(&size), sizeof(std::uint32_t));
+    read_bytes(is, &size, sizeof(std::uint32_t));
     for (std::uint32_t i_elem = 0; i_elem < size; i_elem++) {
         std::pair<K, T> element;
         deserialize_obj(is, element.first);
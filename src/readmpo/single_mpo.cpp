@@ -1,43 +1,256 @@
 // Copyright 2023 quocdang1998
 #include "readmpo/single_mpo.hpp"
 
-#include <algorithm>  // std::find, std::max
+#include <algorithm>  // std::copy, std::find, std::max, std::min
 #include <iostream>   // std::clog
 #include <sstream>    // std::ostringstream
-#include <stdexcept>  // std::invalid_argument
+#include <stdexcept>  // std::invalid_argument, std::runtime_error
+#include <tuple>      // std::tie
 
+#include <omp.h>  // ::omp_get_thread_num
 
-#include "readmpo/h5_utils.hpp"  // readmpo::check_string_in_array, readmpo::get_dset, readmpo::ndim_to_c_idx,
-                                 // readmpo::stringify, readmpo::lowercase, readmpo::trim, readmpo::is_near,
-                                 // readmpo::ls_groups
+#include "readmpo/h5_pool.hpp"     // readmpo::H5Pool
+#include "readmpo/h5_utils.hpp"    // readmpo::check_string_in_array, readmpo::get_dset, readmpo::ndim_to_c_idx,
+                                   // readmpo::stringify, readmpo::lowercase, readmpo::trim, readmpo::find_near,
+                                   // readmpo::ls_groups, readmpo::lock_h5, readmpo::parallel_for,
+                                   // readmpo::group_conflicts, readmpo::read_dset, readmpo::read_dset_ranges,
+                                   // readmpo::merge_ranges, readmpo::get_n_threads
+#include "readmpo/serializer.hpp"  // readmpo::serialize_obj, readmpo::deserialize_obj
+#include "readmpo/xs_kernel.hpp"   // readmpo::OverwritePolicy, readmpo::XsKernel, readmpo::select_xs_kernel
 
 namespace readmpo {
 
-// Get cross section from type
+// Write cross sections of consecutive groups to an output with a kernel selected for the type of cross section
 static void get_xs(std::uint64_t ngroups, std::vector<std::uint64_t> & output_index, std::int64_t address_xs,
-                   NdArray & output_data, XsType type, const std::vector<float> & cross_sections,
-                   const std::vector<float> & zoneflux, double iso_conc) {
-    for (std::uint64_t i_group = 0; i_group < ngroups; i_group++) {
-        output_index[0] = i_group;
-        if (output_data[output_index] != 0.0) {
-            std::clog << "Overwrite at index " << output_index << "\n";
-        }
-        switch (type) {
-            case XsType::Micro : {
-                output_data[output_index] = cross_sections[address_xs + i_group];
-                break;
-            }
-            case XsType::Macro : {
-                output_data[output_index] = iso_conc * cross_sections[address_xs + i_group];
-                break;
+                   NdArray & output_data, XsKernel kernel, const std::vector<float> & cross_sections,
+                   const std::vector<float> & zoneflux, double iso_conc, std::uint64_t output_offset = 0) {
+    output_index[0] = output_offset;
+    std::uint64_t n_overwritten = kernel(ngroups, cross_sections.data(), address_xs, zoneflux.data(), iso_conc,
+                                         &(output_data[output_index]), output_data.strides()[0] / sizeof(double));
+    if (n_overwritten != 0) {
+        std::clog << "Overwrite of " << n_overwritten << " element(s) at index " << output_index << "\n";
+    }
+}
+
+// Buffers reused by a worker to read datasets of each zone
+struct ZoneBuffers {
+    std::vector<float> concentrations;
+    std::vector<float> zoneflux;
+    std::vector<float> cross_sections;
+    std::vector<std::uint64_t> shape;
+    std::string path;
+};
+
+// Set path of a dataset of a zone in a buffer
+static const char * zone_dset_path(std::string & path, const std::string & statept_name, std::uint64_t i_zone,
+                                   const char * dset_name) {
+    path.assign(statept_name);
+    path.append("/zone_");
+    path.append(std::to_string(i_zone));
+    path.push_back('/');
+    path.append(dset_name);
+    return path.c_str();
+}
+
+// Kind of reaction, deciding how its cross sections are laid out in CROSSECTION and in the output
+enum class ReactionKind {
+    Diffusion,
+    Scattering,
+    Other
+};
+
+// Get kind of a reaction from its name
+static ReactionKind get_reaction_kind(const std::string & reaction) {
+    if (reaction.compare("Diffusion") == 0) {
+        return ReactionKind::Diffusion;
+    } else if (reaction.compare("Scattering") == 0) {
+        return ReactionKind::Scattering;
+    }
+    return ReactionKind::Other;
+}
+
+// Update valid set with max anisotropy orders and TRANSPROFILE of an isotope in a zone
+static void update_valid_set(ValidSet & valid_set, int diffusion_max_order, int scattering_max_order,
+                             const int * trans_fag, const int * trans_adr, std::uint64_t n_groups) {
+    std::get<0>(valid_set) = std::max(diffusion_max_order, static_cast<int>(std::get<0>(valid_set)));
+    std::get<1>(valid_set) = std::max(scattering_max_order, static_cast<int>(std::get<1>(valid_set)));
+    // loop for each departure group and arrival group inside the band
+    for (std::uint64_t departure_gridx = 0; departure_gridx < n_groups; departure_gridx++) {
+        int first_arrival = std::max(trans_fag[departure_gridx], 0);
+        int last_arrival = trans_fag[departure_gridx] + trans_adr[departure_gridx + 1] - trans_adr[departure_gridx];
+        last_arrival = std::min(last_arrival, static_cast<int>(n_groups));
+        for (int arrival_gridx = first_arrival; arrival_gridx < last_arrival; arrival_gridx++) {
+            std::get<2>(valid_set).insert(std::make_pair(departure_gridx, arrival_gridx));
+        }
+    }
+}
+
+// Constructor from the valid set of an isotope
+ScatteringBand::ScatteringBand(const ValidSet & valid_set, std::uint64_t n_groups) :
+first_arrival_(n_groups, UINT64_MAX), offset_(n_groups + 1, 0) {
+    // get first and last arrival group of each departure group
+    std::vector<std::uint64_t> last_arrival(n_groups, 0);
+    for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(valid_set)) {
+        this->first_arrival_[p.first] = std::min(this->first_arrival_[p.first], p.second);
+        last_arrival[p.first] = std::max(last_arrival[p.first], p.second + 1);
+    }
+    // calculate offset of the band of each departure group
+    for (std::uint64_t departure = 0; departure < n_groups; departure++) {
+        if (this->first_arrival_[departure] == UINT64_MAX) {
+            this->first_arrival_[departure] = 0;
+        }
+        std::uint64_t band_width = last_arrival[departure] - this->first_arrival_[departure];
+        this->offset_[departure + 1] = this->offset_[departure] + band_width;
+    }
+}
+
+// Constructor from a profile array
+ScatteringBand::ScatteringBand(const NdArray & profile) {
+    if ((profile.ndim() != 1) || (profile.size() % 2 == 0)) {
+        throw std::invalid_argument("Expected a 1D profile array of odd size.\n");
+    }
+    std::uint64_t n_groups = profile.size() / 2;
+    this->first_arrival_.resize(n_groups);
+    this->offset_.resize(n_groups + 1);
+    for (std::uint64_t i = 0; i < n_groups; i++) {
+        this->first_arrival_[i] = profile[i];
+    }
+    for (std::uint64_t i = 0; i <= n_groups; i++) {
+        this->offset_[i] = profile[n_groups + i];
+    }
+}
+
+// Check if a transfer group pair is inside the band
+bool ScatteringBand::contains(std::uint64_t departure, std::uint64_t arrival) const noexcept {
+    if (departure >= this->n_groups() || arrival < this->first_arrival_[departure]) {
+        return false;
+    }
+    return arrival - this->first_arrival_[departure] < this->offset_[departure + 1] - this->offset_[departure];
+}
+
+// Get an element of a block-sparse Scattering array
+double ScatteringBand::get(const NdArray & band_array, std::uint64_t departure, std::uint64_t arrival,
+                           const std::vector<std::uint64_t> & index) const {
+    if (index.size() + 1 != band_array.ndim()) {
+        throw std::invalid_argument("Expected index of all dimensions except the first one.\n");
+    }
+    if (!this->contains(departure, arrival)) {
+        return 0.0;
+    }
+    std::vector<std::uint64_t> band_index(band_array.ndim());
+    band_index[0] = this->index(departure, arrival);
+    std::copy(index.begin(), index.end(), band_index.begin() + 1);
+    return band_array[band_index];
+}
+
+// Expand a block-sparse Scattering array to the array of a transfer group pair
+NdArray ScatteringBand::expand(const NdArray & band_array, std::uint64_t departure, std::uint64_t arrival) const {
+    std::vector<std::uint64_t> shape(band_array.shape());
+    shape[0] = 1;
+    NdArray result(shape);
+    if (!this->contains(departure, arrival)) {
+        return result;
+    }
+    std::uint64_t offset = this->index(departure, arrival) * result.size();
+    for (std::uint64_t i = 0; i < result.size(); i++) {
+        result[i] = band_array[offset + i];
+    }
+    return result;
+}
+
+// Get profile array
+NdArray ScatteringBand::profile(void) const {
+    std::uint64_t n_groups = this->n_groups();
+    NdArray result({2 * n_groups + 1});
+    for (std::uint64_t i = 0; i < n_groups; i++) {
+        result[i] = this->first_arrival_[i];
+    }
+    for (std::uint64_t i = 0; i <= n_groups; i++) {
+        result[n_groups + i] = this->offset_[i];
+    }
+    return result;
+}
+
+// Constructor from the shape of the output and the max anisotropy order to retrieve
+DiscoveryLib::DiscoveryLib(const std::vector<std::uint64_t> & shape, std::uint64_t max_anisop_order) :
+shape_(shape), max_anisop_order_(max_anisop_order) {
+    std::uint64_t n_outputs = max_anisop_order * (1 + shape[0] * shape[0]);
+    this->outputs_.resize(n_outputs);
+    this->allocated_ = std::unique_ptr<std::once_flag[]>(new std::once_flag[n_outputs]);
+}
+
+// Get output at a given index, allocate it at the first call
+NdArray & DiscoveryLib::get_output(std::uint64_t index, const std::vector<std::uint64_t> & shape) {
+    std::call_once(this->allocated_[index], [&]() {
+        std::uint64_t size = 1;
+        for (const std::uint64_t & s : shape) {
+            size *= s;
+        }
+        this->outputs_[index] = NdArray(allocate_arena(size), 0, shape);
+    });
+    return this->outputs_[index];
+}
+
+// Get output of Diffusion at an anisotropy order
+NdArray & DiscoveryLib::diffusion(std::uint64_t anisop) { return this->get_output(anisop, this->shape_); }
+
+// Get output of Scattering at an anisotropy order from a departure group to an arrival group
+NdArray & DiscoveryLib::scattering(std::uint64_t anisop, std::uint64_t departure, std::uint64_t arrival) {
+    std::uint64_t n_groups = this->shape_[0];
+    std::uint64_t index = this->max_anisop_order_ + (anisop * n_groups + departure) * n_groups + arrival;
+    std::vector<std::uint64_t> scattering_shape(this->shape_);
+    scattering_shape[0] = 1;
+    return this->get_output(index, scattering_shape);
+}
+
+// Merge the valid set of the isotope in a zone
+void DiscoveryLib::merge(const ValidSet & zone_valid_set) {
+    std::lock_guard<std::mutex> guard(this->mutex_);
+    std::get<0>(this->valid_set_) = std::max(std::get<0>(this->valid_set_), std::get<0>(zone_valid_set));
+    std::get<1>(this->valid_set_) = std::max(std::get<1>(this->valid_set_), std::get<1>(zone_valid_set));
+    std::get<2>(this->valid_set_).insert(std::get<2>(zone_valid_set).begin(), std::get<2>(zone_valid_set).end());
+}
+
+// Insert outputs of a reaction to the library
+void DiscoveryLib::finalize(std::uint32_t isotope_id, const std::string & reaction, FlatLib & flat_lib,
+                            bool expand_scattering) {
+    std::uint32_t reaction_id = flat_lib.reaction_id(reaction);
+    if (reaction.compare("Diffusion") == 0) {
+        std::uint64_t max_anisop = std::min(std::get<0>(this->valid_set_), this->max_anisop_order_);
+        for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+            LibKey key = {isotope_id, reaction_id, static_cast<std::uint32_t>(anisop), 0, 0};
+            flat_lib.insert(key, this->diffusion(anisop));
+        }
+    } else if (reaction.compare("Scattering") == 0 && !expand_scattering) {
+        // gather outputs of each transfer group pair into the band
+        ScatteringBand band(this->valid_set_, this->shape_[0]);
+        std::vector<std::uint64_t> band_shape(this->shape_);
+        band_shape[0] = band.size();
+        std::uint64_t max_anisop = std::min(std::get<1>(this->valid_set_), this->max_anisop_order_);
+        for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+            std::uint64_t size = band.size();
+            for (std::uint64_t i_dim = 1; i_dim < band_shape.size(); i_dim++) {
+                size *= band_shape[i_dim];
             }
-            case XsType::Flux : {
-                output_data[output_index] = zoneflux[i_group];
-                break;
+            NdArray band_array(allocate_arena(size), 0, band_shape);
+            for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(this->valid_set_)) {
+                const NdArray & pair_array = this->scattering(anisop, p.first, p.second);
+                std::uint64_t offset = band.index(p.first, p.second) * pair_array.size();
+                for (std::uint64_t i = 0; i < pair_array.size(); i++) {
+                    band_array[offset + i] = pair_array[i];
+                }
             }
-            case XsType::ReactRate : {
-                output_data[output_index] = zoneflux[i_group] * iso_conc * cross_sections[address_xs + i_group];
-                break;
+            LibKey key = {isotope_id, reaction_id, static_cast<std::uint32_t>(anisop), LibKey::band, LibKey::band};
+            flat_lib.insert(key, band_array);
+        }
+        flat_lib.insert({isotope_id, flat_lib.reaction_id("ScatteringProfile"), 0, 0, 0}, band.profile());
+    } else if (reaction.compare("Scattering") == 0) {
+        std::uint64_t max_anisop = std::min(std::get<1>(this->valid_set_), this->max_anisop_order_);
+        for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+            for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(this->valid_set_)) {
+                LibKey key = {isotope_id, reaction_id, static_cast<std::uint32_t>(anisop),
+                              static_cast<std::uint32_t>(p.first), static_cast<std::uint32_t>(p.second)};
+                flat_lib.insert(key, this->scattering(anisop, p.first, p.second));
             }
         }
     }
@@ -50,9 +263,12 @@ std::ostream & operator<<(std::ostream & os, const ValidSet & v) {
 
 // Constructor from list of MPO file names, name of homogenized geometry and name of energy mesh
 SingleMpo::SingleMpo(const std::string & mpofile_name, const std::string & geometry, const std::string & energy_mesh) {
+    IoScope io_scope(this->io_counters_.get());
     // get file pointer
     this->fname_ = mpofile_name;
-    this->file_ = new H5::H5File(mpofile_name.c_str(), H5F_ACC_RDONLY);
+    this->fingerprint_ = get_fingerprint(mpofile_name);
+    this->handle_ = H5Pool::get_instance().acquire(mpofile_name);
+    this->file_ = &(this->handle_->file);
     // get geometry ID and number of zones
     auto [geometry_names, n_geometry] = get_dset<std::string>(this->file_, "geometry/GEOMETRY_NAME");
     std::uint64_t geom_id = check_string_in_array(geometry, geometry_names);
@@ -78,7 +294,7 @@ SingleMpo::SingleMpo(const std::string & mpofile_name, const std::string & geome
     }
     // open output
     this->output_name_ = stringify("output/output_", output_id);
-    this->output_ = new H5::Group(this->file_->openGroup(this->output_name_.c_str()));
+    this->output_ = H5Pool::get_instance().open_group(*(this->handle_), this->output_name_);
     // get map of isotope name to its index
     auto [isotope_names, n_isotopes] = get_dset<std::string>(this->file_, "contents/isotopes/ISOTOPENAME");
     auto [addriso, n_addrz] = get_dset<int>(this->output_, "info/ADDRISO");
@@ -101,6 +317,7 @@ SingleMpo::SingleMpo(const std::string & mpofile_name, const std::string & geome
 
 // Get state parameters
 std::map<std::string, std::vector<double>> SingleMpo::get_state_params(void) {
+    IoScope io_scope(this->io_counters_.get());
     // initialize result
     std::map<std::string, std::vector<double>> state_params;
     // get name of parameters
@@ -117,6 +334,7 @@ std::map<std::string, std::vector<double>> SingleMpo::get_state_params(void) {
 
 // Get parameter names
 std::vector<std::string> SingleMpo::get_param_names(void) {
+    IoScope io_scope(this->io_counters_.get());
     auto [param_names, n_params] = get_dset<std::string>(this->file_, "parameters/info/PARAMNAME");
     for (std::string & param_name : param_names) {
         param_name = lowercase(trim(param_name));
@@ -146,6 +364,7 @@ std::vector<std::string> SingleMpo::get_reactions(void) {
 
 // Construct map from local index to global index
 void SingleMpo::construct_global_idx_map(const std::map<std::string, std::vector<double>> & master_pspace) {
+    IoScope io_scope(this->io_counters_.get());
     // get name of parameters
     auto [param_names, n_params] = get_dset<std::string>(this->file_, "parameters/info/PARAMNAME");
     this->map_global_idx_.resize(n_params[0]);
@@ -157,12 +376,15 @@ void SingleMpo::construct_global_idx_map(const std::map<std::string, std::vector
         std::string param_id = stringify("parameters/values/PARAM_", i_param);
         auto [param_values, n_values] = get_dset<float>(this->file_, param_id.c_str());
         // initialize memory
+        const std::vector<double> & global_values = master_pspace.at(param_name);
         this->map_global_idx_[i_param].resize(n_values[0]);
         for (std::uint64_t i_value = 0; i_value < n_values[0]; i_value++) {
-            double value = param_values[i_value];
-            auto it = std::find_if(master_pspace.at(param_name).begin(), master_pspace.at(param_name).end(),
-                                   [&value](const double & x) { return is_near(x, value); });
-            this->map_global_idx_[i_param][i_value] = it - master_pspace.at(param_name).begin();
+            std::uint64_t global_idx = find_near(global_values, param_values[i_value]);
+            if (global_idx == global_values.size()) {
+                throw std::runtime_error(stringify("Value ", param_values[i_value], " of parameter ", param_name,
+                                                   " not found in the master parameter space.\n"));
+            }
+            this->map_global_idx_[i_param][i_value] = global_idx;
         }
     }
     // get map from local idim to global idim
@@ -181,8 +403,137 @@ void SingleMpo::construct_global_idx_map(const std::map<std::string, std::vector
     }
 }
 
+// Update map from local index to global index after the master parameter space is changed
+void SingleMpo::remap_global_idx(const std::vector<std::vector<std::uint64_t>> & new_global_idx) {
+    for (std::uint64_t i_param = 0; i_param < this->map_global_idx_.size(); i_param++) {
+        const std::vector<std::uint64_t> & dim_global_idx = new_global_idx[this->map_global_idim_[i_param]];
+        for (std::uint64_t & global_idx : this->map_global_idx_[i_param]) {
+            global_idx = dim_global_idx[global_idx];
+        }
+    }
+}
+
+// Get index of each state point in the output array, excluding group and zone dimensions
+std::vector<std::vector<std::uint64_t>> SingleMpo::get_output_idx(
+    const std::vector<std::uint64_t> & global_skipped_dims) {
+    IoScope io_scope(this->io_counters_.get());
+    this->index_statepts();
+    std::vector<std::vector<std::uint64_t>> output_idx;
+    output_idx.reserve(this->index_.param_idx.size());
+    for (const std::vector<int> & local_idx : this->index_.param_idx) {
+        output_idx.push_back(this->local_to_output_idx(local_idx, global_skipped_dims));
+    }
+    return output_idx;
+}
+
+// Load a structural index
+bool SingleMpo::load_index(MpoIndex && index) {
+    if (!index.is_valid_for(this->fname_) || (index.zone_addr.size() != index.statepts.size() * this->n_zones)) {
+        return false;
+    }
+    this->index_ = std::move(index);
+    return true;
+}
+
+// Write metadata to an output stream
+void SingleMpo::serialize(std::ostream & os) const {
+    serialize_obj(os, this->fname_);
+    serialize_obj(os, this->output_name_);
+    serialize_obj(os, this->n_zones);
+    serialize_obj(os, this->n_groups);
+    serialize_obj(os, this->fingerprint_);
+    serialize_obj(os, this->map_global_idx_);
+    serialize_obj(os, this->map_global_idim_);
+    serialize_obj(os, this->map_local_idim_);
+    serialize_obj(os, this->map_isotopes_);
+    serialize_obj(os, this->map_reactions_);
+}
+
+// Read metadata from an input stream without opening the file
+void SingleMpo::deserialize(std::istream & is) {
+    if (this->handle_ != nullptr) {
+        this->close();
+    }
+    deserialize_obj(is, this->fname_);
+    deserialize_obj(is, this->output_name_);
+    deserialize_obj(is, this->n_zones);
+    deserialize_obj(is, this->n_groups);
+    deserialize_obj(is, this->fingerprint_);
+    deserialize_obj(is, this->map_global_idx_);
+    deserialize_obj(is, this->map_global_idim_);
+    deserialize_obj(is, this->map_local_idim_);
+    deserialize_obj(is, this->map_isotopes_);
+    deserialize_obj(is, this->map_reactions_);
+    this->index_ = MpoIndex();
+}
+
+// Check if the file has not been modified since it was opened by the constructor
+bool SingleMpo::is_up_to_date(void) const { return get_fingerprint(this->fname_) == this->fingerprint_; }
+
+// Index state points of the output if not yet indexed
+void SingleMpo::index_statepts(void) {
+    if (this->index_.built()) {
+        return;
+    }
+    MpoIndex index;
+    std::tie(index.file_size, index.file_mtime) = get_fingerprint(this->fname_);
+    auto h5_lock = lock_h5();
+    index.statepts = ls_groups(this->output_, "statept_");
+    index.param_idx.reserve(index.statepts.size());
+    for (const std::string & statept_name : index.statepts) {
+        std::string param_address = stringify(statept_name, "/PARAMVALUEORD");
+        index.param_idx.push_back(std::move(get_dset<int>(this->output_, param_address.c_str()).first));
+    }
+    index.zone_addr.resize(index.statepts.size() * this->n_zones, std::make_pair(-1, -1));
+    this->index_ = std::move(index);
+}
+
+// Get ADDRZX and ADDRZI of a zone of a state point, read from the file if not yet indexed
+std::pair<int, int> SingleMpo::get_zone_addr(std::uint64_t i_statept, std::uint64_t i_zone) {
+    std::pair<int, int> & zone_addr = this->index_.zone_addr[i_statept * this->n_zones + i_zone];
+    if (zone_addr.first < 0) {
+        auto h5_lock = lock_h5();
+        std::string zone_name = stringify(this->index_.statepts[i_statept], "/zone_", i_zone);
+        int addrzx = get_dset<int>(this->output_, stringify(zone_name, "/ADDRZX").c_str()).first[0];
+        int addrzi = get_dset<int>(this->output_, stringify(zone_name, "/ADDRZI").c_str()).first[0];
+        zone_addr = std::make_pair(addrzx, addrzi);
+    }
+    return zone_addr;
+}
+
+// Get local index of each isotope in each zone type
+std::vector<std::vector<std::int64_t>> SingleMpo::isotope_table(const std::vector<std::string> & isotopes) const {
+    std::vector<std::vector<std::int64_t>> table(this->map_isotopes_.size(),
+                                                 std::vector<std::int64_t>(isotopes.size(), -1));
+    for (std::uint64_t addrzi = 0; addrzi < this->map_isotopes_.size(); addrzi++) {
+        const std::map<std::string, std::uint64_t> & map_iso_zone = this->map_isotopes_[addrzi];
+        for (std::uint64_t i_iso = 0; i_iso < isotopes.size(); i_iso++) {
+            auto it = map_iso_zone.find(isotopes[i_iso]);
+            table[addrzi][i_iso] = (it != map_iso_zone.end()) ? static_cast<std::int64_t>(it->second) : -1;
+        }
+    }
+    return table;
+}
+
+// Get index of a state point in the output array from its local index in each dimension
+std::vector<std::uint64_t> SingleMpo::local_to_output_idx(const std::vector<int> & local_idx,
+                                                          const std::vector<std::uint64_t> & global_skipped_dims) {
+    std::vector<std::uint64_t> output_idx;
+    for (std::uint64_t idim_global = 0; idim_global < local_idx.size(); idim_global++) {
+        if (std::find(global_skipped_dims.begin(), global_skipped_dims.end(), idim_global) !=
+            global_skipped_dims.end()) {
+            continue;
+        }
+        std::uint64_t idim_local = this->map_local_idim_[idim_global];
+        std::uint64_t index_local = local_idx[idim_local];
+        output_idx.push_back(this->map_global_idx_[idim_local][index_local]);
+    }
+    return output_idx;
+}
+
 // Get valid parameter set for Diffusion and Scattering reactions
 void SingleMpo::get_valid_set(std::map<std::string, ValidSet> & global_valid_set, std::ofstream & logfile) {
+    IoScope io_scope(this->io_counters_.get());
     logfile << "Reading " << this->fname_ << ":";
     logfile.flush();
     // get addrxs and transprofile
@@ -192,214 +543,484 @@ void SingleMpo::get_valid_set(std::map<std::string, ValidSet> & global_valid_set
     std::vector<std::uint64_t> ndiffusion_idx = {0, 0, this->map_reactions_.size()};
     std::vector<std::uint64_t> ntransfer_idx = {0, 0, this->map_reactions_.size() + 1};
     std::vector<std::uint64_t> scaterring_adrr_idx = {0, 0, this->map_reactions_.size() + 2};
-    // loop over each statept
-    std::vector<std::string> statepts = ls_groups(this->output_, "statept_");
-    for (std::string & statept_name : statepts) {
-        // get statept
-        logfile << " " << statept_name;
+    // collect distinct addresses of zones over all statepts
+    this->index_statepts();
+    std::set<std::pair<int, int>> zone_addrs;
+    for (std::uint64_t i_statept = 0; i_statept < this->index_.statepts.size(); i_statept++) {
+        logfile << " " << this->index_.statepts[i_statept];
         logfile.flush();
-        H5::Group statept = this->output_->openGroup(statept_name.c_str());
-        // loop over each zone
         for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
-            // open zone
-            std::string zone_name = stringify("zone_", i_zone);
-            H5::Group zone = statept.openGroup(zone_name.c_str());
-            // get addrzx
-            auto [addrzx_data, _naddrzx] = get_dset<int>(&zone, "ADDRZX");
-            std::uint64_t addrzx = addrzx_data[0];
-            // set zone index for each index vector
-            ndiffusion_idx[0] = addrzx;
-            ntransfer_idx[0] = addrzx;
-            scaterring_adrr_idx[0] = addrzx;
-            // loop on each isotope
-            auto [addrzi_data, _naddrzi] = get_dset<int>(&zone, "ADDRZI");
-            std::uint64_t addrzi = addrzi_data[0];
-            std::map<std::string, std::uint64_t> & map_iso_zone = this->map_isotopes_[addrzi];
-            for (auto & [isotope, valid_set] : global_valid_set) {
-                // set isotope index
-                if (!map_iso_zone.contains(isotope)) {
-                    continue;
-                }
-                std::uint64_t isotope_idx = map_iso_zone[isotope];
-                ndiffusion_idx[1] = isotope_idx;
-                ntransfer_idx[1] = isotope_idx;
-                scaterring_adrr_idx[1] = isotope_idx;
-                // get max anisotropy order for Diffusion and Scattering
-                int diffusion_max_order = addrxs[ndim_to_c_idx(ndiffusion_idx, addrxs_shape)];
-                int scattering_max_order = addrxs[ndim_to_c_idx(ntransfer_idx, addrxs_shape)];
-                if (diffusion_max_order < 0 && scattering_max_order < 0) {
-                    continue;  // skip because the isotope do not present in this zone
+            zone_addrs.insert(this->get_zone_addr(i_statept, i_zone));
+        }
+    }
+    // loop over each distinct zone
+    for (const auto & [addrzx, addrzi] : zone_addrs) {
+        // set zone index for each index vector
+        ndiffusion_idx[0] = addrzx;
+        ntransfer_idx[0] = addrzx;
+        scaterring_adrr_idx[0] = addrzx;
+        // loop on each isotope
+        std::map<std::string, std::uint64_t> & map_iso_zone = this->map_isotopes_[addrzi];
+        for (auto & [isotope, valid_set] : global_valid_set) {
+            // set isotope index
+            if (!map_iso_zone.contains(isotope)) {
+                continue;
+            }
+            std::uint64_t isotope_idx = map_iso_zone[isotope];
+            ndiffusion_idx[1] = isotope_idx;
+            ntransfer_idx[1] = isotope_idx;
+            scaterring_adrr_idx[1] = isotope_idx;
+            // get max anisotropy order for Diffusion and Scattering
+            int diffusion_max_order = addrxs[ndim_to_c_idx(ndiffusion_idx, addrxs_shape)];
+            int scattering_max_order = addrxs[ndim_to_c_idx(ntransfer_idx, addrxs_shape)];
+            if (diffusion_max_order < 0 && scattering_max_order < 0) {
+                continue;  // skip because the isotope do not present in this zone
+            }
+            // get first arrival group and adr per arrival group start from TRANSPROFILE
+            std::uint64_t index_in_tf = addrxs[ndim_to_c_idx(scaterring_adrr_idx, addrxs_shape)];
+            const int * trans_fag = transprofile.data() + index_in_tf;
+            const int * trans_adr = transprofile.data() + index_in_tf + this->n_groups;
+            update_valid_set(valid_set, diffusion_max_order, scattering_max_order, trans_fag, trans_adr,
+                             this->n_groups);
+        }
+    }
+    logfile << "\n";
+    logfile.flush();
+}
+
+// Tables of a request in an MPO file, with isotopes and reactions translated to dense indices once, so that the loop
+// over zones only indexes arrays
+struct RequestPlan {
+    // request and its outputs
+    const XsTarget * target = nullptr;
+    // index of each state point in the output, excluding group and zone dimensions
+    std::vector<std::vector<std::uint64_t>> statepts_idx;
+    // local index of each isotope in each zone type
+    std::vector<std::vector<std::int64_t>> zone_isotopes;
+    // column of each reaction in ADDRXS and its kind
+    std::vector<std::uint64_t> reaction_columns;
+    std::vector<ReactionKind> reaction_kinds;
+    // valid set, band structure of block-sparse Scattering outputs and discovered outputs of each isotope
+    std::vector<const ValidSet *> iso_valid_sets;
+    std::vector<std::vector<std::pair<std::uint64_t, std::uint64_t>>> iso_pairs;
+    std::vector<ScatteringBand> iso_bands;
+    std::vector<DiscoveryLib *> iso_discoveries;
+    // kernel writing cross sections, warning if several state points write to the same index of the output
+    XsKernel kernel = nullptr;
+};
+
+// Output arrays of each isotope and reaction of a request
+using OutputSlots = std::vector<std::vector<std::vector<NdArray *>>>;
+
+// Resolve output arrays of each isotope and reaction of a request in a library: one array for reactions other than
+// Diffusion and Scattering, one per anisotropy order for Diffusion and block-sparse Scattering, and one per anisotropy
+// order and transfer group pair (in the order of iso_pairs) for expanded Scattering (Diffusion and Scattering of
+// discovered isotopes are written to the discovery library instead)
+static OutputSlots resolve_slots(const RequestPlan & plan, MpoLib & lib) {
+    const XsRequest & request = *(plan.target->request);
+    OutputSlots slots(request.isotopes.size(), std::vector<std::vector<NdArray *>>(request.reactions.size()));
+    for (std::uint64_t i_iso = 0; i_iso < request.isotopes.size(); i_iso++) {
+        std::map<std::string, NdArray> & iso_lib = lib.at(request.isotopes[i_iso]);
+        for (std::uint64_t i_reac = 0; i_reac < request.reactions.size(); i_reac++) {
+            const std::string & reaction = request.reactions[i_reac];
+            std::vector<NdArray *> & reac_slots = slots[i_iso][i_reac];
+            if (plan.reaction_kinds[i_reac] != ReactionKind::Other && plan.iso_discoveries[i_iso] != nullptr) {
+                continue;
+            } else if (plan.reaction_kinds[i_reac] == ReactionKind::Diffusion) {
+                std::uint64_t max_anisop = std::min(std::get<0>(*plan.iso_valid_sets[i_iso]), request.max_anisop_order);
+                for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+                    reac_slots.push_back(&(iso_lib.at(stringify(reaction, anisop))));
                 }
-                std::get<0>(valid_set) = std::max(diffusion_max_order, static_cast<int>(std::get<0>(valid_set)));
-                std::get<1>(valid_set) = std::max(scattering_max_order, static_cast<int>(std::get<1>(valid_set)));
-                // get first arrival group and adr per arrival group start from TRANSPROFILE
-                std::uint64_t index_in_tf = addrxs[ndim_to_c_idx(scaterring_adrr_idx, addrxs_shape)];
-                std::vector<int> trans_fag(transprofile.data() + index_in_tf,
-                                           transprofile.data() + index_in_tf + this->n_groups);
-                std::vector<int> trans_adr(transprofile.data() + index_in_tf + this->n_groups,
-                                           transprofile.data() + index_in_tf + 2 * this->n_groups + 1);
-                // loop for each departure group and arrival group
-                for (std::uint64_t departure_gridx = 0; departure_gridx < this->n_groups; departure_gridx++) {
-                    for (std::uint64_t arrival_gridx = 0; arrival_gridx < this->n_groups; arrival_gridx++) {
-                        int scale = trans_adr[departure_gridx] + static_cast<int>(arrival_gridx) -
-                                    trans_fag[departure_gridx];
-                        if ((trans_adr[departure_gridx] <= scale) && (scale < trans_adr[departure_gridx + 1])) {
-                            std::get<2>(valid_set).insert(std::make_pair(departure_gridx, arrival_gridx));
-                        }
+            } else if (plan.reaction_kinds[i_reac] == ReactionKind::Scattering) {
+                std::uint64_t max_anisop = std::min(std::get<1>(*plan.iso_valid_sets[i_iso]), request.max_anisop_order);
+                for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+                    if (!request.expand_scattering) {
+                        reac_slots.push_back(&(iso_lib.at(stringify(reaction, anisop))));
+                        continue;
+                    }
+                    for (const std::pair<std::uint64_t, std::uint64_t> & p : plan.iso_pairs[i_iso]) {
+                        reac_slots.push_back(&(iso_lib.at(stringify(reaction, anisop, '_', p.first, '-', p.second))));
                     }
                 }
+            } else {
+                reac_slots.push_back(&(iso_lib.at(reaction)));
             }
         }
     }
-    logfile << "\n";
-    logfile.flush();
+    return slots;
 }
 
 // Retrieve microscopic homogenized cross section of an isotope and a reaction from MPO
 void SingleMpo::get_microlib(const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
                              const std::vector<std::uint64_t> & global_skipped_dims,
                              const std::map<std::string, ValidSet> & global_valid_set,
-                             std::map<std::string, std::map<std::string, NdArray>> & micro_lib, XsType type,
-                             std::uint64_t max_anisop_order, std::ofstream & logfile) {
+                             std::map<std::string, std::map<std::string, NdArray>> & micro_lib,
+                             std::map<std::string, DiscoveryLib> & discovery_lib, XsType type,
+                             std::uint64_t max_anisop_order, std::ostream & logfile, std::uint64_t n_threads,
+                             bool expand_scattering, StreamLib * stream) {
+    XsRequest request;
+    request.isotopes = isotopes;
+    request.reactions = reactions;
+    request.type = type;
+    request.max_anisop_order = max_anisop_order;
+    request.expand_scattering = expand_scattering;
+    std::vector<XsTarget> targets(1);
+    targets[0].request = &request;
+    targets[0].global_skipped_dims = global_skipped_dims;
+    targets[0].micro_lib = &micro_lib;
+    targets[0].discovery_lib = &discovery_lib;
+    this->get_microlib_batch(targets, global_valid_set, logfile, n_threads, stream);
+}
+
+// Retrieve cross sections of several requests in a single pass over the state points and zones
+void SingleMpo::get_microlib_batch(const std::vector<XsTarget> & targets,
+                                   const std::map<std::string, ValidSet> & global_valid_set, std::ostream & logfile,
+                                   std::uint64_t n_threads, StreamLib * stream) {
+    if ((stream != nullptr) && (targets.size() != 1)) {
+        throw std::invalid_argument("Streamed output is only supported for a single request.\n");
+    }
+    IoScope io_scope(this->io_counters_.get());
     logfile << "Rettrieving " << this->fname_ << ":";
     logfile.flush();
-    // check for isotope and reaction
+    // check for isotope and reaction of each request
     std::set<std::string> mpo_isotopes = this->get_isotopes();
-    for (const std::string & isotope : isotopes) {
-        for (const std::string & reaction : reactions) {
-            // check if isotope and reaction is in MPO file
-            if (mpo_isotopes.find(isotope) == mpo_isotopes.end()) {
-                std::clog << "This MPO does not contain the isotope " << isotope << ". No isotope will be retrived\n";
-                return;
-            }
-            if (!this->map_reactions_.contains(reaction)) {
-                std::clog << "This MPO does not contain the reaction " << reaction << ". \n";
-                return;
+    auto is_in_mpo = [&](const XsRequest & request) {
+        for (const std::string & isotope : request.isotopes) {
+            for (const std::string & reaction : request.reactions) {
+                // check if isotope and reaction is in MPO file
+                if (mpo_isotopes.find(isotope) == mpo_isotopes.end()) {
+                    std::clog << "This MPO does not contain the isotope " << isotope
+                              << ". No isotope will be retrived\n";
+                    return false;
+                }
+                if (!this->map_reactions_.contains(reaction)) {
+                    std::clog << "This MPO does not contain the reaction " << reaction << ". \n";
+                    return false;
+                }
             }
         }
+        return true;
+    };
+    std::vector<RequestPlan> plans;
+    for (const XsTarget & target : targets) {
+        if (is_in_mpo(*(target.request))) {
+            plans.emplace_back().target = &target;
+        }
+    }
+    if (plans.empty()) {
+        return;
     }
     // get addrxs (address of cross section) and transprofile
+    auto h5_lock = lock_h5();
     auto [addrxs, addrxs_shape] = get_dset<int>(this->output_, "info/ADDRXS");
     auto [transprofile, transprf_shape] = get_dset<int>(this->output_, "info/TRANSPROFILE");
-    // initialize memory for index
-    std::vector<std::uint64_t> output_index(this->map_global_idx_.size() - global_skipped_dims.size() + 2);
-    std::vector<std::uint64_t> cross_section_idx = {0, 0, 0};
-    std::vector<std::uint64_t> ndiffusion_idx = {0, 0, this->map_reactions_.size()};
-    std::vector<std::uint64_t> ntransfer_idx = {0, 0, this->map_reactions_.size() + 1};
-    std::vector<std::uint64_t> scaterring_adrr_idx = {0, 0, this->map_reactions_.size() + 2};
-    // loop on each statepoint
-    std::vector<std::string> statepts = ls_groups(this->output_, "statept_");
-    for (std::string & statept_name : statepts) {
-        // get statept
-        logfile << " " << statept_name;
-        logfile.flush();
-        H5::Group statept = this->output_->openGroup(statept_name.c_str());
-        // get global index inside the output array
-        auto [local_idx, total_ndim] = get_dset<int>(&statept, "PARAMVALUEORD");
-        for (std::uint64_t idim_global = 0, write_idim = 2; idim_global < total_ndim[0]; idim_global++) {
-            if (std::find(global_skipped_dims.begin(), global_skipped_dims.end(), idim_global) !=
-                global_skipped_dims.end()) {
+    for (RequestPlan & plan : plans) {
+        plan.statepts_idx = this->get_output_idx(plan.target->global_skipped_dims);
+    }
+    const std::vector<std::string> & statepts = this->index_.statepts;
+    h5_lock.unlock();
+    // group state points writing to the same index of the output of any request (index of the request is appended,
+    // so that positions of different requests never coincide)
+    std::vector<std::vector<std::vector<std::uint64_t>>> statepts_positions(statepts.size());
+    for (std::uint64_t i_statept = 0; i_statept < statepts.size(); i_statept++) {
+        for (std::uint64_t i_plan = 0; i_plan < plans.size(); i_plan++) {
+            std::vector<std::uint64_t> position = plans[i_plan].statepts_idx[i_statept];
+            position.push_back(i_plan);
+            statepts_positions[i_statept].push_back(std::move(position));
+        }
+    }
+    std::vector<std::vector<std::uint64_t>> statept_groups = group_conflicts(statepts_positions);
+    // translate isotopes and reactions of each request to dense indices
+    std::uint64_t n_columns = addrxs_shape[2], n_local_isotopes = addrxs_shape[1];
+    std::uint64_t ndiffusion_column = this->map_reactions_.size(), ntransfer_column = ndiffusion_column + 1;
+    std::uint64_t transprofile_column = ndiffusion_column + 2;
+    // datasets to read in each zone
+    bool need_concentration = false, need_zoneflux = false, need_cross_sections = false;
+    for (RequestPlan & plan : plans) {
+        const XsRequest & request = *(plan.target->request);
+        const std::vector<std::string> & isotopes = request.isotopes;
+        const std::vector<std::string> & reactions = request.reactions;
+        plan.zone_isotopes = this->isotope_table(isotopes);
+        plan.reaction_columns.resize(reactions.size());
+        plan.reaction_kinds.resize(reactions.size());
+        for (std::uint64_t i_reac = 0; i_reac < reactions.size(); i_reac++) {
+            plan.reaction_columns[i_reac] = this->map_reactions_.at(reactions[i_reac]);
+            plan.reaction_kinds[i_reac] = get_reaction_kind(reactions[i_reac]);
+        }
+        plan.iso_valid_sets.assign(isotopes.size(), nullptr);
+        plan.iso_pairs.resize(isotopes.size());
+        plan.iso_bands.resize(isotopes.size());
+        plan.iso_discoveries.assign(isotopes.size(), nullptr);
+        std::map<std::string, DiscoveryLib> & discovery_lib = *(plan.target->discovery_lib);
+        for (std::uint64_t i_iso = 0; i_iso < isotopes.size(); i_iso++) {
+            auto it_discovery = discovery_lib.find(isotopes[i_iso]);
+            if (it_discovery != discovery_lib.end()) {
+                plan.iso_discoveries[i_iso] = &(it_discovery->second);
                 continue;
             }
-            std::uint64_t idim_local = this->map_local_idim_[idim_global];
-            std::uint64_t index_local = local_idx[idim_local];
-            std::uint64_t index_global = this->map_global_idx_[idim_local][index_local];
-            output_index[write_idim] = index_global;
-            write_idim++;
+            plan.iso_valid_sets[i_iso] = &(global_valid_set.at(isotopes[i_iso]));
+            const std::unordered_set<std::pair<std::uint64_t, std::uint64_t>> & pairs =
+                std::get<2>(*plan.iso_valid_sets[i_iso]);
+            plan.iso_pairs[i_iso].assign(pairs.begin(), pairs.end());
+            if (!request.expand_scattering) {
+                plan.iso_bands[i_iso] = ScatteringBand(*plan.iso_valid_sets[i_iso], this->n_groups);
+            }
         }
-        // loop over each zone
-        for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
-            // open zone
-            output_index[1] = i_zone;
-            std::string zone_name = stringify("zone_", i_zone);
-            H5::Group zone = statept.openGroup(zone_name.c_str());
-            // get concentration, flux, addrzx and cross sections of all isotopes and reactions
-            auto [concentrations, _n_concs] = get_dset<float>(&zone, "CONCENTRATION");
-            auto [zoneflux, _ng] = get_dset<float>(&zone, "ZONEFLUX");
-            auto [addrzx_data, _naddrzx] = get_dset<int>(&zone, "ADDRZX");
-            auto [cross_sections, cross_section_shape] = get_dset<float>(&zone, "CROSSECTION");
-            // set zone index
-            std::uint64_t addrzx = addrzx_data[0];
-            cross_section_idx[0] = addrzx;
-            ndiffusion_idx[0] = addrzx;
-            ntransfer_idx[0] = addrzx;
-            scaterring_adrr_idx[0] = addrzx;
-            auto [addrzi_data, _naddrzi] = get_dset<int>(&zone, "ADDRZI");
-            std::uint64_t addrzi = addrzi_data[0];
-            // retrive for each isotope
-            for (const std::string & isotope : isotopes) {
-                // check if isotope present
-                if (!this->map_isotopes_[addrzi].contains(isotope)) {
+        plan.kernel = select_xs_kernel(request.type, OverwritePolicy::Warn);
+        need_concentration |= (request.type == XsType::Macro) || (request.type == XsType::ReactRate);
+        need_zoneflux |= (request.type == XsType::Flux) || (request.type == XsType::ReactRate);
+        need_cross_sections |= (request.type != XsType::Flux);
+    }
+    // get ranges of CROSSECTION to read for a pair of addrzx and addrzi (union of the ranges of each request)
+    auto get_xs_ranges = [&](std::uint64_t addrzx, std::uint64_t addrzi) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;
+        for (const RequestPlan & plan : plans) {
+            const XsRequest & request = *(plan.target->request);
+            if (request.type == XsType::Flux) {
+                continue;
+            }
+            for (std::uint64_t i_iso = 0; i_iso < request.isotopes.size(); i_iso++) {
+                std::int64_t isotope_idx = plan.zone_isotopes[addrzi][i_iso];
+                if (isotope_idx < 0) {
                     continue;
                 }
-                // set isotope index
-                std::uint64_t isotope_idx = this->map_isotopes_[addrzi][isotope];
-                cross_section_idx[1] = isotope_idx;
-                ndiffusion_idx[1] = isotope_idx;
-                ntransfer_idx[1] = isotope_idx;
-                scaterring_adrr_idx[1] = isotope_idx;
-                // get isotope concentration
-                double iso_conc = concentrations[isotope_idx];
-                // get first arrival group and adr per arrival group start from TRANSPROFILE
-                std::uint64_t index_in_tf = addrxs[ndim_to_c_idx(scaterring_adrr_idx, addrxs_shape)];
-                std::vector<int> trans_fag(transprofile.data() + index_in_tf,
-                                           transprofile.data() + index_in_tf + this->n_groups);
-                std::vector<int> trans_adr(transprofile.data() + index_in_tf + this->n_groups,
-                                           transprofile.data() + index_in_tf + 2 * this->n_groups + 1);
-                // get valid set
-                const ValidSet & valid_set = global_valid_set.at(isotope);
-                // retrive for each reaction
-                for (const std::string & reaction : reactions) {
-                    // set reaction index
-                    std::uint64_t reaction_idx = this->map_reactions_[reaction];
-                    cross_section_idx[2] = reaction_idx;
-                    // calculate index in the cross section array
-                    std::int64_t address_xs = addrxs[ndim_to_c_idx(cross_section_idx, addrxs_shape)];
+                const int * addrxs_row = addrxs.data() + (addrzx * n_local_isotopes + isotope_idx) * n_columns;
+                const int * trans_fag = transprofile.data() + addrxs_row[transprofile_column];
+                const int * trans_adr = trans_fag + this->n_groups;
+                // get valid set of the isotope (valid set of the zone if it is being discovered)
+                ValidSet zone_valid_set;
+                bool is_discovered = (plan.iso_discoveries[i_iso] != nullptr);
+                if (is_discovered) {
+                    int diffusion_max_order = addrxs_row[ndiffusion_column];
+                    int scattering_max_order = addrxs_row[ntransfer_column];
+                    if (diffusion_max_order >= 0 || scattering_max_order >= 0) {
+                        update_valid_set(zone_valid_set, diffusion_max_order, scattering_max_order, trans_fag,
+                                         trans_adr, this->n_groups);
+                    }
+                }
+                const ValidSet & valid_set = (is_discovered) ? zone_valid_set : *(plan.iso_valid_sets[i_iso]);
+                // add range of each reaction
+                for (std::uint64_t i_reac = 0; i_reac < request.reactions.size(); i_reac++) {
+                    std::int64_t address_xs = addrxs_row[plan.reaction_columns[i_reac]];
                     if (address_xs < 0) {
-                        // std::clog << "Cross section not found for isotope " << isotope << " reaction " << reaction
-                        //         << " state point " << statept_name << " in zone " << i_zone << "\n";
                         continue;
                     }
-                    // get cross section
-                    if (reaction.compare("Diffusion") == 0) {
-                        // get cross section for Diffusion
-                        std::uint64_t max_anisop = std::min(std::get<0>(valid_set), max_anisop_order);
-                        for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
-                            NdArray & output_data = micro_lib[isotope][stringify(reaction, anisop)];
-                            std::int64_t adr_xs = address_xs + anisop * this->n_groups;
-                            get_xs(this->n_groups, output_index, adr_xs, output_data, type, cross_sections, zoneflux,
-                                   iso_conc);
-                        }
-                    } else if (reaction.compare("Scattering") == 0) {
-                        // get cross section for Scattering
-                        std::uint64_t max_anisop = std::min(std::get<1>(valid_set), max_anisop_order);
+                    if (plan.reaction_kinds[i_reac] == ReactionKind::Diffusion) {
+                        std::uint64_t max_anisop = std::min(std::get<0>(valid_set), request.max_anisop_order);
+                        ranges.push_back(std::make_pair(address_xs, address_xs + max_anisop * this->n_groups));
+                    } else if (plan.reaction_kinds[i_reac] == ReactionKind::Scattering) {
+                        std::uint64_t max_anisop = std::min(std::get<1>(valid_set), request.max_anisop_order);
                         for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
                             for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(valid_set)) {
-                                NdArray & output_data =
-                                    micro_lib[isotope][stringify(reaction, anisop, '_', p.first, '-', p.second)];
                                 int scale = trans_adr[p.first] + static_cast<int>(p.second) - trans_fag[p.first];
                                 std::int64_t adr_xs = address_xs + anisop * this->n_groups + scale;
-                                get_xs(1, output_index, adr_xs, output_data, type, cross_sections,
-                                       zoneflux, iso_conc);
+                                if (adr_xs >= 0) {
+                                    ranges.push_back(std::make_pair(adr_xs, adr_xs + 1));
+                                }
                             }
                         }
                     } else {
-                        // get cross section for others reaction
-                        NdArray & output_data = micro_lib[isotope][reaction];
-                        get_xs(this->n_groups, output_index, address_xs, output_data, type, cross_sections, zoneflux,
-                               iso_conc);
+                        ranges.push_back(std::make_pair(address_xs, address_xs + this->n_groups));
                     }
                 }
             }
         }
+        return merge_ranges(std::move(ranges));
+    };
+    std::map<std::pair<std::uint64_t, std::uint64_t>, std::vector<std::pair<std::uint64_t, std::uint64_t>>> xs_ranges;
+    // write cross sections of a request in a zone whose datasets are read into the buffers
+    auto write_zone = [&](const RequestPlan & plan, const OutputSlots & slots,
+                          std::vector<std::uint64_t> & output_index, std::uint64_t addrzx, std::uint64_t addrzi,
+                          const ZoneBuffers & buffers, ValidSet & zone_valid_set) {
+        const XsRequest & request = *(plan.target->request);
+        const std::vector<float> & concentrations = buffers.concentrations;
+        const std::vector<float> & zoneflux = buffers.zoneflux;
+        const std::vector<float> & cross_sections = buffers.cross_sections;
+        bool use_concentration = (request.type == XsType::Macro) || (request.type == XsType::ReactRate);
+        const std::vector<std::int64_t> & zone_isotope_idx = plan.zone_isotopes[addrzi];
+        // retrive for each isotope
+        for (std::uint64_t i_iso = 0; i_iso < request.isotopes.size(); i_iso++) {
+            // check if isotope present
+            std::int64_t isotope_idx = zone_isotope_idx[i_iso];
+            if (isotope_idx < 0) {
+                continue;
+            }
+            // get isotope concentration
+            double iso_conc = (use_concentration) ? concentrations[isotope_idx] : 0.0;
+            // get first arrival group and adr per arrival group start from TRANSPROFILE
+            const int * addrxs_row = addrxs.data() + (addrzx * n_local_isotopes + isotope_idx) * n_columns;
+            const int * trans_fag = transprofile.data() + addrxs_row[transprofile_column];
+            const int * trans_adr = trans_fag + this->n_groups;
+            // get valid set and output of the isotope (valid set of the zone if it is being discovered)
+            DiscoveryLib * iso_discovery = plan.iso_discoveries[i_iso];
+            if (iso_discovery != nullptr) {
+                std::get<0>(zone_valid_set) = 0;
+                std::get<1>(zone_valid_set) = 0;
+                std::get<2>(zone_valid_set).clear();
+                int diffusion_max_order = addrxs_row[ndiffusion_column];
+                int scattering_max_order = addrxs_row[ntransfer_column];
+                if (diffusion_max_order >= 0 || scattering_max_order >= 0) {
+                    update_valid_set(zone_valid_set, diffusion_max_order, scattering_max_order, trans_fag, trans_adr,
+                                     this->n_groups);
+                    iso_discovery->merge(zone_valid_set);
+                }
+            }
+            const ValidSet & valid_set = (iso_discovery != nullptr) ? zone_valid_set : *(plan.iso_valid_sets[i_iso]);
+            const std::vector<std::vector<NdArray *>> & iso_slots = slots[i_iso];
+            // retrive for each reaction
+            for (std::uint64_t i_reac = 0; i_reac < request.reactions.size(); i_reac++) {
+                // calculate index in the cross section array
+                std::int64_t address_xs = addrxs_row[plan.reaction_columns[i_reac]];
+                if (address_xs < 0) {
+                    continue;
+                }
+                // get cross section
+                if (plan.reaction_kinds[i_reac] == ReactionKind::Diffusion) {
+                    // get cross section for Diffusion
+                    std::uint64_t max_anisop = std::min(std::get<0>(valid_set), request.max_anisop_order);
+                    for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+                        NdArray & output_data = (iso_discovery != nullptr) ? iso_discovery->diffusion(anisop)
+                                                                           : *(iso_slots[i_reac][anisop]);
+                        std::int64_t adr_xs = address_xs + anisop * this->n_groups;
+                        get_xs(this->n_groups, output_index, adr_xs, output_data, plan.kernel, cross_sections,
+                               zoneflux, iso_conc);
+                    }
+                } else if (plan.reaction_kinds[i_reac] == ReactionKind::Scattering) {
+                    // get cross section for Scattering
+                    std::uint64_t max_anisop = std::min(std::get<1>(valid_set), request.max_anisop_order);
+                    for (std::uint64_t anisop = 0; anisop < max_anisop; anisop++) {
+                        std::int64_t anisop_address_xs = address_xs + anisop * this->n_groups;
+                        if (iso_discovery != nullptr) {
+                            for (const std::pair<std::uint64_t, std::uint64_t> & p : std::get<2>(valid_set)) {
+                                NdArray & output_data = iso_discovery->scattering(anisop, p.first, p.second);
+                                int scale = trans_adr[p.first] + static_cast<int>(p.second) - trans_fag[p.first];
+                                get_xs(1, output_index, anisop_address_xs + scale, output_data, plan.kernel,
+                                       cross_sections, zoneflux, iso_conc);
+                            }
+                            continue;
+                        }
+                        const std::vector<std::pair<std::uint64_t, std::uint64_t>> & pairs = plan.iso_pairs[i_iso];
+                        for (std::uint64_t i_pair = 0; i_pair < pairs.size(); i_pair++) {
+                            const std::pair<std::uint64_t, std::uint64_t> & p = pairs[i_pair];
+                            NdArray * output_data = iso_slots[i_reac][anisop];
+                            std::uint64_t output_offset = 0;
+                            if (request.expand_scattering) {
+                                output_data = iso_slots[i_reac][anisop * pairs.size() + i_pair];
+                            } else {
+                                output_offset = plan.iso_bands[i_iso].index(p.first, p.second);
+                            }
+                            int scale = trans_adr[p.first] + static_cast<int>(p.second) - trans_fag[p.first];
+                            get_xs(1, output_index, anisop_address_xs + scale, *output_data, plan.kernel,
+                                   cross_sections, zoneflux, iso_conc, output_offset);
+                        }
+                    }
+                } else {
+                    // get cross section for others reaction
+                    get_xs(this->n_groups, output_index, address_xs, *(iso_slots[i_reac][0]), plan.kernel,
+                           cross_sections, zoneflux, iso_conc);
+                }
+            }
+        }
+    };
+    // loop on each group of statepoint in parallel
+    std::vector<ZoneBuffers> worker_buffers(get_n_threads(n_threads));
+    std::vector<MpoLib> worker_stages((stream != nullptr) ? get_n_threads(n_threads) : 0);
+    std::vector<OutputSlots> worker_slots((stream != nullptr) ? get_n_threads(n_threads) : 0);
+    std::vector<OutputSlots> lib_slots(plans.size());
+    if (stream == nullptr) {
+        for (std::uint64_t i_plan = 0; i_plan < plans.size(); i_plan++) {
+            lib_slots[i_plan] = resolve_slots(plans[i_plan], *(plans[i_plan].target->micro_lib));
+        }
     }
+    parallel_for(statept_groups.size(), n_threads, [&](std::uint64_t i_group) {
+        ZoneBuffers & buffers = worker_buffers[::omp_get_thread_num()];
+        ValidSet zone_valid_set;
+        // write to the library of each request, or to a staging library of a single state point if the output is
+        // streamed
+        MpoLib * stage = nullptr;
+        if (stream != nullptr) {
+            stage = &(worker_stages[::omp_get_thread_num()]);
+            if (stage->empty()) {
+                *stage = stream->staging();
+                worker_slots[::omp_get_thread_num()] = resolve_slots(plans[0], *stage);
+            }
+        }
+        // initialize memory for index of each request
+        std::vector<std::vector<std::uint64_t>> output_indices(plans.size());
+        for (std::uint64_t i_plan = 0; i_plan < plans.size(); i_plan++) {
+            const std::vector<std::uint64_t> & skipped_dims = plans[i_plan].target->global_skipped_dims;
+            output_indices[i_plan].resize(this->map_global_idx_.size() - skipped_dims.size() + 2);
+        }
+        // loop on each statepoint of the group
+        for (std::uint64_t i_statept : statept_groups[i_group]) {
+            // get global index inside the output array
+            const std::string & statept_name = statepts[i_statept];
+            #pragma omp critical (readmpo_statept_log)
+            {
+                logfile << " " << statept_name;
+                logfile.flush();
+            }
+            if (stream != nullptr) {
+                stream->load(*stage, plans[0].statepts_idx[i_statept]);
+            } else {
+                for (std::uint64_t i_plan = 0; i_plan < plans.size(); i_plan++) {
+                    const std::vector<std::uint64_t> & statept_idx = plans[i_plan].statepts_idx[i_statept];
+                    std::copy(statept_idx.begin(), statept_idx.end(), output_indices[i_plan].begin() + 2);
+                }
+            }
+            // loop over each zone
+            for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
+                // get concentration, flux, addrzx and cross sections of all isotopes and reactions of all requests
+                auto [addrzx, addrzi] = this->get_zone_addr(i_statept, i_zone);
+                {
+                    auto h5_zone_lock = lock_h5();
+                    if (need_concentration) {
+                        read_dset(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "CONCENTRATION"),
+                                  buffers.concentrations, buffers.shape);
+                    }
+                    if (need_zoneflux) {
+                        read_dset(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "ZONEFLUX"),
+                                  buffers.zoneflux, buffers.shape);
+                    }
+                }
+                if (need_cross_sections) {
+                    // read only the ranges of requested isotopes and reactions
+                    const std::vector<std::pair<std::uint64_t, std::uint64_t>> * zone_xs_ranges;
+                    #pragma omp critical (readmpo_xs_ranges)
+                    {
+                        std::pair<std::uint64_t, std::uint64_t> zone_key(addrzx, addrzi);
+                        auto it = xs_ranges.find(zone_key);
+                        if (it == xs_ranges.end()) {
+                            it = xs_ranges.emplace(zone_key, get_xs_ranges(addrzx, addrzi)).first;
+                        }
+                        zone_xs_ranges = &(it->second);
+                    }
+                    auto h5_zone_lock = lock_h5();
+                    read_dset_ranges(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "CROSSECTION"),
+                                     *zone_xs_ranges, buffers.cross_sections);
+                }
+                // retrive for each request
+                for (std::uint64_t i_plan = 0; i_plan < plans.size(); i_plan++) {
+                    output_indices[i_plan][1] = i_zone;
+                    const OutputSlots & slots = (stream != nullptr) ? worker_slots[::omp_get_thread_num()]
+                                                                    : lib_slots[i_plan];
+                    write_zone(plans[i_plan], slots, output_indices[i_plan], addrzx, addrzi, buffers,
+                               zone_valid_set);
+                }
+            }
+            if (stream != nullptr) {
+                stream->store(*stage, plans[0].statepts_idx[i_statept]);
+            }
+        }
+    });
     logfile << "\n";
     logfile.flush();
 }
 
 // Retrieve concentration from MPO
 void SingleMpo::get_concentration(const std::vector<std::string> & isotopes, std::uint64_t burnup_i_dim,
-                                  std::map<std::string, NdArray> & output) {
+                                  std::map<std::string, NdArray> & output, std::uint64_t n_threads) {
+    IoScope io_scope(this->io_counters_.get());
     // check if isotope is in MPO file
     std::set<std::string> mpo_isotopes = this->get_isotopes();
     for (const std::string & isotope : isotopes) {
@@ -408,38 +1029,149 @@ void SingleMpo::get_concentration(const std::vector<std::string> & isotopes, std
             return;
         }
     }
-    // loop over each statept
-    std::vector<std::uint64_t> output_index(2);
-    std::vector<std::string> statepts = ls_groups(this->output_, "statept_");
-    for (std::string & statept_name : statepts) {
-        // get statept
-        H5::Group statept = this->output_->openGroup(statept_name.c_str());
-        // get global index inside the output array
-        auto [local_idx, total_ndim] = get_dset<int>(&statept, "PARAMVALUEORD");
-        std::uint64_t idim_local = this->map_local_idim_[burnup_i_dim];
-        std::uint64_t index_local = local_idx[idim_local];
-        std::uint64_t index_global = this->map_global_idx_[idim_local][index_local];
-        output_index[0] = index_global;
-        // loop over each zone
-        for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
-            // open zone
-            output_index[1] = i_zone;
-            std::string zone_name = stringify("zone_", i_zone);
-            H5::Group zone = statept.openGroup(zone_name.c_str());
-            auto [addrzi_data, _naddrzi] = get_dset<int>(&zone, "ADDRZI");
-            std::uint64_t addrzi = addrzi_data[0];
-            // get isotope concentration
-            auto [concentrations, _n_concs] = get_dset<float>(&zone, "CONCENTRATION");
-            for (const std::string & isotope : isotopes) {
-                std::map<std::string, std::uint64_t> & iso_map = this->map_isotopes_[addrzi];
-                if (!iso_map.contains(isotope)) {
-                    continue;
+    // group state points at the same burnup
+    std::vector<std::uint64_t> non_burnup_dims;
+    for (std::uint64_t i_dim = 0; i_dim < this->map_global_idx_.size(); i_dim++) {
+        if (i_dim != burnup_i_dim) {
+            non_burnup_dims.push_back(i_dim);
+        }
+    }
+    std::vector<std::vector<std::uint64_t>> statepts_idx = this->get_output_idx(non_burnup_dims);
+    const std::vector<std::string> & statepts = this->index_.statepts;
+    std::vector<std::vector<std::vector<std::uint64_t>>> statepts_positions(statepts.size());
+    for (std::uint64_t i_statept = 0; i_statept < statepts.size(); i_statept++) {
+        statepts_positions[i_statept].push_back(statepts_idx[i_statept]);
+    }
+    std::vector<std::vector<std::uint64_t>> statept_groups = group_conflicts(statepts_positions);
+    // loop over each group of statept in parallel
+    std::vector<ZoneBuffers> worker_buffers(get_n_threads(n_threads));
+    parallel_for(statept_groups.size(), n_threads, [&](std::uint64_t i_group) {
+        ZoneBuffers & buffers = worker_buffers[::omp_get_thread_num()];
+        std::vector<std::uint64_t> output_index(2);
+        for (std::uint64_t i_statept : statept_groups[i_group]) {
+            // get global index inside the output array
+            output_index[0] = statepts_idx[i_statept][0];
+            // loop over each zone
+            for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
+                // get isotope concentration
+                output_index[1] = i_zone;
+                std::uint64_t addrzi = this->get_zone_addr(i_statept, i_zone).second;
+                const std::vector<float> & concentrations = buffers.concentrations;
+                {
+                    auto h5_zone_lock = lock_h5();
+                    read_dset(this->output_, zone_dset_path(buffers.path, statepts[i_statept], i_zone, "CONCENTRATION"),
+                              buffers.concentrations, buffers.shape);
+                }
+                const std::map<std::string, std::uint64_t> & iso_map = this->map_isotopes_[addrzi];
+                for (const std::string & isotope : isotopes) {
+                    if (!iso_map.contains(isotope)) {
+                        continue;
+                    }
+                    std::uint64_t isotope_idx = iso_map.at(isotope);
+                    output.at(isotope)[output_index] = concentrations[isotope_idx];
                 }
-                std::uint64_t isotope_idx = iso_map[isotope];
-                output[isotope][output_index] = concentrations[isotope_idx];
             }
         }
+    });
+}
+
+// Retrieve cross section of an isotope and a reaction in each zone of a single state point
+NdArray SingleMpo::get_statept_xs(std::uint64_t i_statept, const std::string & isotope, const std::string & reaction,
+                                  XsType type, std::uint64_t anisop) {
+    IoScope io_scope(this->io_counters_.get());
+    auto h5_lock = lock_h5();
+    this->index_statepts();
+    if (i_statept >= this->index_.statepts.size()) {
+        throw std::invalid_argument(stringify("State point ", i_statept, " not found in MPO file ", this->fname_,
+                                              ".\n"));
+    }
+    // Scattering is written to a flat view of the result, indexed by departure and arrival group
+    bool is_diffusion = (reaction.compare("Diffusion") == 0), is_scattering = (reaction.compare("Scattering") == 0);
+    std::uint64_t n_rows = (is_scattering) ? this->n_groups * this->n_groups : this->n_groups;
+    std::shared_ptr<double[]> arena = allocate_arena(n_rows * this->n_zones);
+    NdArray flat_result(arena, 0, {n_rows, this->n_zones});
+    std::vector<std::uint64_t> shape = {this->n_groups, this->n_zones};
+    if (is_scattering) {
+        shape.insert(shape.begin(), this->n_groups);
+    }
+    auto it_reaction = this->map_reactions_.find(reaction);
+    if (it_reaction == this->map_reactions_.end()) {
+        return NdArray(arena, 0, shape);
     }
+    // get addrxs (address of cross section) and transprofile
+    auto [addrxs, addrxs_shape] = get_dset<int>(this->output_, "info/ADDRXS");
+    auto [transprofile, transprf_shape] = get_dset<int>(this->output_, "info/TRANSPROFILE");
+    std::uint64_t n_reactions = this->map_reactions_.size();
+    bool need_concentration = (type == XsType::Macro) || (type == XsType::ReactRate);
+    bool need_zoneflux = (type == XsType::Flux) || (type == XsType::ReactRate);
+    bool need_cross_sections = (type != XsType::Flux);
+    XsKernel kernel = select_xs_kernel(type, OverwritePolicy::Ignore);
+    // loop over each zone
+    const std::string & statept_name = this->index_.statepts[i_statept];
+    ZoneBuffers buffers;
+    std::vector<std::uint64_t> output_index(2);
+    for (std::uint64_t i_zone = 0; i_zone < this->n_zones; i_zone++) {
+        // get address of the cross section of the isotope in the zone
+        output_index[1] = i_zone;
+        auto [addrzx, addrzi] = this->get_zone_addr(i_statept, i_zone);
+        const std::map<std::string, std::uint64_t> & map_iso_zone = this->map_isotopes_[addrzi];
+        auto it_isotope = map_iso_zone.find(isotope);
+        if (it_isotope == map_iso_zone.end()) {
+            continue;
+        }
+        auto get_addrxs = [&](std::uint64_t i_column) {
+            std::vector<std::uint64_t> addrxs_idx = {static_cast<std::uint64_t>(addrzx), it_isotope->second, i_column};
+            return addrxs[ndim_to_c_idx(addrxs_idx, addrxs_shape)];
+        };
+        std::int64_t address_xs = get_addrxs(it_reaction->second);
+        if (address_xs < 0) {
+            continue;
+        }
+        if ((is_diffusion && static_cast<int>(anisop) >= get_addrxs(n_reactions)) ||
+            (is_scattering && static_cast<int>(anisop) >= get_addrxs(n_reactions + 1))) {
+            continue;
+        }
+        const int * trans_fag = transprofile.data() + get_addrxs(n_reactions + 2);
+        const int * trans_adr = trans_fag + this->n_groups;
+        if (is_diffusion || is_scattering) {
+            address_xs += anisop * this->n_groups;
+        }
+        // read datasets of the zone, only the elements of the reaction inside CROSSECTION
+        if (need_concentration) {
+            read_dset(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "CONCENTRATION"),
+                      buffers.concentrations, buffers.shape);
+        }
+        if (need_zoneflux) {
+            read_dset(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "ZONEFLUX"), buffers.zoneflux,
+                      buffers.shape);
+        }
+        if (need_cross_sections) {
+            std::pair<std::uint64_t, std::uint64_t> range(address_xs, address_xs + this->n_groups);
+            if (is_scattering) {
+                range = std::make_pair(address_xs + trans_adr[0], address_xs + trans_adr[this->n_groups]);
+            }
+            read_dset_ranges(this->output_, zone_dset_path(buffers.path, statept_name, i_zone, "CROSSECTION"),
+                             {range}, buffers.cross_sections);
+        }
+        double iso_conc = (need_concentration) ? buffers.concentrations[it_isotope->second] : 0.0;
+        if (!is_scattering) {
+            get_xs(this->n_groups, output_index, address_xs, flat_result, kernel, buffers.cross_sections,
+                   buffers.zoneflux, iso_conc);
+            continue;
+        }
+        // get cross section of each transfer group pair inside the band
+        for (std::uint64_t departure = 0; departure < this->n_groups; departure++) {
+            int first_arrival = std::max(trans_fag[departure], 0);
+            int last_arrival = trans_fag[departure] + trans_adr[departure + 1] - trans_adr[departure];
+            last_arrival = std::min(last_arrival, static_cast<int>(this->n_groups));
+            for (int arrival = first_arrival; arrival < last_arrival; arrival++) {
+                std::int64_t adr_xs = address_xs + trans_adr[departure] + arrival - trans_fag[departure];
+                get_xs(1, output_index, adr_xs, flat_result, kernel, buffers.cross_sections, buffers.zoneflux, iso_conc,
+                       departure * this->n_groups + arrival);
+            }
+        }
+    }
+    return NdArray(arena, 0, shape);
 }
 
 // String representation
@@ -449,27 +1181,31 @@ std::string SingleMpo::str(void) const {
     return os.str();
 }
 
-// Close file and flush memory
+// Release the file to the pool of open files
 void SingleMpo::close(void) {
-    delete this->output_;
+    auto h5_lock = lock_h5();
     this->output_ = nullptr;
-    delete this->file_;
     this->file_ = nullptr;
+    H5Pool::get_instance().release(this->handle_);
 }
 
-// Reopen file
+// Acquire the file from the pool of open files
 void SingleMpo::reopen(void) {
-    this->file_ = new H5::H5File(this->fname_.c_str(), H5F_ACC_RDONLY);
-    this->output_ = new H5::Group(this->file_->openGroup(this->output_name_.c_str()));
+    IoScope io_scope(this->io_counters_.get());
+    auto h5_lock = lock_h5();
+    this->handle_ = H5Pool::get_instance().acquire(this->fname_);
+    this->file_ = &(this->handle_->file);
+    this->output_ = H5Pool::get_instance().open_group(*(this->handle_), this->output_name_);
+    // discard index if the file has been modified
+    if (this->index_.built() && !this->index_.is_valid_for(this->fname_)) {
+        this->index_ = MpoIndex();
+    }
 }
 
 // Default destructor
 SingleMpo::~SingleMpo(void) {
-    if (this->output_ != nullptr) {
-        delete this->output_;
-    }
-    if (this->file_ != nullptr) {
-        delete this->file_;
+    if (this->handle_ != nullptr) {
+        this->close();
     }
 }
 
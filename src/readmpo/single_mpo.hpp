@@ -4,6 +4,8 @@
 
 #include <fstream>        // std::istream, std::ofstream, std::ostream
 #include <map>            // std::map
+#include <memory>         // std::make_unique, std::shared_ptr, std::unique_ptr
+#include <mutex>          // std::mutex, std::once_flag
 #include <set>            // std::set
 #include <string>         // std::string
 #include <tuple>          // std::tuple
@@ -13,7 +15,12 @@
 
 #include <H5Cpp.h>  // H5::H5File, H5::Group
 
-#include "readmpo/nd_array.hpp"  // readmpo::NdArray
+#include "readmpo/flat_lib.hpp"    // readmpo::FlatLib, readmpo::LibKey
+#include "readmpo/h5_pool.hpp"     // readmpo::H5Handle
+#include "readmpo/mpo_index.hpp"   // readmpo::MpoIndex
+#include "readmpo/nd_array.hpp"    // readmpo::NdArray, readmpo::allocate_arena
+#include "readmpo/profile.hpp"     // readmpo::IoCounters
+#include "readmpo/stream_lib.hpp"  // readmpo::StreamLib
 
 /** @brief Hash a pair of integers.*/
 template <>
@@ -42,9 +49,184 @@ enum class XsType : unsigned int {
     ReactRate = 3
 };
 
+/** @brief Request of cross sections to retrieve from MPO files.*/
+struct XsRequest {
+    /** @brief List of isotopes.*/
+    std::vector<std::string> isotopes;
+    /** @brief List of reactions.*/
+    std::vector<std::string> reactions;
+    /** @brief List of lowercased skipped dimensions.*/
+    std::vector<std::string> skipped_dims;
+    /** @brief Type of cross section.*/
+    XsType type = XsType::Micro;
+    /** @brief Max anisotropy order to retrieve.*/
+    std::uint64_t max_anisop_order = 1;
+    /** @brief Expand Scattering to one output per transfer group pair instead of one block-sparse output per
+     *  anisotropy order.
+     */
+    bool expand_scattering = false;
+};
+
 /** @brief Valid set for Diffusion and Scattering.*/
 using ValidSet = std::tuple<std::uint64_t, std::uint64_t, std::unordered_set<std::pair<std::uint64_t, std::uint64_t>>>;
 
+/** @brief Band structure of the Scattering transfer matrix of an isotope.
+ *  @details As in ``TRANSPROFILE``, arrival groups of each departure group form a contiguous band starting at its first
+ *  arrival group, and bands of all departure groups are stored one after another. Scattering at an anisotropy order is
+ *  stored in a single block-sparse array, whose first dimension is the position in the band instead of the group.
+ */
+class ScatteringBand {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Default constructor.*/
+    ScatteringBand(void) = default;
+    /** @brief Constructor from the valid set of an isotope.
+     *  @details The band of each departure group encloses all of its arrival groups in the valid set.
+     *  @param valid_set Valid set of the isotope.
+     *  @param n_groups Number of groups in the energy mesh.
+     */
+    ScatteringBand(const ValidSet & valid_set, std::uint64_t n_groups);
+    /** @brief Constructor from a profile array.
+     *  @details The profile array contains the first arrival group of each departure group, followed by the offset of
+     *  the band of each departure group and the total size of the band.
+     */
+    ScatteringBand(const NdArray & profile);
+    /// @}
+
+    /// @name Attributes
+    /// @{
+    /** @brief Get number of groups.*/
+    std::uint64_t n_groups(void) const noexcept { return this->first_arrival_.size(); }
+    /** @brief Get total number of transfer group pairs in the band.*/
+    std::uint64_t size(void) const noexcept { return this->offset_.back(); }
+    /** @brief Get first arrival group of each departure group.*/
+    const std::vector<std::uint64_t> & first_arrival(void) const noexcept { return this->first_arrival_; }
+    /** @brief Get offset of the band of each departure group.*/
+    const std::vector<std::uint64_t> & offset(void) const noexcept { return this->offset_; }
+    /// @}
+
+    /// @name Element access
+    /// @{
+    /** @brief Check if a transfer group pair is inside the band.*/
+    bool contains(std::uint64_t departure, std::uint64_t arrival) const noexcept;
+    /** @brief Get position of a transfer group pair inside the band.*/
+    std::uint64_t index(std::uint64_t departure, std::uint64_t arrival) const noexcept {
+        return this->offset_[departure] + arrival - this->first_arrival_[departure];
+    }
+    /** @brief Get an element of a block-sparse Scattering array (``0`` outside of the band).
+     *  @param band_array Block-sparse Scattering array.
+     *  @param departure Departure group.
+     *  @param arrival Arrival group.
+     *  @param index Index of the element in the remaining dimensions (zone and parameters).
+     */
+    double get(const NdArray & band_array, std::uint64_t departure, std::uint64_t arrival,
+               const std::vector<std::uint64_t> & index) const;
+    /** @brief Expand a block-sparse Scattering array to the array of a transfer group pair.
+     *  @details The result has the same shape as the per-pair output, with ``1`` as first dimension.
+     */
+    NdArray expand(const NdArray & band_array, std::uint64_t departure, std::uint64_t arrival) const;
+    /// @}
+
+    /// @name Conversion
+    /// @{
+    /** @brief Get profile array.*/
+    NdArray profile(void) const;
+    /// @}
+
+  protected:
+    /** @brief First arrival group of each departure group.*/
+    std::vector<std::uint64_t> first_arrival_;
+    /** @brief Offset of the band of each departure group, followed by the size of the band.*/
+    std::vector<std::uint64_t> offset_ = {0};
+};
+
+/** @brief Diffusion and Scattering outputs of an isotope whose valid set is discovered during the extraction.
+ *  @details Outputs are allocated in their own arena at their first write, and shared with the library once all MPO
+ *  files are read.
+ */
+class DiscoveryLib {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Default constructor.*/
+    DiscoveryLib(void) = default;
+    /** @brief Constructor from the shape of the output and the max anisotropy order to retrieve.
+     *  @param shape Shape of Diffusion output (the first dimension is the number of groups).
+     *  @param max_anisop_order Max anisotropy order to retrieve.
+     */
+    DiscoveryLib(const std::vector<std::uint64_t> & shape, std::uint64_t max_anisop_order);
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    DiscoveryLib(const DiscoveryLib & src) = delete;
+    /** @brief Copy assignment.*/
+    DiscoveryLib & operator=(const DiscoveryLib & src) = delete;
+    /// @}
+
+    /// @name Get output
+    /// @{
+    /** @brief Get output of Diffusion at an anisotropy order.*/
+    NdArray & diffusion(std::uint64_t anisop);
+    /** @brief Get output of Scattering at an anisotropy order from a departure group to an arrival group.*/
+    NdArray & scattering(std::uint64_t anisop, std::uint64_t departure, std::uint64_t arrival);
+    /// @}
+
+    /// @name Valid set
+    /// @{
+    /** @brief Merge the valid set of the isotope in a zone.*/
+    void merge(const ValidSet & zone_valid_set);
+    /** @brief Get discovered valid set.*/
+    const ValidSet & valid_set(void) const noexcept { return this->valid_set_; }
+    /// @}
+
+    /// @name Finalize
+    /// @{
+    /** @brief Insert outputs of a reaction to the library.
+     *  @details Outputs are keyed as in the case where the valid set is known before the extraction. Outputs inside
+     *  the valid set that have never been written are allocated as zero-filled arrays.
+     *  @param isotope_id Interned ID of the isotope in the library.
+     *  @param reaction Name of the reaction.
+     *  @param flat_lib Library to insert outputs to.
+     *  @param expand_scattering If ``false``, Scattering outputs of each anisotropy order are gathered into a
+     *  block-sparse array.
+     */
+    void finalize(std::uint32_t isotope_id, const std::string & reaction, FlatLib & flat_lib,
+                  bool expand_scattering = false);
+    /// @}
+
+  protected:
+    /** @brief Shape of Diffusion output.*/
+    std::vector<std::uint64_t> shape_;
+    /** @brief Max anisotropy order to retrieve.*/
+    std::uint64_t max_anisop_order_ = 0;
+    /** @brief Outputs of Diffusion and Scattering.*/
+    std::vector<NdArray> outputs_;
+    /** @brief Flags ensuring that each output is allocated once.*/
+    std::unique_ptr<std::once_flag[]> allocated_;
+    /** @brief Discovered valid set.*/
+    ValidSet valid_set_;
+    /** @brief Mutex protecting the valid set.*/
+    std::mutex mutex_;
+
+    /** @brief Get output at a given index, allocate it at the first call.*/
+    NdArray & get_output(std::uint64_t index, const std::vector<std::uint64_t> & shape);
+};
+
+/** @brief Outputs of a request of cross sections.*/
+struct XsTarget {
+    /** @brief Request of cross sections.*/
+    const XsRequest * request = nullptr;
+    /** @brief Index of skipped dimensions in the master parameter space.*/
+    std::vector<std::uint64_t> global_skipped_dims;
+    /** @brief Library to write data to.*/
+    MpoLib * micro_lib = nullptr;
+    /** @brief Diffusion and Scattering outputs of isotopes whose valid set is discovered during the extraction.*/
+    std::map<std::string, DiscoveryLib> * discovery_lib = nullptr;
+};
+
 /** @brief Class representing a single output ID inside an MPO.*/
 class SingleMpo {
   public:
@@ -68,27 +250,42 @@ class SingleMpo {
     n_groups(src.n_groups),
     fname_(src.fname_),
     output_name_(src.output_name_),
+    fingerprint_(src.fingerprint_),
     map_global_idx_(std::move(src.map_global_idx_)),
     map_global_idim_(std::move(src.map_global_idim_)),
     map_local_idim_(std::move(src.map_local_idim_)),
     map_isotopes_(std::move(src.map_isotopes_)),
-    map_reactions_(std::move(src.map_reactions_)) {
+    map_reactions_(std::move(src.map_reactions_)),
+    index_(std::move(src.index_)),
+    io_counters_(std::exchange(src.io_counters_, std::make_unique<IoCounters>())) {
+        this->handle_ = std::move(src.handle_);
         this->file_ = std::exchange(src.file_, nullptr);
         this->output_ = std::exchange(src.output_, nullptr);
     }
     /** @brief Move assignment.*/
     SingleMpo & operator=(SingleMpo && src) {
+        if (this == &src) {
+            return *this;
+        }
+        // release the former file through the pool, which closes it under the HDF5 lock if it is the last user
+        if (this->handle_ != nullptr) {
+            this->close();
+        }
         this->n_zones = std::exchange(src.n_zones, 0);
         this->n_groups = std::exchange(src.n_groups, 0);
         this->fname_ = std::exchange(src.fname_, std::string());
+        this->handle_ = std::move(src.handle_);
         this->file_ = std::exchange(src.file_, nullptr);
         this->output_name_ = std::exchange(src.output_name_, std::string());
         this->output_ = std::exchange(src.output_, nullptr);
+        this->fingerprint_ = std::exchange(src.fingerprint_, std::pair<std::uint64_t, std::int64_t>());
         this->map_global_idx_ = std::exchange(src.map_global_idx_, std::vector<std::vector<std::uint64_t>>());
         this->map_global_idim_ = std::exchange(src.map_global_idim_, std::vector<std::uint64_t>());
         this->map_local_idim_ = std::exchange(src.map_local_idim_, std::vector<std::uint64_t>());
         this->map_isotopes_ = std::exchange(src.map_isotopes_, std::vector<std::map<std::string, std::uint64_t>>());
         this->map_reactions_ = std::exchange(src.map_reactions_, std::map<std::string, std::uint64_t>());
+        this->index_ = std::exchange(src.index_, MpoIndex());
+        this->io_counters_ = std::exchange(src.io_counters_, std::make_unique<IoCounters>());
         return *this;
     }
     /// @}
@@ -109,12 +306,55 @@ class SingleMpo {
     std::uint64_t n_zones;
     /** @brief Number of groups in the energy mesh.*/
     std::uint64_t n_groups;
+    /** @brief Get counters of I/O operations on the file and of allocations of its outputs.*/
+    IoCounters & io_counters(void) const noexcept { return *(this->io_counters_); }
     /// @}
 
     /// @name Global indexing
     /// @{
     /** @brief Construct map from local index to global index.*/
     void construct_global_idx_map(const std::map<std::string, std::vector<double>> & master_pspace);
+    /** @brief Get global index of each value of the file on a dimension of the master parameter space.*/
+    const std::vector<std::uint64_t> & global_idx(std::uint64_t global_idim) const {
+        return this->map_global_idx_[this->map_local_idim_[global_idim]];
+    }
+    /** @brief Update map from local index to global index after values are inserted to or removed from the master
+     *  parameter space, without reading the file.
+     *  @param new_global_idx New global index of each former global index, on each dimension of the master parameter
+     *  space.
+     */
+    void remap_global_idx(const std::vector<std::vector<std::uint64_t>> & new_global_idx);
+    /** @brief Get index of each state point in the output array, excluding group and zone dimensions.
+     *  @param global_skipped_dims Dimensions (0-base indexed) to ignore.
+     */
+    std::vector<std::vector<std::uint64_t>> get_output_idx(const std::vector<std::uint64_t> & global_skipped_dims);
+    /// @}
+
+    /// @name Structural index
+    /// @{
+    /** @brief Get structural index of the output.*/
+    const MpoIndex & index(void) const noexcept { return this->index_; }
+    /** @brief Load a structural index.
+     *  @details The index is ignored if the file has been modified since it was built.
+     *  @return ``true`` if the index is loaded.
+     */
+    bool load_index(MpoIndex && index);
+    /// @}
+
+    /// @name Serialization
+    /// @{
+    /** @brief Write metadata to an output stream.
+     *  @details Metadata are the name of the output, the number of zones and groups, the maps of isotopes and
+     *  reactions, the maps from local to global index, and the size and last modification time of the file when it
+     *  was opened by the constructor.
+     */
+    void serialize(std::ostream & os) const;
+    /** @brief Read metadata from an input stream without opening the file.
+     *  @details The file is opened at the next call to SingleMpo::reopen.
+     */
+    void deserialize(std::istream & is);
+    /** @brief Check if the file has not been modified since it was opened by the constructor.*/
+    bool is_up_to_date(void) const;
     /// @}
 
     /// @name Extra arguments for Diffusion and Scattering
@@ -132,22 +372,63 @@ class SingleMpo {
         dimension will be rewrite at index 0.
      *  @param global_valid_set Valid set for each isotope.
      *  @param micro_lib Microscopic library to write data to.
+     *  @param discovery_lib Diffusion and Scattering outputs of isotopes whose valid set is discovered during the
+     *  extraction. For these isotopes, only anisotropy orders and transfer group pairs present in each zone are read.
      *  @param type Type of cross section to retrieve.
      *  @param max_anisop_order Max anisotropy order to retrieve.
      *  @param logfile Log file to write process to.
+     *  @param n_threads Number of threads reading state points concurrently (``0`` means all available threads).
+     *  State points writing to the same index of the output are read by the same thread in their order in the file.
+     *  @param expand_scattering If ``true``, Scattering is written to one output per transfer group pair, otherwise
+     *  to one block-sparse output per anisotropy order (isotopes with known valid set only).
+     *  @param stream If not null, cross sections of each state point are written to a staging library and stored in
+     *  the streamed output instead of ``micro_lib`` (isotopes with known valid set only).
      */
     void get_microlib(const std::vector<std::string> & isotopes, const std::vector<std::string> & reactions,
                       const std::vector<std::uint64_t> & global_skipped_dims,
                       const std::map<std::string, ValidSet> & global_valid_set,
-                      std::map<std::string, std::map<std::string, NdArray>> & micro_lib, XsType type,
-                      std::uint64_t max_anisop_order, std::ofstream & logfile);
+                      std::map<std::string, std::map<std::string, NdArray>> & micro_lib,
+                      std::map<std::string, DiscoveryLib> & discovery_lib, XsType type,
+                      std::uint64_t max_anisop_order, std::ostream & logfile, std::uint64_t n_threads = 0,
+                      bool expand_scattering = false, StreamLib * stream = nullptr);
+    /** @brief Retrieve cross sections of several requests in a single pass over the state points and zones.
+     *  @details Each dataset of a zone is read once for all requests: ``CONCENTRATION`` and ``ZONEFLUX`` if any
+     *  request needs them, and the union of the ranges of ``CROSSECTION`` needed by each request.
+     *  @param targets Request and outputs of each request. Requests with an isotope or a reaction absent from the MPO
+     *  are skipped for this file.
+     *  @param global_valid_set Valid set for each isotope.
+     *  @param logfile Log file to write process to.
+     *  @param n_threads Number of threads reading state points concurrently (``0`` means all available threads).
+     *  State points writing to the same index of the output of any request are read by the same thread in their
+     *  order in the file.
+     *  @param stream If not null, cross sections of each state point are written to a staging library and stored in
+     *  the streamed output instead of the library of the request (single request only).
+     */
+    void get_microlib_batch(const std::vector<XsTarget> & targets,
+                            const std::map<std::string, ValidSet> & global_valid_set, std::ostream & logfile,
+                            std::uint64_t n_threads = 0, StreamLib * stream = nullptr);
     /** @brief Retrieve concentration from MPO.
      *  @param isotopes Isotope to get.
      *  @param burnup_i_dim Index of burnup axis.
      *  @param output Output array to write result to.
+     *  @param n_threads Number of threads reading state points concurrently (``0`` means all available threads).
      */
     void get_concentration(const std::vector<std::string> & isotopes, std::uint64_t burnup_i_dim,
-                           std::map<std::string, NdArray> & output);
+                           std::map<std::string, NdArray> & output, std::uint64_t n_threads = 0);
+    /** @brief Retrieve cross section of an isotope and a reaction in each zone of a single state point.
+     *  @details Only the datasets of the zones of the state point are read, and only the elements of the reaction
+     *  inside ``CROSSECTION``.
+     *  @param i_statept Index of the state point in the output (see SingleMpo::get_output_idx).
+     *  @param isotope Name of the isotope.
+     *  @param reaction Name of the reaction.
+     *  @param type Type of cross section to retrieve.
+     *  @param anisop Anisotropy order of Diffusion and Scattering.
+     *  @return Array of shape ``[n_groups, n_zones]``, or ``[n_groups, n_groups, n_zones]`` indexed by departure and
+     *  arrival group for Scattering. Entries of zones without the isotope, the reaction or the anisotropy order, and
+     *  transfer group pairs outside of the band of Scattering, are zero.
+     */
+    NdArray get_statept_xs(std::uint64_t i_statept, const std::string & isotope, const std::string & reaction,
+                           XsType type = XsType::Micro, std::uint64_t anisop = 0);
     /// @}
 
     /// @name Representation
@@ -158,9 +439,9 @@ class SingleMpo {
 
     /// @name Close and reopen
     /// @{
-    /** @brief Close file and flush memory.*/
+    /** @brief Release the file to the pool of open files, where it is kept open until evicted.*/
     void close(void);
-    /** @brief Reopen file.*/
+    /** @brief Acquire the file from the pool of open files, the file is opened if not in the pool.*/
     void reopen(void);
     /// @}
 
@@ -171,14 +452,31 @@ class SingleMpo {
     /// @}
 
   protected:
+    /** @brief Index state points of the output if not yet indexed.*/
+    void index_statepts(void);
+    /** @brief Get ``ADDRZX`` and ``ADDRZI`` of a zone of a state point, read from the file if not yet indexed.*/
+    std::pair<int, int> get_zone_addr(std::uint64_t i_statept, std::uint64_t i_zone);
+    /** @brief Get local index of each isotope in each zone type.
+     *  @details Element ``[addrzi][i]`` is the index of ``isotopes[i]`` in the zone type ``addrzi``, or ``-1`` if the
+     *  isotope is absent from it.
+     */
+    std::vector<std::vector<std::int64_t>> isotope_table(const std::vector<std::string> & isotopes) const;
+    /** @brief Get index of a state point in the output array from its local index in each dimension.*/
+    std::vector<std::uint64_t> local_to_output_idx(const std::vector<int> & local_idx,
+                                                   const std::vector<std::uint64_t> & global_skipped_dims);
+
     /** @brief Name of the file.*/
     std::string fname_;
+    /** @brief Handle of the file acquired from readmpo::H5Pool.*/
+    std::shared_ptr<H5Handle> handle_;
     /** @brief Pointer to H5 file.*/
     H5::H5File * file_ = nullptr;
     /** @brief Name of the output.*/
     std::string output_name_;
     /** @brief Pointer to the H5 group of ``output``.*/
     H5::Group * output_ = nullptr;
+    /** @brief Size and last modification time of the file when it was opened by the constructor.*/
+    std::pair<std::uint64_t, std::int64_t> fingerprint_;
 
     /** @brief Map from local index to global index.*/
     std::vector<std::vector<std::uint64_t>> map_global_idx_;
@@ -190,6 +488,11 @@ class SingleMpo {
     std::vector<std::map<std::string, std::uint64_t>> map_isotopes_;
     /** @brief Map from reaction name to its index.*/
     std::map<std::string, std::uint64_t> map_reactions_;
+
+    /** @brief Structural index of the output.*/
+    MpoIndex index_;
+    /** @brief Counters of I/O operations on the file.*/
+    std::unique_ptr<IoCounters> io_counters_ = std::make_unique<IoCounters>();
 };
 
 }  // namespace readmpo
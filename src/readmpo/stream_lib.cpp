@@ -0,0 +1,147 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/stream_lib.hpp"
+
+#include <algorithm>  // std::copy
+#include <set>        // std::set
+
+#include "readmpo/h5_utils.hpp"  // readmpo::lock_h5, readmpo::ndim_to_c_idx
+#include "readmpo/profile.hpp"   // readmpo::record_allocation
+
+namespace readmpo {
+
+// Create the output file with a dataset for each array registered in a flat library
+StreamLib::StreamLib(const std::string & fname, const FlatLib & flat_lib) : all_isotopes_(flat_lib.isotopes()) {
+    auto h5_lock = lock_h5();
+    // chunks are always written whole, so the raw data chunk cache is disabled
+    H5::FileAccPropList file_access;
+    file_access.setCache(0, 0, 0, 0.75);
+    this->file_ = H5::H5File(fname.c_str(), H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, file_access);
+    std::set<std::string> isotope_groups;
+    for (const auto & [key, shape] : flat_lib.shapes()) {
+        const std::string & isotope = flat_lib.isotopes()[key.isotope];
+        if (isotope_groups.insert(isotope).second) {
+            this->file_.createGroup(isotope.c_str());
+        }
+        // slice at a single position in the parameter space
+        std::vector<std::uint64_t> slice_shape(shape.size(), 1);
+        slice_shape[0] = shape[0];
+        slice_shape[1] = shape[1];
+        std::uint64_t slice_size = shape[0] * shape[1];
+        // create dataset chunked by slices
+        H5::DataSpace dspace(shape.size(), reinterpret_cast<const hsize_t *>(shape.data()));
+        H5::DSetCreatPropList dset_create;
+        if (slice_size != 0) {
+            dset_create.setChunk(slice_shape.size(), reinterpret_cast<const hsize_t *>(slice_shape.data()));
+        }
+        double fill_value = 0.0;
+        dset_create.setFillValue(H5::PredType::NATIVE_DOUBLE, &fill_value);
+        std::string output = flat_lib.output_name(key);
+        std::string dset_name = isotope + "/" + output;
+        this->dsets_.push_back(this->file_.createDataSet(dset_name.c_str(), H5::PredType::NATIVE_DOUBLE, dspace,
+                                                         dset_create));
+        this->isotopes_.push_back(isotope);
+        this->outputs_.push_back(output);
+        this->slice_shapes_.push_back(slice_shape);
+        this->staging_size_ += slice_size * sizeof(double);
+        this->pspace_shape_.assign(shape.begin() + 2, shape.end());
+    }
+    std::uint64_t n_positions = 1;
+    for (const std::uint64_t & s : this->pspace_shape_) {
+        n_positions *= s;
+    }
+    this->stored_.resize(n_positions, 0);
+}
+
+// Write an array independent of state points to the dataset
+void StreamLib::write(const std::string & isotope, const std::string & output, const NdArray & array) {
+    NdArray contiguous_array(array);
+    auto h5_lock = lock_h5();
+    if (!this->file_.nameExists(isotope.c_str())) {
+        this->file_.createGroup(isotope.c_str());
+    }
+    H5::DataSpace dspace(array.ndim(), reinterpret_cast<const hsize_t *>(array.shape().data()));
+    std::string dset_name = isotope + "/" + output;
+    H5::DataSet dset = this->file_.createDataSet(dset_name.c_str(), H5::PredType::NATIVE_DOUBLE, dspace);
+    if (array.size() != 0) {
+        dset.write(contiguous_array.data(), H5::PredType::NATIVE_DOUBLE);
+    }
+    dset.close();
+}
+
+// Create a zero-filled staging library holding the slice of each array at a single state point
+MpoLib StreamLib::staging(void) const {
+    MpoLib stage;
+    for (const std::string & isotope : this->all_isotopes_) {
+        stage[isotope];
+    }
+    for (std::uint64_t i_dset = 0; i_dset < this->dsets_.size(); i_dset++) {
+        NdArray & slice = stage[this->isotopes_[i_dset]][this->outputs_[i_dset]];
+        slice = NdArray(this->slice_shapes_[i_dset]);
+        record_allocation(slice.size() * sizeof(double));
+    }
+    return stage;
+}
+
+// Read or write the slice of each dataset at a position in the parameter space
+void StreamLib::transfer(const MpoLib & stage, const std::vector<std::uint64_t> & position, bool is_read) {
+    for (std::uint64_t i_dset = 0; i_dset < this->dsets_.size(); i_dset++) {
+        const NdArray & slice = stage.at(this->isotopes_[i_dset]).at(this->outputs_[i_dset]);
+        if (slice.size() == 0) {
+            continue;
+        }
+        const std::vector<std::uint64_t> & slice_shape = this->slice_shapes_[i_dset];
+        std::vector<std::uint64_t> start(slice_shape.size(), 0);
+        std::copy(position.begin(), position.end(), start.begin() + 2);
+        H5::DataSpace file_space = this->dsets_[i_dset].getSpace();
+        file_space.selectHyperslab(H5S_SELECT_SET, reinterpret_cast<const hsize_t *>(slice_shape.data()),
+                                   reinterpret_cast<const hsize_t *>(start.data()));
+        H5::DataSpace memory_space(slice_shape.size(), reinterpret_cast<const hsize_t *>(slice_shape.data()));
+        double * data = const_cast<double *>(slice.data());
+        if (is_read) {
+            this->dsets_[i_dset].read(data, H5::PredType::NATIVE_DOUBLE, memory_space, file_space);
+        } else {
+            this->dsets_[i_dset].write(data, H5::PredType::NATIVE_DOUBLE, memory_space, file_space);
+        }
+    }
+}
+
+// Load the slices of a staging library at a position in the parameter space
+void StreamLib::load(MpoLib & stage, const std::vector<std::uint64_t> & position) {
+    if (this->dsets_.empty()) {
+        return;
+    }
+    if (this->stored_[ndim_to_c_idx(position, this->pspace_shape_)] != 0) {
+        auto h5_lock = lock_h5();
+        this->transfer(stage, position, true);
+        return;
+    }
+    for (auto & [isotope, iso_stage] : stage) {
+        for (auto & [output, slice] : iso_stage) {
+            for (std::uint64_t i = 0; i < slice.size(); i++) {
+                slice[i] = 0.0;
+            }
+        }
+    }
+}
+
+// Store the slices of a staging library at a position in the parameter space
+void StreamLib::store(const MpoLib & stage, const std::vector<std::uint64_t> & position) {
+    if (this->dsets_.empty()) {
+        return;
+    }
+    auto h5_lock = lock_h5();
+    this->transfer(stage, position, false);
+    this->stored_[ndim_to_c_idx(position, this->pspace_shape_)] = 1;
+}
+
+// Flush and close the output file
+void StreamLib::close(void) {
+    auto h5_lock = lock_h5();
+    for (H5::DataSet & dset : this->dsets_) {
+        dset.close();
+    }
+    this->dsets_.clear();
+    this->file_.close();
+}
+
+}  // namespace readmpo
@@ -0,0 +1,100 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_STREAM_LIB_HPP_
+#define READMPO_STREAM_LIB_HPP_
+
+#include <cstdint>  // std::uint8_t, std::uint64_t
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include <H5Cpp.h>  // H5::DataSet, H5::H5File
+
+#include "readmpo/flat_lib.hpp"  // readmpo::FlatLib, readmpo::MpoLib
+#include "readmpo/nd_array.hpp"  // readmpo::NdArray
+
+namespace readmpo {
+
+/** @brief Library whose arrays are written to an HDF5 file one state point at a time.
+ *  @details Each array of shape ``[n, zones, parameters...]`` is saved to the dataset ``/<isotope>/<output>``, chunked
+ *  by slices ``[n, zones, 1, ...]`` holding a single position in the parameter space. Cross sections of a state point
+ *  are gathered in a staging library of such slices, then written to the file as whole chunks. Only staging libraries
+ *  are resident in memory, so the memory footprint does not depend on the size of the parameter space.
+ */
+class StreamLib {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Default constructor.*/
+    StreamLib(void) = default;
+    /** @brief Create the output file with a dataset for each array registered in a flat library.
+     *  @param fname Name of the output HDF5 file.
+     *  @param flat_lib Library with registered (not yet allocated) arrays.
+     */
+    StreamLib(const std::string & fname, const FlatLib & flat_lib);
+    /// @}
+
+    /// @name Copy and move
+    /// @{
+    /** @brief Copy constructor.*/
+    StreamLib(const StreamLib & src) = delete;
+    /** @brief Copy assignment.*/
+    StreamLib & operator=(const StreamLib & src) = delete;
+    /** @brief Move constructor.*/
+    StreamLib(StreamLib && src) = default;
+    /** @brief Move assignment.*/
+    StreamLib & operator=(StreamLib && src) = default;
+    /// @}
+
+    /// @name Attributes
+    /// @{
+    /** @brief Get number of bytes of a staging library.*/
+    std::uint64_t staging_size(void) const noexcept { return this->staging_size_; }
+    /// @}
+
+    /// @name Write
+    /// @{
+    /** @brief Write an array independent of state points to the dataset ``/<isotope>/<output>``.*/
+    void write(const std::string & isotope, const std::string & output, const NdArray & array);
+    /** @brief Create a zero-filled staging library holding the slice of each array at a single state point.*/
+    MpoLib staging(void) const;
+    /** @brief Load the slices of a staging library at a position in the parameter space.
+     *  @details Slices are read back from the file if the position has already been stored, so that later state
+     *  points writing to the same position only overwrite the entries they contain. Otherwise, they are set to zero.
+     */
+    void load(MpoLib & stage, const std::vector<std::uint64_t> & position);
+    /** @brief Store the slices of a staging library at a position in the parameter space.*/
+    void store(const MpoLib & stage, const std::vector<std::uint64_t> & position);
+    /// @}
+
+    /// @name Close
+    /// @{
+    /** @brief Flush and close the output file.*/
+    void close(void);
+    /// @}
+
+  protected:
+    /** @brief Output file.*/
+    H5::H5File file_;
+    /** @brief Isotope of each dataset.*/
+    std::vector<std::string> isotopes_;
+    /** @brief Output name of each dataset.*/
+    std::vector<std::string> outputs_;
+    /** @brief Datasets.*/
+    std::vector<H5::DataSet> dsets_;
+    /** @brief Shape of the slice of each dataset at a single state point.*/
+    std::vector<std::vector<std::uint64_t>> slice_shapes_;
+    /** @brief Interned isotopes (all present in staging libraries).*/
+    std::vector<std::string> all_isotopes_;
+    /** @brief Shape of the parameter space.*/
+    std::vector<std::uint64_t> pspace_shape_;
+    /** @brief Flag indicating if each position in the parameter space has been stored.*/
+    std::vector<std::uint8_t> stored_;
+    /** @brief Number of bytes of a staging library.*/
+    std::uint64_t staging_size_ = 0;
+
+    /** @brief Read or write the slice of each dataset at a position in the parameter space.*/
+    void transfer(const MpoLib & stage, const std::vector<std::uint64_t> & position, bool is_read);
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_STREAM_LIB_HPP_
@@ -0,0 +1,69 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/xs_cache.hpp"
+
+#include <iterator>  // std::prev
+#include <mutex>     // std::lock_guard
+#include <utility>   // std::move
+
+namespace readmpo {
+
+// Get max number of entries
+std::uint64_t XsCache::capacity(void) const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->capacity_;
+}
+
+// Get number of entries
+std::uint64_t XsCache::size(void) const {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->lru_list_.size();
+}
+
+// Set max number of entries
+void XsCache::set_capacity(std::uint64_t capacity) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->capacity_ = capacity;
+    this->evict();
+}
+
+// Find an entry and mark it as most recently used
+NdArray XsCache::find(const XsKey & key) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    auto it = this->entries_.find(key);
+    if (it == this->entries_.end()) {
+        return NdArray();
+    }
+    this->lru_list_.splice(this->lru_list_.begin(), this->lru_list_, it->second);
+    return it->second->second.view();
+}
+
+// Insert an entry as most recently used
+void XsCache::insert(const XsKey & key, NdArray && xs) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    auto it = this->entries_.find(key);
+    if (it != this->entries_.end()) {
+        this->lru_list_.erase(it->second);
+        this->entries_.erase(it);
+    }
+    this->lru_list_.emplace_front(key, std::move(xs));
+    this->entries_[key] = this->lru_list_.begin();
+    this->evict();
+}
+
+// Remove all entries
+void XsCache::clear(void) {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->lru_list_.clear();
+    this->entries_.clear();
+}
+
+// Evict least recently used entries beyond the capacity
+void XsCache::evict(void) {
+    while (this->lru_list_.size() > this->capacity_) {
+        auto it = std::prev(this->lru_list_.end());
+        this->entries_.erase(it->first);
+        this->lru_list_.erase(it);
+    }
+}
+
+}  // namespace readmpo
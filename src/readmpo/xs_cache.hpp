@@ -0,0 +1,87 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_XS_CACHE_HPP_
+#define READMPO_XS_CACHE_HPP_
+
+#include <compare>  // std::strong_ordering
+#include <cstdint>  // std::uint64_t
+#include <list>     // std::list
+#include <map>      // std::map
+#include <string>   // std::string
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+#include "readmpo/h5_utils.hpp"    // readmpo::MovableMutex
+#include "readmpo/nd_array.hpp"    // readmpo::NdArray
+#include "readmpo/single_mpo.hpp"  // readmpo::XsType
+
+namespace readmpo {
+
+/** @brief Key of the cross section of an isotope and a reaction at a state point of the master parameter space.*/
+struct XsKey {
+    /** @brief Index of the state point on each dimension of the master parameter space.*/
+    std::vector<std::uint64_t> index;
+    /** @brief Name of the isotope.*/
+    std::string isotope;
+    /** @brief Name of the reaction.*/
+    std::string reaction;
+    /** @brief Type of cross section.*/
+    XsType type;
+    /** @brief Anisotropy order.*/
+    std::uint64_t anisop;
+
+    /** @brief Lexicographical comparison.*/
+    auto operator<=>(const XsKey & other) const = default;
+};
+
+/** @brief Cache of cross sections at state points, evicting least recently used entries.
+ *  @details Successive point queries at close parameter values share most of their neighboring state points, which
+ *  are then read only once. All members are guarded by a mutex, so that the cache can be shared by threads.
+ */
+class XsCache {
+  public:
+    /// @name Constructor
+    /// @{
+    /** @brief Constructor from the max number of entries.*/
+    XsCache(std::uint64_t capacity = 256) : capacity_(capacity) {}
+    /// @}
+
+    /// @name Attributes
+    /// @{
+    /** @brief Get max number of entries.*/
+    std::uint64_t capacity(void) const;
+    /** @brief Set max number of entries, least recently used entries are evicted if there are more.*/
+    void set_capacity(std::uint64_t capacity);
+    /** @brief Get number of entries.*/
+    std::uint64_t size(void) const;
+    /// @}
+
+    /// @name Access
+    /// @{
+    /** @brief Find an entry and mark it as most recently used.
+     *  @return View of the cached array, which stays valid after the entry is evicted, or an empty array if the key
+     *  is not cached.
+     */
+    NdArray find(const XsKey & key);
+    /** @brief Insert an entry as most recently used, and evict least recently used entries beyond the capacity.*/
+    void insert(const XsKey & key, NdArray && xs);
+    /** @brief Remove all entries.*/
+    void clear(void);
+    /// @}
+
+  protected:
+    /** @brief Entries sorted from the most recently used to the least recently used.*/
+    std::list<std::pair<XsKey, NdArray>> lru_list_;
+    /** @brief Position of each entry in the list.*/
+    std::map<XsKey, std::list<std::pair<XsKey, NdArray>>::iterator> entries_;
+    /** @brief Max number of entries.*/
+    std::uint64_t capacity_;
+    /** @brief Mutex guarding the entries and the capacity.*/
+    mutable MovableMutex mutex_;
+
+    /** @brief Evict least recently used entries beyond the capacity.*/
+    void evict(void);
+};
+
+}  // namespace readmpo
+
+#endif  // READMPO_XS_CACHE_HPP_
@@ -0,0 +1,36 @@
+// Copyright 2024 quocdang1998
+#include "readmpo/xs_kernel.hpp"
+
+#include <stdexcept>  // std::invalid_argument
+
+namespace readmpo {
+
+// Select the instance of the kernel for a type of quantity and an overwrite policy
+template <OverwritePolicy policy>
+static XsKernel select_xs_kernel_policy(XsType type) {
+    switch (type) {
+        case XsType::Micro : {
+            return &xs_kernel<XsType::Micro, policy>;
+        }
+        case XsType::Macro : {
+            return &xs_kernel<XsType::Macro, policy>;
+        }
+        case XsType::Flux : {
+            return &xs_kernel<XsType::Flux, policy>;
+        }
+        case XsType::ReactRate : {
+            return &xs_kernel<XsType::ReactRate, policy>;
+        }
+    }
+    throw std::invalid_argument("Unknown type of cross section.\n");
+}
+
+// Select the instance of the kernel for a type of quantity and an overwrite policy
+XsKernel select_xs_kernel(XsType type, OverwritePolicy policy) {
+    if (policy == OverwritePolicy::Warn) {
+        return select_xs_kernel_policy<OverwritePolicy::Warn>(type);
+    }
+    return select_xs_kernel_policy<OverwritePolicy::Ignore>(type);
+}
+
+}  // namespace readmpo
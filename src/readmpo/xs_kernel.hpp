@@ -0,0 +1,52 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_XS_KERNEL_HPP_
+#define READMPO_XS_KERNEL_HPP_
+
+#include <cstdint>  // std::int64_t, std::uint64_t
+
+#include "readmpo/single_mpo.hpp"  // readmpo::XsType
+
+namespace readmpo {
+
+/** @brief Policy for elements of the output already set before being written.*/
+enum class OverwritePolicy : unsigned int {
+    /** @brief Overwrite silently.*/
+    Ignore = 0,
+    /** @brief Count overwritten elements, so that the caller can report them.*/
+    Warn = 1
+};
+
+/** @brief Write a physical quantity of consecutive energy groups to a strided output.
+ *  @details Cross sections and zone flux are saved as single precision in MPO files. They are converted to double,
+ *  scaled by the concentration and the zone flux depending on the type of quantity, then stored to each ``stride``
+ *  element of the output. The loop has no branch, so that it can be vectorized by the compiler.
+ *  @param n_groups Number of energy groups to write.
+ *  @param cross_sections Buffer of ``CROSSECTION`` (unused if ``type`` is readmpo::XsType::Flux).
+ *  @param address_xs Index of the first group in ``cross_sections``.
+ *  @param zoneflux Buffer of ``ZONEFLUX`` (used only if ``type`` is readmpo::XsType::Flux or
+ *  readmpo::XsType::ReactRate).
+ *  @param iso_conc Concentration of the isotope (used only if ``type`` is readmpo::XsType::Macro or
+ *  readmpo::XsType::ReactRate).
+ *  @param output Pointer to the output element of the first group.
+ *  @param stride Number of elements between the outputs of 2 consecutive groups.
+ *  @return Number of elements of the output that were not zero before being written (always zero if ``policy`` is
+ *  readmpo::OverwritePolicy::Ignore).
+ */
+template <XsType type, OverwritePolicy policy>
+std::uint64_t xs_kernel(std::uint64_t n_groups, const float * cross_sections, std::int64_t address_xs,
+                        const float * zoneflux, double iso_conc, double * output, std::uint64_t stride);
+
+/** @brief Pointer to an instance of readmpo::xs_kernel.*/
+using XsKernel = std::uint64_t (*)(std::uint64_t, const float *, std::int64_t, const float *, double, double *,
+                                   std::uint64_t);
+
+/** @brief Select the instance of readmpo::xs_kernel for a type of quantity and an overwrite policy.
+ *  @details The selection is done once per request, so that no branch on the type is evaluated per group.
+ */
+XsKernel select_xs_kernel(XsType type, OverwritePolicy policy);
+
+}  // namespace readmpo
+
+#include "readmpo/xs_kernel.tpp"
+
+#endif  // READMPO_XS_KERNEL_HPP_
@@ -0,0 +1,46 @@
+// Copyright 2024 quocdang1998
+#ifndef READMPO_XS_KERNEL_TPP_
+#define READMPO_XS_KERNEL_TPP_
+
+namespace readmpo {
+
+// Write a physical quantity of consecutive energy groups to a strided output
+template <XsType type, OverwritePolicy policy>
+std::uint64_t xs_kernel(std::uint64_t n_groups, const float * cross_sections, std::int64_t address_xs,
+                        const float * zoneflux, double iso_conc, double * output, std::uint64_t stride) {
+    // count elements already set (a reduction kept out of the write loop)
+    std::uint64_t n_overwritten = 0;
+    if constexpr (policy == OverwritePolicy::Warn) {
+        for (std::uint64_t i_group = 0; i_group < n_groups; i_group++) {
+            n_overwritten += (output[i_group * stride] != 0.0) ? 1 : 0;
+        }
+    }
+    // convert, scale and store
+    if constexpr (type == XsType::Micro) {
+        const float * __restrict xs = cross_sections + address_xs;
+        for (std::uint64_t i_group = 0; i_group < n_groups; i_group++) {
+            output[i_group * stride] = static_cast<double>(xs[i_group]);
+        }
+    } else if constexpr (type == XsType::Macro) {
+        const float * __restrict xs = cross_sections + address_xs;
+        for (std::uint64_t i_group = 0; i_group < n_groups; i_group++) {
+            output[i_group * stride] = iso_conc * static_cast<double>(xs[i_group]);
+        }
+    } else if constexpr (type == XsType::Flux) {
+        const float * __restrict flux = zoneflux;
+        for (std::uint64_t i_group = 0; i_group < n_groups; i_group++) {
+            output[i_group * stride] = static_cast<double>(flux[i_group]);
+        }
+    } else {
+        const float * __restrict xs = cross_sections + address_xs;
+        const float * __restrict flux = zoneflux;
+        for (std::uint64_t i_group = 0; i_group < n_groups; i_group++) {
+            output[i_group * stride] = static_cast<double>(flux[i_group]) * iso_conc * static_cast<double>(xs[i_group]);
+        }
+    }
+    return n_overwritten;
+}
+
+}  // namespace readmpo
+
+#endif  // READMPO_XS_KERNEL_TPP_